@@ -24,6 +24,7 @@
  *               in order that the library may die gracefully.
  */
 #include <ctype.h>
+#include <errno.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,9 +38,10 @@
 #include "gdk.h"
 #include "gdkprivate.h"
 
-#ifndef X_GETTIMEOFDAY
-#define X_GETTIMEOFDAY(tv)  gettimeofday (tv, NULL)
-#endif /* X_GETTIMEOFDAY */
+#ifdef __linux__
+#define HAVE_EPOLL 1
+#include <sys/epoll.h>
+#endif /* __linux__ */
 
 #define TOKEN_LEFT_PAREN       1
 #define TOKEN_RIGHT_PAREN      2
@@ -66,7 +68,12 @@
 
 #define RETSIGTYPE void
 
-typedef struct _GdkInput GdkInput;
+#define EPOLL_MAX_EVENTS       64
+
+typedef struct _GdkInput         GdkInput;
+typedef struct _GdkInputFd       GdkInputFd;
+typedef struct _GdkEventBackend  GdkEventBackend;
+
 struct _GdkInput {
   gint tag;
   gint source;
@@ -75,10 +82,51 @@ struct _GdkInput {
   gpointer data;
 };
 
+/* Every file descriptor which has inputs registered on it
+ *  gets one of these. "condition" is the union of the
+ *  conditions of all the inputs on the descriptor and is
+ *  what the wait backend has been told to watch for.
+ */
+struct _GdkInputFd {
+  GList *inputs;
+  GdkInputCondition condition;
+  gint registered;
+};
+
+/* A wait backend. "update" is called whenever the inputs
+ *  registered on a file descriptor change so that the backend
+ *  may keep its registrations across calls to "wait". "wait"
+ *  blocks for at most "timeout" (or indefinately if it is NULL),
+ *  dispatches the inputs which became ready and returns the
+ *  number of ready descriptors. "x_ready" is set when the
+ *  connection to the X server is readable.
+ */
+struct _GdkEventBackend {
+  gchar *name;
+  gint (*init)   (void);
+  void (*update) (gint source);
+  gint (*wait)   (struct timeval *timeout,
+		  gint           *x_ready);
+};
+
 /* Private function declarations
  */
 static gint gdk_event_wait (void);
+static void gdk_event_backend_init (void);
+static void gdk_input_dispatch (gint source, GdkInputCondition condition);
+static void gdk_input_fd_update (gint source);
+static gint gdk_select_init (void);
+static void gdk_select_update (gint source);
+static gint gdk_select_wait (struct timeval *timeout, gint *x_ready);
+#ifdef HAVE_EPOLL
+static gint gdk_epoll_init (void);
+static void gdk_epoll_update (gint source);
+static gint gdk_epoll_wait (struct timeval *timeout, gint *x_ready);
+#endif /* HAVE_EPOLL */
 static void gdk_synthesize_click (GdkEvent *event, gint nclicks);
+static gint gdk_event_expose (GdkEvent *event, GdkWindow *window,
+			      gint x, gint y, gint width, gint height,
+			      gint count);
 static void gdk_event_record (Display *display, XEvent *event);
 
 static void gdk_event_display (char *str, XEvent *event);
@@ -106,6 +154,7 @@ static gint gdk_event_playback_parse_state (XEvent *event);
 static gint gdk_event_playback_parse_keycode (XEvent *event);
 static gint gdk_event_playback_parse_button (XEvent *event);
 static gint gdk_event_playback_parse_is_hint (XEvent *event);
+static void gdk_event_playback_root_xy (XEvent *event);
 
 static void gdk_exit_func (void);
 static int  gdk_x_error (Display *display, XErrorEvent *error);
@@ -136,8 +185,9 @@ static GdkWindow *window_to_destroy = NULL;         /* If we previously received
 						     *  which received that event.
 						     */
 
-static struct timeval start;                        /* The time at which the library was
-						     *  last initialized.
+static guint64 start;                               /* The time at which the library was
+						     *  last initialized. (In nanoseconds
+						     *  from the monotonic clock).
 						     */
 
 static struct timeval timer;                        /* Timeout interval to use in the call
@@ -166,6 +216,52 @@ static GList *inputs;                               /* A list of the input file
 						     *  exception pending.
 						     */
 
+static GdkInputFd *input_fds = NULL;                /* The inputs indexed by file descriptor.
+						     *  This is what the wait backends use to
+						     *  go from a ready descriptor straight to
+						     *  the inputs interested in it.
+						     */
+static gint input_fds_size = 0;
+
+static GdkEventBackend *event_backend = NULL;       /* The backend used by "gdk_event_wait".
+						     */
+static gint use_select = FALSE;                     /* Force the "select" backend even when
+						     *  a better one is available.
+						     */
+
+static fd_set select_readfds;                       /* The descriptor sets for the "select"
+						     *  backend. These are kept up to date as
+						     *  inputs are added and removed and copied
+						     *  before each call to "select".
+						     */
+static fd_set select_writefds;
+static fd_set select_exceptfds;
+static gint select_max_fd = -1;
+
+#ifdef HAVE_EPOLL
+static int epoll_fd = -1;                           /* The epoll instance used by the "epoll"
+						     *  backend.
+						     */
+#endif /* HAVE_EPOLL */
+
+static GdkEventBackend select_backend =
+{
+  "select",
+  gdk_select_init,
+  gdk_select_update,
+  gdk_select_wait,
+};
+
+#ifdef HAVE_EPOLL
+static GdkEventBackend epoll_backend =
+{
+  "epoll",
+  gdk_epoll_init,
+  gdk_epoll_update,
+  gdk_epoll_wait,
+};
+#endif /* HAVE_EPOLL */
+
 static guint32 button_click_time[2];                /* The last 2 button click times. Used
 						     *  to determine if the latest button click
 						     *  is part of a double or triple click.
@@ -192,7 +288,7 @@ static GList *playback_events = NULL;
 static gint wait_for_send_event = FALSE;
 static gint have_send_event = FALSE;
 static gint wait_for_event = FALSE;
-static guint32 next_event_time;
+static guint64 next_event_time;
 static gchar token_str[128];
 static gint cur_token;
 static gint next_token;
@@ -228,7 +324,7 @@ gdk_init (int *argc, char ***argv) {
 
   g_function_enter ("gdk_init");
 
-  X_GETTIMEOFDAY (&start);
+  start = g_time_monotonic_ns ();
 
   gdk_progname = (*argv)[0];
   gdk_display_name = NULL;
@@ -295,9 +391,15 @@ gdk_init (int *argc, char ***argv) {
     } else if (strcmp ("-motion-events", (*argv)[i]) == 0) {
   	  (*argv)[i] = NULL;
   	  gdk_motion_events = TRUE;
+  	} else if (strcmp ("-motion-hints", (*argv)[i]) == 0) {
+  	  (*argv)[i] = NULL;
+  	  gdk_motion_hints = TRUE;
   	} else if (strcmp ("-sync", (*argv)[i]) == 0) {
       (*argv)[i] = NULL;
       synchronize = TRUE;
+    } else if (strcmp ("-select", (*argv)[i]) == 0) {
+      (*argv)[i] = NULL;
+      use_select = TRUE;
     }
     i += 1;
   }
@@ -338,6 +440,8 @@ gdk_init (int *argc, char ***argv) {
     XSynchronize (gdk_display, True);
   }
 
+  gdk_event_backend_init ();
+
   gdk_screen = DefaultScreen (gdk_display);
   gdk_root_window = RootWindow (gdk_display, gdk_screen);
 
@@ -405,6 +509,13 @@ void gdk_exit (int errorcode) {
     XCloseDisplay (gdk_display);
     initialized = 0;
 
+#ifdef HAVE_EPOLL
+    if (epoll_fd >= 0) {
+      close (epoll_fd);
+      epoll_fd = -1;
+    }
+#endif /* HAVE_EPOLL */
+
     if (record_fp) {
       fclose (record_fp);
     }
@@ -428,7 +539,11 @@ void gdk_exit (int errorcode) {
  * Arguments:
  *
  * Results:
- *   Returns the number of events on XLib's event queue.
+ *   Returns non-zero if there are events on XLib's event
+ *   queue or events which have been put back with
+ *   "gdk_event_put". "gdk_event_get" will not block while
+ *   this is non-zero. The put back events are only tested
+ *   for rather than counted, so the result is not a count.
  *
  * Side effects:
  *
@@ -436,6 +551,8 @@ void gdk_exit (int errorcode) {
  */
 
 gint gdk_events_pending() {
+  if (putback_events)
+    return TRUE;
   return XPending (gdk_display);
 }
 
@@ -467,6 +584,7 @@ gint gdk_event_get (GdkEvent *event) {
   GdkEvent *temp_event;
   GList *temp_list;
   XEvent xevent;
+  guint32 click_time;
   XComposeStatus compose;
   int charcount;
   char buf[16];
@@ -595,10 +713,20 @@ gint gdk_event_get (GdkEvent *event) {
 	      event->button.time = xevent.xbutton.time;
 	      event->button.x = xevent.xbutton.x;
 	      event->button.y = xevent.xbutton.y;
+	      event->button.x_root = xevent.xbutton.x_root;
+	      event->button.y_root = xevent.xbutton.y_root;
 	      event->button.state = (GdkModifierType) xevent.xbutton.state;
 	      event->button.button = xevent.xbutton.button;
 
-	      if ((event->button.time < (button_click_time[1] + TRIPLE_CLICK_TIME)) && (event->button.window == button_window[1]) && (event->button.button == button_number[1])) {
+	      /* Clicks are timed by the server time stamps, so that
+	       *  presses which queue up while the program is busy
+	       *  aren't taken for a double click. The time stamps are
+	       *  32 bits and wrap, so the difference is masked to 32
+	       *  bits (a guint32 may be wider).
+	       */
+	      click_time = xevent.xbutton.time;
+
+	      if ((((click_time - button_click_time[1]) & 0xffffffff) < TRIPLE_CLICK_TIME) && (event->button.window == button_window[1]) && (event->button.button == button_number[1])) {
 		    gdk_synthesize_click (event, 3);
 
     		  button_click_time[1] = 0;
@@ -607,18 +735,18 @@ gint gdk_event_get (GdkEvent *event) {
     		  button_window[0] = 0;
     		  button_number[1] = -1;
     		  button_number[0] = -1;
-    		} else if ((event->button.time < (button_click_time[0] + DOUBLE_CLICK_TIME)) && (event->button.window == button_window[0]) && (event->button.button == button_number[0])) {
+    		} else if ((((click_time - button_click_time[0]) & 0xffffffff) < DOUBLE_CLICK_TIME) && (event->button.window == button_window[0]) && (event->button.button == button_number[0])) {
 		      gdk_synthesize_click (event, 2);
 
     		  button_click_time[1] = button_click_time[0];
-    		  button_click_time[0] = event->button.time;
+    		  button_click_time[0] = click_time;
     		  button_window[1] = button_window[0];
     		  button_window[0] = event->button.window;
     		  button_number[1] = button_number[0];
     		  button_number[0] = event->button.button;
 		    } else {
     		  button_click_time[1] = 0;
-    		  button_click_time[0] = event->button.time;
+    		  button_click_time[0] = click_time;
     		  button_window[1] = NULL;
     		  button_window[0] = event->button.window;
     		  button_number[1] = -1;
@@ -639,6 +767,8 @@ gint gdk_event_get (GdkEvent *event) {
 	      event->button.time = xevent.xbutton.time;
 	      event->button.x = xevent.xbutton.x;
 	      event->button.y = xevent.xbutton.y;
+	      event->button.x_root = xevent.xbutton.x_root;
+	      event->button.y_root = xevent.xbutton.y_root;
 	      event->button.state = (GdkModifierType) xevent.xbutton.state;
 	      event->button.button = xevent.xbutton.button;
 
@@ -655,6 +785,8 @@ gint gdk_event_get (GdkEvent *event) {
 	      event->motion.time = xevent.xmotion.time;
 	      event->motion.x = xevent.xmotion.x;
 	      event->motion.y = xevent.xmotion.y;
+	      event->motion.x_root = xevent.xmotion.x_root;
+	      event->motion.y_root = xevent.xmotion.y_root;
 	      event->motion.state = (GdkModifierType) xevent.xmotion.state;
 	      event->motion.is_hint = xevent.xmotion.is_hint;
 
@@ -787,14 +919,10 @@ gint gdk_event_get (GdkEvent *event) {
 			     xevent.xexpose.x, xevent.xexpose.y,
 			     xevent.xexpose.width, xevent.xexpose.height);
 
-	      event->expose.type = GDK_EXPOSE;
-	      event->expose.window = window;
-	      event->expose.area.x = xevent.xexpose.x;
-	      event->expose.area.y = xevent.xexpose.y;
-	      event->expose.area.width = xevent.xexpose.width;
-	      event->expose.area.height = xevent.xexpose.height;
-
-	      return_val = !((GdkWindowPrivate*) window)->destroyed;
+	      return_val = gdk_event_expose (event, window,
+					     xevent.xexpose.x, xevent.xexpose.y,
+					     xevent.xexpose.width, xevent.xexpose.height,
+					     xevent.xexpose.count);
 	      break;
 
 	    case GraphicsExpose:
@@ -804,14 +932,10 @@ gint gdk_event_get (GdkEvent *event) {
 		g_message ("graphics expose:\tdrawable: %d",
 			     xevent.xgraphicsexpose.drawable - base_id);
 
-	      event->expose.type = GDK_EXPOSE;
-	      event->expose.window = window;
-	      event->expose.area.x = xevent.xgraphicsexpose.x;
-	      event->expose.area.y = xevent.xgraphicsexpose.y;
-	      event->expose.area.width = xevent.xgraphicsexpose.width;
-	      event->expose.area.height = xevent.xgraphicsexpose.height;
-
-	      return_val = !((GdkWindowPrivate*) window)->destroyed;
+	      return_val = gdk_event_expose (event, window,
+					     xevent.xgraphicsexpose.x, xevent.xgraphicsexpose.y,
+					     xevent.xgraphicsexpose.width, xevent.xgraphicsexpose.height,
+					     xevent.xgraphicsexpose.count);
 	      break;
 
 	    case NoExpose:
@@ -1059,6 +1183,48 @@ void gdk_event_put (GdkEvent *event) {
   g_function_leave ("gdk_event_put");
 }
 
+/* Takes the exposes for "window" off of the list of events put
+ *  back and adds their areas, moved by "dx" and "dy", to
+ *  "invalid". Used when the contents of the window are scrolled
+ *  and the exposes would otherwise repaint the old places.
+ */
+void
+gdk_event_scroll_exposes (GdkWindow *window,
+			  gint       dx,
+			  gint       dy,
+			  GdkRegion *invalid)
+{
+  GdkEvent *temp_event;
+  GdkRectangle area;
+  GList *temp_list;
+  GList *next;
+
+  g_function_enter ("gdk_event_scroll_exposes");
+
+  temp_list = putback_events;
+  while (temp_list)
+    {
+      next = temp_list->next;
+      temp_event = temp_list->data;
+
+      if ((temp_event->type == GDK_EXPOSE) && (temp_event->any.window == window))
+	{
+	  area = temp_event->expose.area;
+	  area.x += dx;
+	  area.y += dy;
+	  gdk_region_union_with_rect (invalid, &area);
+
+	  putback_events = g_list_remove_link (putback_events, temp_list);
+	  g_list_free (temp_list);
+	  g_free (temp_event);
+	}
+
+      temp_list = next;
+    }
+
+  g_function_leave ("gdk_event_scroll_exposes");
+}
+
 
 void gdk_events_record (char *filename) {
   g_function_enter ("gdk_events_record");
@@ -1172,6 +1338,33 @@ void gdk_set_show_events (int show_events) {
   gdk_show_events = show_events;
 }
 
+/*
+ *--------------------------------------------------------------
+ * gdk_set_motion_hints
+ *
+ *   Turns on/off motion hints.
+ *
+ * Arguments:
+ *   "motion_hints" is a boolean describing whether or
+ *   not windows which ask for motion hints get them.
+ *
+ * Results:
+ *
+ * Side effects:
+ *   By default GDK_POINTER_MOTION_HINT_MASK is ignored and
+ *   every motion event is delivered with its position, so
+ *   that reading the pointer never waits on the server.
+ *   When "motion_hints" is TRUE windows created or grabs
+ *   made afterwards get a single hint per motion instead,
+ *   and the receiver must call "gdk_window_get_pointer".
+ *
+ *--------------------------------------------------------------
+ */
+
+void gdk_set_motion_hints (int motion_hints) {
+  gdk_motion_hints = motion_hints;
+}
+
 /*
  *--------------------------------------------------------------
  * gdk_time_get
@@ -1183,9 +1376,8 @@ void gdk_set_show_events (int show_events) {
  *
  * Results:
  *   The time since the library was initialized is returned.
- *   This time value is accurate to milliseconds even though
- *   a more accurate time down to the microsecond could be
- *   returned.
+ *   This time value is accurate to milliseconds. Use
+ *   "gdk_time_get_ns" for a more accurate time.
  *
  * Side effects:
  *
@@ -1193,27 +1385,39 @@ void gdk_set_show_events (int show_events) {
  */
 
 guint32 gdk_time_get () {
-  struct timeval end;
-  struct timeval elapsed;
   guint32 milliseconds;
 
   g_function_enter ("gdk_time_get");
 
-  X_GETTIMEOFDAY (&end);
-
-  if (start.tv_usec > end.tv_usec) {
-    end.tv_usec += 1000000;
-    end.tv_sec--;
-  }
-  elapsed.tv_sec = end.tv_sec - start.tv_sec;
-  elapsed.tv_usec = end.tv_usec - start.tv_usec;
-
-  milliseconds = (elapsed.tv_sec * 1000) + (elapsed.tv_usec / 1000);
+  milliseconds = (g_time_monotonic_ns () - start) / 1000000;
 
   g_function_leave ("gdk_time_get");
   return milliseconds;
 }
 
+/*
+ *--------------------------------------------------------------
+ * gdk_time_get_ns
+ *
+ *   Get the number of nanoseconds since the library was
+ *   initialized.
+ *
+ * Arguments:
+ *
+ * Results:
+ *   The time since the library was initialized is returned.
+ *   The time is taken from a monotonic clock and so is not
+ *   affected by changes to the wall clock.
+ *
+ * Side effects:
+ *
+ *--------------------------------------------------------------
+ */
+
+guint64 gdk_time_get_ns () {
+  return g_time_monotonic_ns () - start;
+}
+
 /*
  *--------------------------------------------------------------
  * gdk_timer_get
@@ -1275,17 +1479,38 @@ gint gdk_input_add (gint source, GdkInputCondition condition, GdkInputFunction f
   GList *list;
   GdkInput *input;
   gint tag;
+  gint i;
 
   g_function_enter ("gdk_input_add");
 
+  if (source < 0) {
+    g_warning ("invalid input source: %d", source);
+    g_function_leave ("gdk_input_add");
+    return 0;
+  }
+
+  if (source >= input_fds_size) {
+    i = input_fds_size;
+    while (input_fds_size <= source) {
+      input_fds_size = (input_fds_size) ? (input_fds_size * 2) : 64;
+    }
+
+    input_fds = g_realloc (input_fds, sizeof (GdkInputFd) * input_fds_size);
+    for (; i < input_fds_size; i++) {
+      input_fds[i].inputs = NULL;
+      input_fds[i].condition = 0;
+      input_fds[i].registered = FALSE;
+    }
+  }
+
   tag = 0;
-  list = inputs;
+  list = input_fds[source].inputs;
 
   while (list) {
     input = list->data;
     list = list->next;
 
-    if ((input->source == source) && (input->condition == condition)) {
+    if (input->condition == condition) {
       input->function = function;
       input->data = data;
       tag = input->tag;
@@ -1302,6 +1527,8 @@ gint gdk_input_add (gint source, GdkInputCondition condition, GdkInputFunction f
     tag = input->tag;
 
     inputs = g_list_prepend (inputs, input);
+    input_fds[source].inputs = g_list_prepend (input_fds[source].inputs, input);
+    gdk_input_fd_update (source);
   }
 
   g_function_leave ("gdk_input_add");
@@ -1335,6 +1562,9 @@ void gdk_input_remove (gint tag) {
   	  temp_list->next = NULL;
   	  temp_list->prev = NULL;
 
+      input_fds[input->source].inputs = g_list_remove (input_fds[input->source].inputs, input);
+      gdk_input_fd_update (input->source);
+
 	    g_free (temp_list->data);
 	    g_list_free (temp_list);
 	    break;
@@ -1418,6 +1648,9 @@ gdk_pointer_grab (GdkWindow *     window,
 	xevent_mask |= event_mask_table[i];
     }
 
+  if (!gdk_motion_hints)
+    xevent_mask &= ~PointerMotionHintMask;
+
   return_val = XGrabPointer (window_private->xdisplay,
 			     xwindow,
 			     owner_events,
@@ -1557,15 +1790,9 @@ void gdk_flush ()
 static gint
 gdk_event_wait ()
 {
-  GList *list;
-  GdkInput *input;
-  GdkInputCondition condition;
-  guint32 time_interval;
-  guint32 cur_time;
-  fd_set readfds;
-  fd_set writefds;
-  fd_set exceptfds;
-  int max_input;
+  guint64 time_interval;
+  guint64 cur_time;
+  gint x_ready;
   int return_val;
   int nfd;
 
@@ -1587,7 +1814,7 @@ gdk_event_wait ()
 
       if (!wait_for_send_event && have_send_event && playback_events && !playback_events->next)
 	{
-	  cur_time = gdk_time_get ();
+	  cur_time = gdk_time_get_ns ();
 	  if (next_event_time <= cur_time)
 	    {
 	      gdk_event_send_xevent (gdk_display, (XEvent*) playback_events->data);
@@ -1597,7 +1824,7 @@ gdk_event_wait ()
 	    }
 	  else if (next_event_time > cur_time)
 	    {
-	      time_interval = next_event_time - cur_time;
+	      time_interval = (next_event_time - cur_time + 999999) / 1000000;
 	      if ((time_interval < timer_val) || (timer_val == 0))
 		gdk_timer_set (time_interval);
 	      wait_for_event = TRUE;
@@ -1607,30 +1834,7 @@ gdk_event_wait ()
 
   if (XPending (gdk_display) == 0)
     {
-      FD_ZERO (&readfds);
-      FD_ZERO (&writefds);
-      FD_ZERO (&exceptfds);
-
-      FD_SET (connection_number, &readfds);
-      max_input = connection_number;
-
-      list = inputs;
-      while (list)
-	{
-	  input = list->data;
-	  list = list->next;
-
-	  if (input->condition & GDK_INPUT_READ)
-	    FD_SET (input->source, &readfds);
-	  if (input->condition & GDK_INPUT_WRITE)
-	    FD_SET (input->source, &writefds);
-	  if (input->condition & GDK_INPUT_EXCEPTION)
-	    FD_SET (input->source, &exceptfds);
-
-	  max_input = MAX (max_input, input->source);
-	}
-
-      nfd = select (max_input+1, &readfds, &writefds, &exceptfds, timerp);
+      nfd = (* event_backend->wait) (timerp, &x_ready);
 
       timerp = NULL;
       timer_val = 0;
@@ -1639,40 +1843,19 @@ gdk_event_wait ()
       if (wait_for_event && !wait_for_send_event)
 	gdk_event_send_xevent (gdk_display, (XEvent*) playback_events->data);
 
-      if (nfd > 0)
+      if ((nfd > 0) && x_ready)
 	{
-	  if (FD_ISSET (connection_number, &readfds))
+	  if (XPending (gdk_display) == 0)
 	    {
-	      if (XPending (gdk_display) == 0)
+	      if (nfd == 1)
 		{
-		  if (nfd == 1)
-		    {
-		      XNoOp (gdk_display);
-		      XFlush (gdk_display);
-		    }
-		  return_val = FALSE;
+		  XNoOp (gdk_display);
+		  XFlush (gdk_display);
 		}
-	      else
-		return_val = TRUE;
-	    }
-
-	  list = inputs;
-	  while (list)
-	    {
-	      input = list->data;
-	      list = list->next;
-
-	      condition = 0;
-	      if (FD_ISSET (input->source, &readfds))
-		condition |= GDK_INPUT_READ;
-	      if (FD_ISSET (input->source, &writefds))
-		condition |= GDK_INPUT_WRITE;
-	      if (FD_ISSET (input->source, &exceptfds))
-		condition |= GDK_INPUT_EXCEPTION;
-
-	      if (condition && input->function)
-		(* input->function) (input->data, input->source, condition);
+	      return_val = FALSE;
 	    }
+	  else
+	    return_val = TRUE;
 	}
     }
   else
@@ -1682,6 +1865,323 @@ gdk_event_wait ()
   return return_val;
 }
 
+/*
+ *--------------------------------------------------------------
+ * gdk_event_backend_init
+ *
+ *   Chooses the backend used by "gdk_event_wait" and
+ *   registers the X connection and any existing inputs
+ *   with it.
+ *
+ * Arguments:
+ *
+ * Results:
+ *   "epoll" is used when it is available unless the
+ *   "-select" option was given. "select" is used otherwise.
+ *
+ * Side effects:
+ *
+ *--------------------------------------------------------------
+ */
+
+static void
+gdk_event_backend_init ()
+{
+  gint i;
+
+  g_function_enter ("gdk_event_backend_init");
+
+  event_backend = NULL;
+
+#ifdef HAVE_EPOLL
+  if (!use_select && (* epoll_backend.init) ())
+    event_backend = &epoll_backend;
+#endif /* HAVE_EPOLL */
+
+  if (!event_backend)
+    {
+      (* select_backend.init) ();
+      event_backend = &select_backend;
+    }
+
+  if (gdk_debug_level >= 1)
+    g_message ("event backend: %s", event_backend->name);
+
+  for (i = 0; i < input_fds_size; i++)
+    {
+      input_fds[i].registered = FALSE;
+      if (input_fds[i].inputs)
+	gdk_input_fd_update (i);
+    }
+
+  g_function_leave ("gdk_event_backend_init");
+}
+
+static void
+gdk_input_fd_update (gint source)
+{
+  GList *list;
+  GdkInput *input;
+  GdkInputCondition condition;
+
+  condition = 0;
+  list = input_fds[source].inputs;
+  while (list)
+    {
+      input = list->data;
+      list = list->next;
+
+      condition |= input->condition;
+    }
+
+  input_fds[source].condition = condition;
+
+  if (event_backend)
+    (* event_backend->update) (source);
+}
+
+static void
+gdk_input_dispatch (gint              source,
+		    GdkInputCondition condition)
+{
+  GList *list;
+  GdkInput *input;
+
+  if ((source < 0) || (source >= input_fds_size))
+    return;
+
+  list = input_fds[source].inputs;
+  while (list)
+    {
+      input = list->data;
+      list = list->next;
+
+      if ((input->condition & condition) && input->function)
+	(* input->function) (input->data, input->source, input->condition & condition);
+    }
+}
+
+static gint
+gdk_select_init ()
+{
+  FD_ZERO (&select_readfds);
+  FD_ZERO (&select_writefds);
+  FD_ZERO (&select_exceptfds);
+
+  FD_SET (connection_number, &select_readfds);
+  select_max_fd = connection_number;
+
+  return TRUE;
+}
+
+static void
+gdk_select_update (gint source)
+{
+  GdkInputCondition condition;
+
+  if (source >= FD_SETSIZE)
+    {
+      if (input_fds[source].condition)
+	g_warning ("input source %d is too large for select", source);
+      return;
+    }
+
+  condition = input_fds[source].condition;
+
+  if (source != connection_number)
+    {
+      if (condition & GDK_INPUT_READ)
+	FD_SET (source, &select_readfds);
+      else
+	FD_CLR (source, &select_readfds);
+    }
+
+  if (condition & GDK_INPUT_WRITE)
+    FD_SET (source, &select_writefds);
+  else
+    FD_CLR (source, &select_writefds);
+
+  if (condition & GDK_INPUT_EXCEPTION)
+    FD_SET (source, &select_exceptfds);
+  else
+    FD_CLR (source, &select_exceptfds);
+
+  if (condition)
+    select_max_fd = MAX (select_max_fd, source);
+}
+
+static gint
+gdk_select_wait (struct timeval *timeout,
+		 gint           *x_ready)
+{
+  GdkInputCondition condition;
+  fd_set readfds;
+  fd_set writefds;
+  fd_set exceptfds;
+  int nfd;
+  int i;
+
+  readfds = select_readfds;
+  writefds = select_writefds;
+  exceptfds = select_exceptfds;
+
+  nfd = select (select_max_fd + 1, &readfds, &writefds, &exceptfds, timeout);
+
+  *x_ready = (nfd > 0) && FD_ISSET (connection_number, &readfds);
+
+  if (nfd > 0)
+    for (i = 0; (i <= select_max_fd) && (i < input_fds_size); i++)
+      if (input_fds[i].inputs)
+	{
+	  condition = 0;
+	  if (FD_ISSET (i, &readfds))
+	    condition |= GDK_INPUT_READ;
+	  if (FD_ISSET (i, &writefds))
+	    condition |= GDK_INPUT_WRITE;
+	  if (FD_ISSET (i, &exceptfds))
+	    condition |= GDK_INPUT_EXCEPTION;
+
+	  if (condition)
+	    gdk_input_dispatch (i, condition);
+	}
+
+  return nfd;
+}
+
+#ifdef HAVE_EPOLL
+
+static gint
+gdk_epoll_init ()
+{
+  struct epoll_event event;
+
+  epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (epoll_fd < 0)
+    return FALSE;
+
+  /* The X connection is always watched for reading. Inputs
+   *  which are registered on the X connection itself are
+   *  added to this registration by "gdk_epoll_update".
+   */
+  event.events = EPOLLIN;
+  event.data.fd = connection_number;
+  if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, connection_number, &event) < 0)
+    {
+      close (epoll_fd);
+      epoll_fd = -1;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gdk_epoll_update (gint source)
+{
+  struct epoll_event event;
+  GdkInputCondition condition;
+  int op;
+
+  condition = input_fds[source].condition;
+
+  event.events = 0;
+  event.data.fd = source;
+  if ((condition & GDK_INPUT_READ) || (source == connection_number))
+    event.events |= EPOLLIN;
+  if (condition & GDK_INPUT_WRITE)
+    event.events |= EPOLLOUT;
+  if (condition & GDK_INPUT_EXCEPTION)
+    event.events |= EPOLLPRI;
+
+  if (source == connection_number)
+    op = EPOLL_CTL_MOD;
+  else if (!event.events)
+    op = input_fds[source].registered ? EPOLL_CTL_DEL : -1;
+  else
+    op = input_fds[source].registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+  if (op < 0)
+    return;
+
+  /* The kernel drops a descriptor from the epoll set when it is
+   *  closed, so "registered" can be stale: an input may have been
+   *  removed after its descriptor was closed, or the number may
+   *  have been reused since. Go by what the kernel reports.
+   */
+  if (epoll_ctl (epoll_fd, op, source, &event) < 0)
+    {
+      if ((op == EPOLL_CTL_DEL) && ((errno == ENOENT) || (errno == EBADF)))
+	{
+	  input_fds[source].registered = FALSE;
+	  return;
+	}
+
+      if ((op == EPOLL_CTL_MOD) && (errno == ENOENT) && (source != connection_number))
+	op = EPOLL_CTL_ADD;
+      else if ((op == EPOLL_CTL_ADD) && (errno == EEXIST))
+	op = EPOLL_CTL_MOD;
+      else
+	op = -1;
+
+      if ((op < 0) || (epoll_ctl (epoll_fd, op, source, &event) < 0))
+	{
+	  if ((op == EPOLL_CTL_ADD) && (source != connection_number))
+	    input_fds[source].registered = FALSE;
+
+	  g_warning ("unable to watch input source %d", source);
+	  return;
+	}
+    }
+
+  if (source != connection_number)
+    input_fds[source].registered = (op != EPOLL_CTL_DEL);
+}
+
+static gint
+gdk_epoll_wait (struct timeval *timeout,
+		gint           *x_ready)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  GdkInputCondition condition;
+  int milliseconds;
+  int nfd;
+  int i;
+
+  if (timeout)
+    milliseconds = timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000;
+  else
+    milliseconds = -1;
+
+  nfd = epoll_wait (epoll_fd, events, EPOLL_MAX_EVENTS, milliseconds);
+
+  *x_ready = FALSE;
+  for (i = 0; i < nfd; i++)
+    {
+      /* An error or hangup is reported as whatever the inputs
+       *  on the descriptor are waiting for so that they get a
+       *  chance to notice (just like "select" would).
+       */
+      condition = 0;
+      if (events[i].events & EPOLLIN)
+	condition |= GDK_INPUT_READ;
+      if (events[i].events & EPOLLOUT)
+	condition |= GDK_INPUT_WRITE;
+      if (events[i].events & EPOLLPRI)
+	condition |= GDK_INPUT_EXCEPTION;
+      if (events[i].events & (EPOLLERR | EPOLLHUP))
+	condition |= GDK_INPUT_READ | GDK_INPUT_WRITE;
+
+      if (events[i].data.fd == connection_number)
+	*x_ready = TRUE;
+
+      gdk_input_dispatch (events[i].data.fd, condition);
+    }
+
+  return nfd;
+}
+
+#endif /* HAVE_EPOLL */
+
 static void
 gdk_synthesize_click (GdkEvent *event,
 		      gint      nclicks)
@@ -1700,6 +2200,95 @@ gdk_synthesize_click (GdkEvent *event,
   g_function_leave ("gdk_synthesize_click");
 }
 
+/*
+ *--------------------------------------------------------------
+ * gdk_event_expose
+ *
+ *   Accumulates an exposed area in the damage region of
+ *   "window".
+ *
+ * Arguments:
+ *   "event" is the event to fill in.
+ *   "window" is the window which was exposed.
+ *   "x", "y", "width" and "height" describe the exposed area.
+ *   "count" is the number of exposes which are known to
+ *   follow for "window".
+ *
+ * Results:
+ *   Returns FALSE until the last expose of a series (the one
+ *   with a "count" of 0) is received. Then "event" is filled
+ *   in with a single expose covering the damage region and
+ *   TRUE is returned (unless the window has been destroyed).
+ *   If the damage is scattered enough that the region's extents
+ *   would mostly repaint undamaged pixels, an expose for each
+ *   rectangle of the region is generated instead.
+ *
+ * Side effects:
+ *   Additional exposes may be placed on the put back queue.
+ *
+ *--------------------------------------------------------------
+ */
+
+static gint
+gdk_event_expose (GdkEvent  *event,
+		  GdkWindow *window,
+		  gint       x,
+		  gint       y,
+		  gint       width,
+		  gint       height,
+		  gint       count)
+{
+  GdkWindowPrivate *private;
+  GdkRegion *damage;
+  GdkRectangle area;
+  GdkEvent temp_event;
+  glong extents_area;
+  gint i;
+
+  g_function_enter ("gdk_event_expose");
+
+  private = (GdkWindowPrivate*) window;
+
+  if (!private->damage)
+    private->damage = gdk_region_new ();
+  damage = private->damage;
+
+  area.x = x;
+  area.y = y;
+  area.width = width;
+  area.height = height;
+  gdk_region_union_with_rect (damage, &area);
+
+  if ((count > 0) || gdk_region_empty (damage))
+    {
+      g_function_leave ("gdk_event_expose");
+      return FALSE;
+    }
+
+  event->expose.type = GDK_EXPOSE;
+  event->expose.window = window;
+
+  extents_area = (glong) damage->extents.width * damage->extents.height;
+  if ((damage->nrects == 1) || ((gdk_region_area (damage) * 2) >= extents_area))
+    event->expose.area = damage->extents;
+  else
+    {
+      event->expose.area = damage->rects[0];
+
+      temp_event = *event;
+      for (i = damage->nrects - 1; i > 0; i--)
+	{
+	  temp_event.expose.area = damage->rects[i];
+	  gdk_event_put (&temp_event);
+	}
+    }
+
+  gdk_region_clear (damage);
+
+  g_function_leave ("gdk_event_expose");
+  return !private->destroyed;
+}
+
 static void
 gdk_event_record (Display *display, XEvent *event)
 {
@@ -1944,7 +2533,7 @@ gdk_event_get_xevent (Display *display, XEvent *event)
 static void
 gdk_event_send_xevent (Display *display, XEvent *event)
 {
-  guint32 cur_time;
+  guint64 cur_time;
   gint done;
   gint index;
 
@@ -1953,7 +2542,7 @@ gdk_event_send_xevent (Display *display, XEvent *event)
   done = FALSE;
   index = 1;
 
-  cur_time = gdk_time_get ();
+  cur_time = gdk_time_get_ns ();
   while ((next_event_time <= cur_time) && !done)
     {
       switch (event->type)
@@ -2012,7 +2601,7 @@ gdk_event_send_xevent (Display *display, XEvent *event)
 	  break;
 	}
 
-      cur_time = gdk_time_get ();
+      cur_time = gdk_time_get_ns ();
     }
 
   g_function_leave ("gdk_event_send_xevent");
@@ -2367,6 +2956,8 @@ gdk_event_playback_parse_button_press (XEvent *event)
   event->xbutton.time = 0;
   event->xbutton.x = -1;
   event->xbutton.y = -1;
+  event->xbutton.x_root = -1;
+  event->xbutton.y_root = -1;
   event->xbutton.state = 0;
   event->xbutton.button = 0;
 
@@ -2376,6 +2967,7 @@ gdk_event_playback_parse_button_press (XEvent *event)
 	 gdk_event_playback_parse_state (event) ||
 	 gdk_event_playback_parse_button (event))
     ;
+  gdk_event_playback_root_xy (event);
 
   token = gdk_event_playback_get_next_token ();
   if (token != TOKEN_RIGHT_PAREN)
@@ -2410,6 +3002,8 @@ gdk_event_playback_parse_button_release (XEvent *event)
   event->xbutton.time = 0;
   event->xbutton.x = -1;
   event->xbutton.y = -1;
+  event->xbutton.x_root = -1;
+  event->xbutton.y_root = -1;
   event->xbutton.state = 0;
   event->xbutton.button = 0;
 
@@ -2419,6 +3013,7 @@ gdk_event_playback_parse_button_release (XEvent *event)
 	 gdk_event_playback_parse_state (event) ||
 	 gdk_event_playback_parse_button (event))
     ;
+  gdk_event_playback_root_xy (event);
 
   token = gdk_event_playback_get_next_token ();
   if (token != TOKEN_RIGHT_PAREN)
@@ -2453,6 +3048,8 @@ gdk_event_playback_parse_motion_notify (XEvent *event)
   event->xmotion.time = 0;
   event->xmotion.x = -1;
   event->xmotion.y = -1;
+  event->xmotion.x_root = -1;
+  event->xmotion.y_root = -1;
   event->xmotion.state = 0;
   event->xmotion.is_hint = 0;
 
@@ -2462,6 +3059,7 @@ gdk_event_playback_parse_motion_notify (XEvent *event)
 	 gdk_event_playback_parse_state (event) ||
 	 gdk_event_playback_parse_is_hint (event))
     ;
+  gdk_event_playback_root_xy (event);
 
   token = gdk_event_playback_get_next_token ();
   if (token != TOKEN_RIGHT_PAREN)
@@ -2650,6 +3248,7 @@ done:
 static gint
 gdk_event_playback_parse_time (XEvent *event)
 {
+  gulong milliseconds;
   gint token;
   gint return_val;
 
@@ -2674,7 +3273,10 @@ gdk_event_playback_parse_time (XEvent *event)
   if (token != TOKEN_SYMBOL)
     g_error ("unexpected token");
 
-  sscanf (token_str, "%lu", &next_event_time);
+  /* Recorded times are in milliseconds.
+   */
+  sscanf (token_str, "%lu", &milliseconds);
+  next_event_time = (guint64) milliseconds * 1000000;
 
   token = gdk_event_playback_get_next_token ();
   if (token != TOKEN_RIGHT_PAREN)
@@ -2907,6 +3509,42 @@ done:
   return return_val;
 }
 
+/* Recordings only keep the position of the pointer in the event
+ *  window, so the root position is worked out from where that
+ *  window is now.
+ */
+static void
+gdk_event_playback_root_xy (XEvent *event)
+{
+  Window child;
+  int x, y;
+  int *x_root, *y_root;
+
+  g_function_enter ("gdk_event_playback_root_xy");
+
+  if ((event->type == ButtonPress) ||
+      (event->type == ButtonRelease))
+    {
+      x = event->xbutton.x;
+      y = event->xbutton.y;
+      x_root = &event->xbutton.x_root;
+      y_root = &event->xbutton.y_root;
+    }
+  else
+    {
+      x = event->xmotion.x;
+      y = event->xmotion.y;
+      x_root = &event->xmotion.x_root;
+      y_root = &event->xmotion.y_root;
+    }
+
+  if ((event->xany.window != None) && (x >= 0) && (y >= 0))
+    XTranslateCoordinates (gdk_display, event->xany.window, gdk_root_window,
+			   x, y, x_root, y_root, &child);
+
+  g_function_leave ("gdk_event_playback_root_xy");
+}
+
 /*
  *--------------------------------------------------------------
  * gdk_exit_func
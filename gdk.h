@@ -42,10 +42,12 @@ void gdk_events_stop     (void);
 
 void gdk_set_debug_level (int  level);
 void gdk_set_show_events (int  show_events);
+void gdk_set_motion_hints (int  motion_hints);
 
-guint32 gdk_time_get  (void);
-guint32 gdk_timer_get (void);
-void    gdk_timer_set (guint32  milliseconds);
+guint32 gdk_time_get    (void);
+guint64 gdk_time_get_ns (void);
+guint32 gdk_timer_get   (void);
+void    gdk_timer_set   (guint32  milliseconds);
 
 gint gdk_input_add    (gint              source,
 		       GdkInputCondition condition,
@@ -142,9 +144,32 @@ GdkWindow* gdk_window_get_pointer    (GdkWindow       *window,
 				      gint            *x,
 				      gint            *y,
 				      GdkModifierType *mask);
+void       gdk_event_get_pointer     (GdkEvent        *event,
+				      GdkWindow       *window,
+				      gint            *x,
+				      gint            *y,
+				      GdkModifierType *mask);
+void       gdk_event_get_root_pointer (GdkEvent        *event,
+				       GdkWindow       *window,
+				       gint             origin_x,
+				       gint             origin_y,
+				       gint            *x,
+				       gint            *y,
+				       GdkModifierType *mask);
 GdkWindow* gdk_window_get_parent     (GdkWindow       *window);
 GdkWindow* gdk_window_get_toplevel   (GdkWindow       *window);
 
+void       gdk_window_scroll              (GdkWindow    *window,
+					   gint          dx,
+					   gint          dy,
+					   GdkRegion    *invalid);
+void       gdk_window_begin_paint         (GdkWindow    *window,
+					   GdkRectangle *area);
+void       gdk_window_end_paint           (GdkWindow    *window);
+void       gdk_window_set_paint_pool_size (gint          size);
+void       gdk_window_get_paint_stats     (gulong       *hits,
+					   gulong       *misses);
+
 /* Cursors
  */
 GdkCursor* gdk_cursor_new     (GdkCursorType   cursor_type);
@@ -243,6 +268,9 @@ gint gdk_color_parse     (gchar         *spec,
 			  GdkColor      *color);
 gint gdk_color_alloc     (GdkColormap   *colormap,
 			  GdkColor      *color);
+gint gdk_color_alloc_many (GdkColormap  *colormap,
+			   GdkColor     *colors,
+			   gint          ncolors);
 gint gdk_color_change    (GdkColormap   *colormap,
 			  GdkColor      *color);
 
@@ -251,11 +279,18 @@ gint gdk_color_change    (GdkColormap   *colormap,
  */
 GdkFont* gdk_font_load    (gchar    *font_name);
 void     gdk_font_free    (GdkFont  *font);
+void     gdk_font_ref     (GdkFont  *font);
+void     gdk_font_get_stats (gulong *hits,
+			     gulong *misses);
 gint     gdk_string_width (GdkFont  *font,
 			   gchar    *string);
 gint     gdk_text_width   (GdkFont  *font,
 			   gchar    *text,
 			   gint      text_length);
+gint     gdk_text_offsets (GdkFont  *font,
+			   gchar    *text,
+			   gint      text_length,
+			   gint     *offsets);
 gint     gdk_char_width   (GdkFont  *font,
 			   gchar     character);
 
@@ -337,11 +372,33 @@ void gdk_draw_segments   (GdkWindow  *window,
 			  GdkSegment *segs,
 			  gint        nsegs);
 
+void gdk_draw_batch_begin (void);
+void gdk_draw_batch_end   (void);
+void gdk_draw_batch_flush (void);
+
 /* Rectangle utilities
  */
 gint gdk_rectangle_intersect (GdkRectangle *src1,
 			      GdkRectangle *src2,
 			      GdkRectangle *dest);
+void gdk_rectangle_union     (GdkRectangle *src1,
+			      GdkRectangle *src2,
+			      GdkRectangle *dest);
+gint gdk_rectangle_subtract  (GdkRectangle *src,
+			      GdkRectangle *sub,
+			      GdkRectangle *dest);
+
+/* Regions
+ */
+GdkRegion* gdk_region_new             (void);
+void       gdk_region_destroy         (GdkRegion    *region);
+void       gdk_region_clear           (GdkRegion    *region);
+gint       gdk_region_empty           (GdkRegion    *region);
+glong      gdk_region_area            (GdkRegion    *region);
+void       gdk_region_union_with_rect (GdkRegion    *region,
+				       GdkRectangle *rect);
+void       gdk_region_subtract_rect   (GdkRegion    *region,
+				       GdkRectangle *rect);
 
 
 #ifdef __cplusplus
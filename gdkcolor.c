@@ -24,13 +24,73 @@
  *               and freeing colors.
  */
 #include <X11/Xlib.h>
+#include <X11/Xlibint.h>
 #include "gdk.h"
 #include "gdkprivate.h"
 
 
+typedef struct _GdkColorCacheEntry GdkColorCacheEntry;
+typedef struct _GdkColorAllocState GdkColorAllocState;
+
+struct _GdkColorCacheEntry
+{
+  GdkColormap *colormap;
+  guint16 red;
+  guint16 green;
+  guint16 blue;
+  GdkColor color;
+};
+
+/* The replies being waited for by "gdk_color_alloc_pipelined".
+ *  The requests have consecutive sequence numbers starting at
+ *  "first_request".
+ */
+struct _GdkColorAllocState
+{
+  unsigned long first_request;
+  unsigned long last_request;
+  XColor *xcolors;
+  gint *allocated;
+};
+
 static gint gdk_colormap_match_color (GdkColormap *cmap,
 				      GdkColor    *color,
 				      gchar       *available);
+static gint gdk_colormap_is_decomposed (GdkColormap *colormap);
+static void gdk_color_compose_pixel  (GdkVisual   *visual,
+				      GdkColor    *color);
+static void gdk_color_alloc_pipelined (GdkColormap *colormap,
+				       XColor      *xcolors,
+				       gint        *allocated,
+				       gint         ncolors);
+static Bool gdk_color_alloc_handler  (Display     *display,
+				      xReply      *rep,
+				      char        *buf,
+				      int          len,
+				      XPointer     data);
+
+static guint               gdk_color_cache_hash   (GdkColormap *colormap,
+						   guint16      red,
+						   guint16      green,
+						   guint16      blue);
+static GdkColorCacheEntry* gdk_color_cache_lookup (GdkColormap *colormap,
+						   GdkColor    *color);
+static void                gdk_color_cache_insert (GdkColormap *colormap,
+						   GdkColor    *requested,
+						   GdkColor    *color);
+static void                gdk_color_cache_remove (GdkColormap *colormap);
+static void                gdk_color_cache_resize (guint        size);
+
+/* Colors allocated from shared colormaps, keyed by the colormap
+ *  and the requested red, green and blue. Allocating a read-only
+ *  color cell for the same color again gives back the same pixel,
+ *  so the round trip to the server can be skipped. Like the
+ *  window table it is an open addressing hash table with linear
+ *  probing whose size is a power of 2.
+ */
+static GdkColorCacheEntry *color_cache = NULL;
+static guint color_cache_size = 0;
+static guint color_cache_count = 0;
 
 
 GdkColormap*
@@ -128,6 +188,7 @@ gdk_colormap_destroy (GdkColormap *colormap)
 
   private = (GdkColormapPrivate*) colormap;
   XFreeColormap (private->xdisplay, private->xcolormap);
+  gdk_color_cache_remove (colormap);
 
   g_free (colormap);
 
@@ -406,7 +467,9 @@ gdk_color_alloc (GdkColormap *colormap,
 		 GdkColor    *color)
 {
   GdkColormapPrivate *private;
+  GdkColorCacheEntry *entry;
   GdkVisual *visual;
+  GdkColor requested;
   XColor xcolor;
   gchar available[256];
   gint available_init;
@@ -421,6 +484,25 @@ gdk_color_alloc (GdkColormap *colormap,
   if (!color)
     g_error ("passed NULL color to gdk_color_alloc");
 
+  /* The pixel for a color in a true color or direct color
+   *  colormap is worked out locally, which is quicker than
+   *  looking it up in the cache.
+   */
+  private = (GdkColormapPrivate*) colormap;
+  if (!private->private && !gdk_colormap_is_decomposed (colormap))
+    {
+      entry = gdk_color_cache_lookup (colormap, color);
+      if (entry)
+	{
+	  *color = entry->color;
+
+	  g_function_leave ("gdk_color_alloc");
+	  return TRUE;
+	}
+    }
+
+  requested = *color;
+
   xcolor.red = color->red;
   xcolor.green = color->green;
   xcolor.blue = color->blue;
@@ -509,17 +591,14 @@ gdk_color_alloc (GdkColormap *colormap,
       break;
 
     case GDK_VISUAL_DIRECT_COLOR:
+    case GDK_VISUAL_TRUE_COLOR:
       visual = private->visual;
-      xcolor.pixel = (((xcolor.red >> (16 - visual->red_prec)) << visual->red_shift) +
-		      ((xcolor.green >> (16 - visual->green_prec)) << visual->green_shift) +
-		      ((xcolor.blue >> (16 - visual->blue_prec)) << visual->blue_shift));
-      color->pixel = xcolor.pixel;
+      gdk_color_compose_pixel (visual, color);
       return_val = TRUE;
       break;
 
     case GDK_VISUAL_STATIC_GRAY:
     case GDK_VISUAL_STATIC_COLOR:
-    case GDK_VISUAL_TRUE_COLOR:
       if (XAllocColor (private->xdisplay, private->xcolormap, &xcolor))
 	{
 	  color->pixel = xcolor.pixel;
@@ -530,10 +609,159 @@ gdk_color_alloc (GdkColormap *colormap,
       break;
     }
 
+  if (return_val && !private->private && !gdk_colormap_is_decomposed (colormap))
+    gdk_color_cache_insert (colormap, &requested, color);
+
   g_function_leave ("gdk_color_alloc");
   return return_val;
 }
 
+/* Colors which miss the cache of a shared colormap are all asked
+ *  for before any reply is waited for, so that they cost one round
+ *  trip together rather than one each. A color the server can't
+ *  allocate exactly then goes through "gdk_color_alloc", which
+ *  looks for the closest one.
+ */
+gint
+gdk_color_alloc_many (GdkColormap *colormap,
+		      GdkColor    *colors,
+		      gint         ncolors)
+{
+  GdkColormapPrivate *private;
+  GdkColorCacheEntry *entry;
+  GdkVisual *visual;
+  GdkColor requested;
+  XColor *xcolors;
+  gint *allocated;
+  gint *duplicate;
+  gint *misses;
+  gint nmisses;
+  gint nallocated;
+  gint i, j;
+
+  g_function_enter ("gdk_color_alloc_many");
+
+  if (!colormap)
+    g_error ("passed NULL colormap to gdk_color_alloc_many");
+
+  private = (GdkColormapPrivate*) colormap;
+  visual = private->visual;
+
+  if (gdk_colormap_is_decomposed (colormap))
+    {
+      for (i = 0; i < ncolors; i++)
+	gdk_color_compose_pixel (visual, &colors[i]);
+
+      g_function_leave ("gdk_color_alloc_many");
+      return ncolors;
+    }
+
+  nallocated = 0;
+
+  /* Private colormaps are filled in locally and need no replies.
+   */
+  if (private->private || (ncolors <= 0))
+    {
+      for (i = 0; i < ncolors; i++)
+	if (gdk_color_alloc (colormap, &colors[i]))
+	  nallocated += 1;
+
+      g_function_leave ("gdk_color_alloc_many");
+      return nallocated;
+    }
+
+  /* Only the first of each distinct color is sent to the server.
+   *  Its duplicates are served from the cache afterwards. There
+   *  are rarely more than a few misses, so they are compared with
+   *  each other directly.
+   */
+  misses = g_new (gint, ncolors);
+  duplicate = g_new (gint, ncolors);
+  nmisses = 0;
+
+  for (i = 0; i < ncolors; i++)
+    {
+      duplicate[i] = FALSE;
+
+      entry = gdk_color_cache_lookup (colormap, &colors[i]);
+      if (entry)
+	{
+	  colors[i] = entry->color;
+	  nallocated += 1;
+	  continue;
+	}
+
+      for (j = 0; j < nmisses; j++)
+	if ((colors[misses[j]].red == colors[i].red) &&
+	    (colors[misses[j]].green == colors[i].green) &&
+	    (colors[misses[j]].blue == colors[i].blue))
+	  break;
+
+      if (j == nmisses)
+	misses[nmisses++] = i;
+      else
+	duplicate[i] = TRUE;
+    }
+
+  if (nmisses > 0)
+    {
+      xcolors = g_new (XColor, nmisses);
+      allocated = g_new (gint, nmisses);
+
+      for (j = 0; j < nmisses; j++)
+	{
+	  xcolors[j].red = colors[misses[j]].red;
+	  xcolors[j].green = colors[misses[j]].green;
+	  xcolors[j].blue = colors[misses[j]].blue;
+	  xcolors[j].flags = DoRed | DoGreen | DoBlue;
+	  allocated[j] = FALSE;
+	}
+
+      gdk_color_alloc_pipelined (colormap, xcolors, allocated, nmisses);
+
+      for (j = 0; j < nmisses; j++)
+	{
+	  i = misses[j];
+
+	  if (allocated[j])
+	    {
+	      requested = colors[i];
+	      colors[i].pixel = xcolors[j].pixel;
+
+	      if ((visual->type == GDK_VISUAL_GRAYSCALE) ||
+		  (visual->type == GDK_VISUAL_PSEUDO_COLOR))
+		{
+		  colors[i].red = xcolors[j].red;
+		  colors[i].green = xcolors[j].green;
+		  colors[i].blue = xcolors[j].blue;
+
+		  colormap->colors[colors[i].pixel] = colors[i];
+		}
+
+	      gdk_color_cache_insert (colormap, &requested, &colors[i]);
+	      nallocated += 1;
+	    }
+	  else if (gdk_color_alloc (colormap, &colors[i]))
+	    {
+	      nallocated += 1;
+	    }
+	}
+
+      g_free (xcolors);
+      g_free (allocated);
+    }
+
+  for (i = 0; i < ncolors; i++)
+    if (duplicate[i] && gdk_color_alloc (colormap, &colors[i]))
+      nallocated += 1;
+
+  g_free (duplicate);
+  g_free (misses);
+
+  g_function_leave ("gdk_color_alloc_many");
+  return nallocated;
+}
+
 gint
 gdk_color_change (GdkColormap *colormap,
 		  GdkColor    *color)
@@ -563,6 +791,164 @@ gdk_color_change (GdkColormap *colormap,
 }
 
 
+/* Returns TRUE if pixels in "colormap" are made of separate
+ *  red, green and blue fields.
+ */
+static gint
+gdk_colormap_is_decomposed (GdkColormap *colormap)
+{
+  GdkColormapPrivate *private;
+  gint return_val;
+
+  g_function_enter ("gdk_colormap_is_decomposed");
+
+  private = (GdkColormapPrivate*) colormap;
+
+  switch (private->visual->type)
+    {
+    case GDK_VISUAL_TRUE_COLOR:
+    case GDK_VISUAL_DIRECT_COLOR:
+      return_val = TRUE;
+      break;
+    default:
+      return_val = FALSE;
+      break;
+    }
+
+  g_function_leave ("gdk_colormap_is_decomposed");
+  return return_val;
+}
+
+/* Sets the pixel of "color" from its red, green and blue values.
+ *  Each value is rounded to the nearest step of an even ramp with
+ *  the precision of that field. That is the cell XAllocColor picks
+ *  for a true color visual, and the ramp gdk_colormap_new stores
+ *  in a direct color colormap.
+ */
+static void
+gdk_color_compose_pixel (GdkVisual *visual,
+			 GdkColor  *color)
+{
+  gulong red, green, blue;
+
+  g_function_enter ("gdk_color_compose_pixel");
+
+  red = ((gulong) color->red * ((1 << visual->red_prec) - 1) + 32767) / 65535;
+  green = ((gulong) color->green * ((1 << visual->green_prec) - 1) + 32767) / 65535;
+  blue = ((gulong) color->blue * ((1 << visual->blue_prec) - 1) + 32767) / 65535;
+
+  color->pixel = ((red << visual->red_shift) |
+		  (green << visual->green_shift) |
+		  (blue << visual->blue_shift));
+
+  g_function_leave ("gdk_color_compose_pixel");
+}
+
+/* Sends an AllocColor request for each of "xcolors" and only then
+ *  waits, with a GetInputFocus behind them as XSync does. The
+ *  replies (and errors, for colors which couldn't be allocated)
+ *  are picked up as they come in by "gdk_color_alloc_handler".
+ *  XAllocColor itself waits for each reply before going on.
+ */
+static void
+gdk_color_alloc_pipelined (GdkColormap *colormap,
+			   XColor      *xcolors,
+			   gint        *allocated,
+			   gint         ncolors)
+{
+  GdkColormapPrivate *private;
+  GdkColorAllocState state;
+  _XAsyncHandler async;
+  xAllocColorReq *req;
+  xGetInputFocusReply rep;
+  xReq *sync_req;
+  Display *dpy;
+  gint i;
+
+  g_function_enter ("gdk_color_alloc_pipelined");
+
+  private = (GdkColormapPrivate*) colormap;
+  /* The Xlib request macros expect the display in "dpy".
+   */
+  dpy = private->xdisplay;
+
+  state.xcolors = xcolors;
+  state.allocated = allocated;
+
+  LockDisplay (dpy);
+
+  async.next = dpy->async_handlers;
+  async.handler = gdk_color_alloc_handler;
+  async.data = (XPointer) &state;
+  dpy->async_handlers = &async;
+
+  for (i = 0; i < ncolors; i++)
+    {
+      GetReq (AllocColor, req);
+      req->cmap = private->xcolormap;
+      req->red = xcolors[i].red;
+      req->green = xcolors[i].green;
+      req->blue = xcolors[i].blue;
+
+      if (i == 0)
+	state.first_request = dpy->request;
+    }
+  state.last_request = dpy->request;
+
+  GetEmptyReq (GetInputFocus, sync_req);
+  (void) _XReply (dpy, (xReply*) &rep, 0, xTrue);
+
+  DeqAsyncHandler (dpy, &async);
+  UnlockDisplay (dpy);
+  SyncHandle ();
+
+  g_function_leave ("gdk_color_alloc_pipelined");
+}
+
+static Bool
+gdk_color_alloc_handler (Display  *display,
+			 xReply   *rep,
+			 char     *buf,
+			 int       len,
+			 XPointer  data)
+{
+  GdkColorAllocState *state;
+  xAllocColorReply replbuf;
+  xAllocColorReply *reply;
+  unsigned long request;
+  gint i;
+
+  state = (GdkColorAllocState*) data;
+  request = display->last_request_read;
+
+  if (((long) (request - state->first_request) < 0) ||
+      ((long) (request - state->last_request) > 0))
+    return False;
+
+  i = request - state->first_request;
+
+  /* An error means the color couldn't be allocated. It is
+   *  swallowed here rather than reported, as XAllocColor does.
+   */
+  if (rep->generic.type == X_Error)
+    {
+      state->allocated[i] = FALSE;
+      return True;
+    }
+
+  reply = (xAllocColorReply*)
+    _XGetAsyncReply (display, (char*) &replbuf, rep, buf, len,
+		     (SIZEOF (xAllocColorReply) - SIZEOF (xReply)) >> 2, True);
+
+  state->xcolors[i].pixel = reply->pixel;
+  state->xcolors[i].red = reply->red;
+  state->xcolors[i].green = reply->green;
+  state->xcolors[i].blue = reply->blue;
+  state->allocated[i] = TRUE;
+
+  return True;
+}
+
 static gint
 gdk_colormap_match_color (GdkColormap *cmap,
 			  GdkColor    *color,
@@ -603,3 +989,129 @@ gdk_colormap_match_color (GdkColormap *cmap,
   g_function_leave ("gdk_colormap_match_color");
   return index;
 }
+
+static guint
+gdk_color_cache_hash (GdkColormap *colormap,
+		      guint16      red,
+		      guint16      green,
+		      guint16      blue)
+{
+  guint64 key;
+
+  key = (((guint64) red << 32) |
+	 ((guint64) green << 16) |
+	 ((guint64) blue));
+  key ^= (guint64) (gulong) colormap;
+
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+
+  return (guint) key & (color_cache_size - 1);
+}
+
+static GdkColorCacheEntry*
+gdk_color_cache_lookup (GdkColormap *colormap,
+			GdkColor    *color)
+{
+  guint index;
+
+  if (!color_cache_count)
+    return NULL;
+
+  index = gdk_color_cache_hash (colormap, color->red, color->green, color->blue);
+  while (color_cache[index].colormap)
+    {
+      if ((color_cache[index].colormap == colormap) &&
+	  (color_cache[index].red == color->red) &&
+	  (color_cache[index].green == color->green) &&
+	  (color_cache[index].blue == color->blue))
+	return &color_cache[index];
+
+      index = (index + 1) & (color_cache_size - 1);
+    }
+
+  return NULL;
+}
+
+static void
+gdk_color_cache_insert (GdkColormap *colormap,
+			GdkColor    *requested,
+			GdkColor    *color)
+{
+  GdkColorCacheEntry *entry;
+  guint index;
+
+  entry = gdk_color_cache_lookup (colormap, requested);
+  if (entry)
+    {
+      entry->color = *color;
+      return;
+    }
+
+  if ((color_cache_count + 1) * 2 > color_cache_size)
+    gdk_color_cache_resize ((color_cache_size) ? (color_cache_size * 2) : 64);
+
+  index = gdk_color_cache_hash (colormap, requested->red, requested->green, requested->blue);
+  while (color_cache[index].colormap)
+    index = (index + 1) & (color_cache_size - 1);
+
+  color_cache[index].colormap = colormap;
+  color_cache[index].red = requested->red;
+  color_cache[index].green = requested->green;
+  color_cache[index].blue = requested->blue;
+  color_cache[index].color = *color;
+  color_cache_count += 1;
+}
+
+static void
+gdk_color_cache_remove (GdkColormap *colormap)
+{
+  guint i;
+
+  /* Colormaps are rarely destroyed. Dropping their colors and
+   *  rehashing the rest at the same size is simpler than
+   *  fixing up probe sequences one entry at a time.
+   */
+  for (i = 0; i < color_cache_size; i++)
+    if (color_cache[i].colormap == colormap)
+      {
+	color_cache[i].colormap = NULL;
+	color_cache_count -= 1;
+      }
+
+  if (color_cache_size)
+    gdk_color_cache_resize (color_cache_size);
+}
+
+static void
+gdk_color_cache_resize (guint size)
+{
+  GdkColorCacheEntry *old_cache;
+  guint old_size;
+  guint index;
+  guint i;
+
+  old_cache = color_cache;
+  old_size = color_cache_size;
+
+  color_cache = g_new (GdkColorCacheEntry, size);
+  color_cache_size = size;
+
+  for (i = 0; i < size; i++)
+    color_cache[i].colormap = NULL;
+
+  for (i = 0; i < old_size; i++)
+    if (old_cache[i].colormap)
+      {
+	index = gdk_color_cache_hash (old_cache[i].colormap, old_cache[i].red,
+				      old_cache[i].green, old_cache[i].blue);
+	while (color_cache[index].colormap)
+	  index = (index + 1) & (color_cache_size - 1);
+
+	color_cache[index] = old_cache[i];
+      }
+
+  if (old_cache)
+    g_free (old_cache);
+}
@@ -27,6 +27,39 @@
 #include "gdkprivate.h"
 
 
+#define DRAW_BATCH_SIZE  256
+
+
+typedef enum
+{
+  GDK_DRAW_BATCH_NONE,
+  GDK_DRAW_BATCH_LINES,
+  GDK_DRAW_BATCH_RECTANGLES,
+  GDK_DRAW_BATCH_FILLED_RECTANGLES
+} GdkDrawBatchType;
+
+
+static gint gdk_draw_batch_add (GdkWindow        *window,
+				GdkGC            *gc,
+				GdkDrawBatchType  type);
+
+
+/* Between "gdk_draw_batch_begin" and "gdk_draw_batch_end" lines
+ *  and rectangles drawn with the same gc into the same drawable
+ *  are collected and sent with a single XDrawSegments or
+ *  XFillRectangles. Anything else that draws, changes a gc or
+ *  clears or destroys a drawable flushes the batch first, so the
+ *  order of drawing is kept.
+ */
+static gint batch_depth = 0;
+static GdkDrawBatchType batch_type = GDK_DRAW_BATCH_NONE;
+static GdkWindow *batch_window = NULL;
+static GdkGC *batch_gc = NULL;
+static gint batch_count = 0;
+static XSegment batch_segments[DRAW_BATCH_SIZE];
+static XRectangle batch_rectangles[DRAW_BATCH_SIZE];
+
+
 void
 gdk_draw_move (GdkGC *gc, 
 	       gint   x, 
@@ -75,6 +108,7 @@ gdk_draw_line (GdkWindow *window,
 {
   GdkWindowPrivate *window_private;
   GdkGCPrivate *gc_private;
+  gint i;
   
   g_function_enter ("gdk_draw_line");
 
@@ -84,10 +118,22 @@ gdk_draw_line (GdkWindow *window,
   if (!gc)
     g_error ("passed NULL gc to gdk_draw_line");
   
+  if (batch_depth > 0)
+    {
+      i = gdk_draw_batch_add (window, gc, GDK_DRAW_BATCH_LINES);
+      batch_segments[i].x1 = x1;
+      batch_segments[i].y1 = y1;
+      batch_segments[i].x2 = x2;
+      batch_segments[i].y2 = y2;
+
+      g_function_leave ("gdk_draw_line");
+      return;
+    }
+
   window_private = (GdkWindowPrivate*) window;
   gc_private = (GdkGCPrivate*) gc;
 
-  XDrawLine (window_private->xdisplay, window_private->xwindow,
+  XDrawLine (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	     gc_private->xgc, x1, y1, x2, y2);
   
   g_function_leave ("gdk_draw_line");
@@ -104,6 +150,8 @@ gdk_draw_line_rel (GdkWindow *window,
   
   g_function_enter ("gdk_draw_line_rel");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_line_rel");
   
@@ -113,7 +161,7 @@ gdk_draw_line_rel (GdkWindow *window,
   window_private = (GdkWindowPrivate*) window;
   gc_private = (GdkGCPrivate*) gc;
 
-  XDrawLine (window_private->xdisplay, window_private->xwindow,
+  XDrawLine (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	     gc_private->xgc, gc_private->x, gc_private->y,
 	     gc_private->x + dx, gc_private->y + dy);
 
@@ -134,6 +182,7 @@ gdk_draw_rectangle (GdkWindow *window,
 {
   GdkWindowPrivate *window_private;
   GdkGCPrivate *gc_private;
+  gint i;
   
   g_function_enter ("gdk_draw_rectangle");
 
@@ -143,14 +192,28 @@ gdk_draw_rectangle (GdkWindow *window,
   if (!gc)
     g_error ("passed NULL gc to gdk_draw_rectangle");
 
+  if (batch_depth > 0)
+    {
+      i = gdk_draw_batch_add (window, gc, (filled) ?
+			      (GDK_DRAW_BATCH_FILLED_RECTANGLES) :
+			      (GDK_DRAW_BATCH_RECTANGLES));
+      batch_rectangles[i].x = x;
+      batch_rectangles[i].y = y;
+      batch_rectangles[i].width = width;
+      batch_rectangles[i].height = height;
+
+      g_function_leave ("gdk_draw_rectangle");
+      return;
+    }
+
   window_private = (GdkWindowPrivate*) window;
   gc_private = (GdkGCPrivate*) gc;
 
   if (filled)
-    XFillRectangle (window_private->xdisplay, window_private->xwindow,
+    XFillRectangle (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		    gc_private->xgc, x, y, width, height);
   else
-    XDrawRectangle (window_private->xdisplay, window_private->xwindow,
+    XDrawRectangle (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		    gc_private->xgc, x, y, width, height);
 
   g_function_leave ("gdk_draw_rectangle");
@@ -172,6 +235,8 @@ gdk_draw_arc (GdkWindow *window,
   
   g_function_enter ("gdk_draw_ellipse");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_ellipse");
   
@@ -182,10 +247,10 @@ gdk_draw_arc (GdkWindow *window,
   gc_private = (GdkGCPrivate*) gc;
 
   if (filled)
-    XFillArc (window_private->xdisplay, window_private->xwindow,
+    XFillArc (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	      gc_private->xgc, x, y, width, height, angle1, angle2);
   else
-    XDrawArc (window_private->xdisplay, window_private->xwindow,
+    XDrawArc (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	      gc_private->xgc, x, y, width, height, angle1, angle2);
 
   g_function_leave ("gdk_draw_ellipse");
@@ -203,6 +268,8 @@ gdk_draw_polygon (GdkWindow *window,
   
   g_function_enter ("gdk_draw_polygon");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_polygon");
   
@@ -214,17 +281,17 @@ gdk_draw_polygon (GdkWindow *window,
 
   if (filled)
     {
-      XFillPolygon (window_private->xdisplay, window_private->xwindow,
+      XFillPolygon (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		    gc_private->xgc, (XPoint*) points, npoints, Complex, CoordModeOrigin);
     }
   else
     {
-      XDrawLines (window_private->xdisplay, window_private->xwindow,
+      XDrawLines (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		  gc_private->xgc, (XPoint*) points, npoints, CoordModeOrigin);
 
       if ((points[0].x != points[npoints-1].x) ||
 	  (points[0].y != points[npoints-1].y))
-	XDrawLine (window_private->xdisplay, window_private->xwindow,
+	XDrawLine (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		   gc_private->xgc, points[npoints-1].x, points[npoints-1].y,
 		   points[0].x, points[0].y);
     }
@@ -243,6 +310,8 @@ gdk_draw_string (GdkWindow *window,
   GdkGCPrivate *gc_private;
   
   g_function_enter ("gdk_draw_string");
+
+  gdk_draw_batch_flush ();
   
   if (!window)
     g_error ("passed NULL window to gdk_draw_string");
@@ -256,7 +325,7 @@ gdk_draw_string (GdkWindow *window,
   window_private = (GdkWindowPrivate*) window;
   gc_private = (GdkGCPrivate*) gc;
 
-  XDrawString (window_private->xdisplay, window_private->xwindow,
+  XDrawString (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	       gc_private->xgc, x, y, string, strlen (string));
   
   g_function_leave ("gdk_draw_string");
@@ -274,6 +343,8 @@ gdk_draw_text (GdkWindow *window,
   GdkGCPrivate *gc_private;
   
   g_function_enter ("gdk_draw_text");
+
+  gdk_draw_batch_flush ();
   
   if (!window)
     g_error ("passed NULL window to gdk_draw_text");
@@ -287,7 +358,7 @@ gdk_draw_text (GdkWindow *window,
   window_private = (GdkWindowPrivate*) window;
   gc_private = (GdkGCPrivate*) gc;
 
-  XDrawString (window_private->xdisplay, window_private->xwindow,
+  XDrawString (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	       gc_private->xgc, x, y, text, text_length);
   
   g_function_leave ("gdk_draw_text");
@@ -310,6 +381,8 @@ gdk_draw_pixmap (GdkWindow *window,
   
   g_function_enter ("gdk_draw_pixmap");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_pixmap");
   
@@ -325,7 +398,7 @@ gdk_draw_pixmap (GdkWindow *window,
 
   XCopyArea (window_private->xdisplay, 
 	     pixmap_private->xwindow,
-	     window_private->xwindow,
+	     GDK_DRAWABLE_XID (window_private),
 	     gc_private->xgc, 
 	     xsrc, ysrc, 
 	     width, height, 
@@ -349,6 +422,8 @@ gdk_draw_image (GdkWindow *window,
   
   g_function_enter ("gdk_draw_image");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_image");
   
@@ -380,6 +455,8 @@ gdk_draw_points (GdkWindow  *window,
 
   g_function_enter ("gdk_draw_points");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_points");
   
@@ -393,7 +470,7 @@ gdk_draw_points (GdkWindow  *window,
   gc_private = (GdkGCPrivate*) gc;
 
   XDrawPoints (window_private->xdisplay,
-	       window_private->xwindow, 
+	       GDK_DRAWABLE_XID (window_private), 
 	       gc_private->xgc,
 	       (XPoint *) points,
 	       npoints,
@@ -413,6 +490,8 @@ gdk_draw_segments (GdkWindow  *window,
 
   g_function_enter ("gdk_draw_segments");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_draw_segments");
   
@@ -426,10 +505,104 @@ gdk_draw_segments (GdkWindow  *window,
   gc_private = (GdkGCPrivate*) gc;
 
   XDrawSegments (window_private->xdisplay,
-		 window_private->xwindow, 
+		 GDK_DRAWABLE_XID (window_private), 
 		 gc_private->xgc,
 		 (XSegment *) segs,
 		 nsegs);
 
   g_function_leave ("gdk_draw_segments");
 }
+
+void
+gdk_draw_batch_begin ()
+{
+  g_function_enter ("gdk_draw_batch_begin");
+
+  batch_depth += 1;
+
+  g_function_leave ("gdk_draw_batch_begin");
+}
+
+void
+gdk_draw_batch_end ()
+{
+  g_function_enter ("gdk_draw_batch_end");
+
+  if (batch_depth <= 0)
+    g_error ("unbalanced call to gdk_draw_batch_end");
+
+  batch_depth -= 1;
+  if (batch_depth == 0)
+    gdk_draw_batch_flush ();
+
+  g_function_leave ("gdk_draw_batch_end");
+}
+
+/* This is called before most drawing operations, so it doesn't
+ *  bother with "g_function_enter" and "g_function_leave" when
+ *  there is nothing to flush.
+ */
+void
+gdk_draw_batch_flush ()
+{
+  GdkWindowPrivate *window_private;
+  GdkGCPrivate *gc_private;
+
+  if (!batch_count)
+    return;
+
+  g_function_enter ("gdk_draw_batch_flush");
+
+  window_private = (GdkWindowPrivate*) batch_window;
+  gc_private = (GdkGCPrivate*) batch_gc;
+
+  switch (batch_type)
+    {
+    case GDK_DRAW_BATCH_LINES:
+      XDrawSegments (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
+		     gc_private->xgc, batch_segments, batch_count);
+      break;
+    case GDK_DRAW_BATCH_RECTANGLES:
+      XDrawRectangles (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
+		       gc_private->xgc, batch_rectangles, batch_count);
+      break;
+    case GDK_DRAW_BATCH_FILLED_RECTANGLES:
+      XFillRectangles (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
+		       gc_private->xgc, batch_rectangles, batch_count);
+      break;
+    default:
+      break;
+    }
+
+  batch_type = GDK_DRAW_BATCH_NONE;
+  batch_window = NULL;
+  batch_gc = NULL;
+  batch_count = 0;
+
+  g_function_leave ("gdk_draw_batch_flush");
+}
+
+
+/* Returns the slot for the next primitive of the given type,
+ *  flushing the batch first if it holds something else or is
+ *  full.
+ */
+static gint
+gdk_draw_batch_add (GdkWindow        *window,
+		    GdkGC            *gc,
+		    GdkDrawBatchType  type)
+{
+  if ((batch_window != window) ||
+      (batch_gc != gc) ||
+      (batch_type != type) ||
+      (batch_count == DRAW_BATCH_SIZE))
+    {
+      gdk_draw_batch_flush ();
+
+      batch_window = window;
+      batch_gc = gc;
+      batch_type = type;
+    }
+
+  return batch_count++;
+}
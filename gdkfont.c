@@ -29,14 +29,49 @@
 #include "gdkprivate.h"
 
 
+/* The fonts which are loaded, keyed by the name they were loaded
+ *  with. Loading a font is a round trip which also brings back
+ *  the metrics of every character, so loading a font by the same
+ *  name again hands out another reference to the same font. There
+ *  are only ever a handful of fonts, so a list is enough.
+ */
+static GList *font_cache = NULL;
+static gulong font_cache_hits = 0;
+static gulong font_cache_misses = 0;
+
+
 GdkFont*
 gdk_font_load (gchar *font_name)
 {
   GdkFont *font;
   GdkFontPrivate *private;
+  GList *tmp_list;
+  gchar character;
+  gint i;
 
   g_function_enter ("gdk_font_load");
 
+  if (!font_name)
+    g_error ("passed NULL font name to gdk_font_load");
+
+  tmp_list = font_cache;
+  while (tmp_list)
+    {
+      private = tmp_list->data;
+      tmp_list = tmp_list->next;
+
+      if (strcmp (private->name, font_name) == 0)
+	{
+	  private->ref_count += 1;
+	  font_cache_hits += 1;
+
+	  g_function_leave ("gdk_font_load");
+	  return (GdkFont*) private;
+	}
+    }
+
+  font_cache_misses += 1;
+
   private = g_new (GdkFontPrivate, 1);
   font = (GdkFont*) private;
 
@@ -52,12 +87,47 @@ gdk_font_load (gchar *font_name)
     {
       font->ascent = private->xfont->ascent;
       font->descent = private->xfont->descent;
+
+      private->name = g_strdup (font_name);
+      private->ref_count = 1;
+
+      /* Text is measured a byte at a time from this table. Each
+       *  width is what XTextWidth gives for that byte alone, so
+       *  missing characters and fonts with more than one row of
+       *  characters (where a byte is in the first row) measure
+       *  just as they did before. XTextWidth works from the
+       *  metrics already sent with the font, so this is done
+       *  without going to the server.
+       */
+      for (i = 0; i < 256; i++)
+	{
+	  character = i;
+	  private->widths[i] = XTextWidth (private->xfont, &character, 1);
+	}
+
+      font_cache = g_list_prepend (font_cache, private);
     }
   
   g_function_leave ("gdk_font_load");
   return font;
 }
 
+void
+gdk_font_ref (GdkFont *font)
+{
+  GdkFontPrivate *private;
+
+  g_function_enter ("gdk_font_ref");
+
+  if (!font)
+    g_error ("passed NULL font to gdk_font_ref");
+
+  private = (GdkFontPrivate*) font;
+  private->ref_count += 1;
+
+  g_function_leave ("gdk_font_ref");
+}
+
 void
 gdk_font_free (GdkFont *font)
 {
@@ -69,17 +139,73 @@ gdk_font_free (GdkFont *font)
     g_error ("passed NULL font to gdk_font_free");
 
   private = (GdkFontPrivate*) font;
-  XFreeFont (private->xdisplay, private->xfont);
-  g_free (font);
+
+  /* The font stays loaded until the last reference to it is
+   *  released.
+   */
+  private->ref_count -= 1;
+  if (private->ref_count == 0)
+    {
+      font_cache = g_list_remove (font_cache, private);
+
+      XFreeFont (private->xdisplay, private->xfont);
+      g_free (private->name);
+      g_free (font);
+    }
   
   g_function_leave ("gdk_font_free");
 }
 
+void
+gdk_font_get_stats (gulong *hits,
+		    gulong *misses)
+{
+  g_function_enter ("gdk_font_get_stats");
+
+  if (hits)
+    *hits = font_cache_hits;
+  if (misses)
+    *misses = font_cache_misses;
+
+  g_function_leave ("gdk_font_get_stats");
+}
+
+/*
+ * Print the loaded fonts with their reference counts and how
+ *  often loading a font found it already loaded.
+ */
+void
+gdk_font_info ()
+{
+  GdkFontPrivate *private;
+  GList *tmp_list;
+
+  g_function_enter ("gdk_font_info");
+
+  tmp_list = font_cache;
+  while (tmp_list)
+    {
+      private = tmp_list->data;
+      tmp_list = tmp_list->next;
+
+      g_message ("font cache: \"%s\" (%d references)",
+		 private->name, private->ref_count);
+    }
+
+  g_message ("font cache: %d fonts, %ld hits, %ld misses (hit rate %.2f)",
+	     g_list_length (font_cache), font_cache_hits, font_cache_misses,
+	     (font_cache_hits + font_cache_misses) ?
+	     ((gdouble) font_cache_hits / (font_cache_hits + font_cache_misses)) : 0.0);
+
+  g_function_leave ("gdk_font_info");
+}
+
 gint
 gdk_string_width (GdkFont *font, 
 		  gchar   *string)
 {
   GdkFontPrivate *private;
+  guchar *p;
   gint width;
   
   g_function_enter ("gdk_string_width");
@@ -91,7 +217,10 @@ gdk_string_width (GdkFont *font,
     g_error ("passed NULL string to gdk_string_width");
 
   private = (GdkFontPrivate*) font;
-  width = XTextWidth (private->xfont, string, strlen (string));
+
+  width = 0;
+  for (p = (guchar*) string; *p; p++)
+    width += private->widths[*p];
     
   g_function_leave ("gdk_string_width");
   return width;
@@ -103,7 +232,9 @@ gdk_text_width (GdkFont  *font,
 		gint      text_length)
 {
   GdkFontPrivate *private;
+  guchar *p;
   gint width;
+  gint i;
   
   g_function_enter ("gdk_text_width");
 
@@ -114,18 +245,59 @@ gdk_text_width (GdkFont  *font,
     g_error ("passed NULL text to gdk_text_width");
 
   private = (GdkFontPrivate*) font;
-  width = XTextWidth (private->xfont, text, text_length);
+  p = (guchar*) text;
+
+  width = 0;
+  for (i = 0; i < text_length; i++)
+    width += private->widths[p[i]];
     
   g_function_leave ("gdk_text_width");
   return width;
 }
 
+/* Measures "text" in one pass. "offsets" must have room for
+ *  "text_length" values. The i'th is set to the width of the
+ *  characters before the i'th one. Returns the width of all of
+ *  "text".
+ */
+gint
+gdk_text_offsets (GdkFont  *font,
+		  gchar    *text,
+		  gint      text_length,
+		  gint     *offsets)
+{
+  GdkFontPrivate *private;
+  guchar *p;
+  gint width;
+  gint i;
+
+  g_function_enter ("gdk_text_offsets");
+
+  if (!font)
+    g_error ("passed NULL font to gdk_text_offsets");
+
+  if (!text && (text_length > 0))
+    g_error ("passed NULL text to gdk_text_offsets");
+
+  private = (GdkFontPrivate*) font;
+  p = (guchar*) text;
+
+  width = 0;
+  for (i = 0; i < text_length; i++)
+    {
+      offsets[i] = width;
+      width += private->widths[p[i]];
+    }
+
+  g_function_leave ("gdk_text_offsets");
+  return width;
+}
+
 gint
 gdk_char_width (GdkFont *font,
 		gchar    character)
 {
   GdkFontPrivate *private;
-  XCharStruct *chars;
   gint width;
   
   g_function_enter ("gdk_char_width");
@@ -134,22 +306,7 @@ gdk_char_width (GdkFont *font,
     g_error ("passed NULL font to gdk_char_width");
 
   private = (GdkFontPrivate*) font;
-  
-  if ((private->xfont->min_byte1 == 0) &&
-      (private->xfont->max_byte1 == 0) &&
-      (character >= private->xfont->min_char_or_byte2) &&
-      (character <= private->xfont->max_char_or_byte2))
-    {
-      chars = private->xfont->per_char;
-      if (chars)
-	width = chars[character - private->xfont->min_char_or_byte2].width;
-      else
-	width = private->xfont->min_bounds.width;
-    }
-  else
-    {
-      width = XTextWidth (private->xfont, &character, 1);
-    }
+  width = private->widths[(guchar) character];
   
   g_function_leave ("gdk_char_width");
   return width;
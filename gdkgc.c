@@ -80,6 +80,8 @@ gdk_gc_destroy (GdkGC *gc)
   GdkGCPrivate *private;
   
   g_function_enter ("gdk_gc_destroy");
+
+  gdk_draw_batch_flush ();
   
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_destroy");
@@ -99,6 +101,8 @@ gdk_gc_set_foreground (GdkGC    *gc,
   GdkGCPrivate *private;
 
   g_function_enter ("gdk_gc_set_foreground");
+
+  gdk_draw_batch_flush ();
   
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_set_foreground");
@@ -120,6 +124,8 @@ gdk_gc_set_background (GdkGC    *gc,
   GdkGCPrivate *private;
 
   g_function_enter ("gdk_gc_set_background");
+
+  gdk_draw_batch_flush ();
   
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_set_background");
@@ -143,6 +149,8 @@ gdk_gc_set_font (GdkGC   *gc,
 
   g_function_enter ("gdk_gc_set_font");
 
+  gdk_draw_batch_flush ();
+
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_set_font");
   
@@ -168,6 +176,8 @@ gdk_gc_set_function (GdkGC       *gc,
   GdkGCPrivate *private;
 
   g_function_enter ("gdk_gc_set_function");
+
+  gdk_draw_batch_flush ();
   
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_set_function");
@@ -201,6 +211,8 @@ gdk_gc_set_fill (GdkGC   *gc,
   GdkGCPrivate *private;
 
   g_function_enter ("gdk_gc_set_fill");
+
+  gdk_draw_batch_flush ();
   
   if (!gc)
     g_error ("passed NULL gc to gdk_gc_set_fill");
@@ -239,6 +251,8 @@ gdk_gc_set_tile (GdkGC     *gc,
   Pixmap pixmap;
 
   g_function_enter ("gdk_gc_set_tile");
+
+  gdk_draw_batch_flush ();
   
   g_assert (gc);
   private = (GdkGCPrivate*) gc;
@@ -269,6 +283,8 @@ gdk_gc_set_stipple (GdkGC     *gc,
   Pixmap pixmap;
 
   g_function_enter ("gdk_gc_set_stipple");
+
+  gdk_draw_batch_flush ();
   
   g_assert (gc);
   private = (GdkGCPrivate*) gc;
@@ -297,6 +313,8 @@ gdk_gc_set_subwindow (GdkGC            *gc,
   GdkGCPrivate *private;
   
   g_function_enter ("gdk_gc_set_subwindow");
+
+  gdk_draw_batch_flush ();
   
   g_assert (gc);
   private = (GdkGCPrivate*) gc;
@@ -317,6 +335,8 @@ gdk_gc_set_exposures (GdkGC *gc,
   GdkGCPrivate *private;
   
   g_function_enter ("gdk_gc_set_exposures");
+
+  gdk_draw_batch_flush ();
   
   g_assert (gc);
   private = (GdkGCPrivate*) gc;
@@ -343,6 +363,8 @@ gdk_gc_set_line_attributes (GdkGC       *gc,
   int xjoin_style;
   
   g_function_enter ("gdk_gc_set_line_attributes");
+
+  gdk_draw_batch_flush ();
   
   g_assert (gc);
   private = (GdkGCPrivate*) gc;
@@ -41,3 +41,4 @@ gchar            *gdk_progname = NULL;
 gint              gdk_error_code;
 gint              gdk_error_warnings = 1;
 gint              gdk_motion_events = 0;
+gint              gdk_motion_hints = 0;
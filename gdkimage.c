@@ -209,6 +209,11 @@ gdk_image_get (GdkWindow    *window,
 
   g_function_enter ("gdk_image_get");
 
+  /* Batched lines and rectangles must reach the window
+   *  before it is read back.
+   */
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_image_get");
   win_private = (GdkWindowPrivate *) window;
@@ -354,7 +359,7 @@ gdk_image_put_normal (GdkWindow *window,
   if (image->type != GDK_IMAGE_NORMAL)
     g_error ("image type is not GDK_IMAGE_NORMAL");
 
-  XPutImage (window_private->xdisplay, window_private->xwindow,
+  XPutImage (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 	     gc_private->xgc, image_private->ximage,
 	     xsrc, ysrc, xdest, ydest, width, height);
 
@@ -394,7 +399,7 @@ gdk_image_put_shared (GdkWindow *window,
   if (image->type != GDK_IMAGE_SHARED)
     g_error ("image type is not GDK_IMAGE_SHARED");
 
-  XShmPutImage (window_private->xdisplay, window_private->xwindow,
+  XShmPutImage (window_private->xdisplay, GDK_DRAWABLE_XID (window_private),
 		gc_private->xgc, image_private->ximage,
 		xsrc, ysrc, xdest, ydest, width, height, False);
 
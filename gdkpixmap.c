@@ -51,6 +51,11 @@ gdk_pixmap_new (GdkWindow *window,
   window_private = (GdkWindowPrivate*) window;
   
   private->xdisplay = window_private->xdisplay;
+  private->damage = NULL;
+  private->paint_pixmap = None;
+  private->paint_count = 0;
+  private->background = 0;
+  private->destroyed = FALSE;
   private->xwindow = XCreatePixmap (private->xdisplay, window_private->xwindow, 
 				    width, height, depth);
 
@@ -97,6 +102,11 @@ gdk_bitmap_create_from_data (GdkWindow *window,
   window_private = (GdkWindowPrivate*) window;
   
   private->xdisplay = window_private->xdisplay;
+  private->damage = NULL;
+  private->paint_pixmap = None;
+  private->paint_count = 0;
+  private->background = 0;
+  private->destroyed = FALSE;
   private->xwindow = XCreateBitmapFromData (private->xdisplay,
 					    window_private->xwindow,
 					    data, width, height);
@@ -126,6 +136,8 @@ gdk_pixmap_destroy (GdkPixmap *pixmap)
   GdkWindowPrivate *private;
   
   g_function_enter ("gdk_pixmap_destroy");
+
+  gdk_draw_batch_flush ();
   
   if (!pixmap)
     g_error ("passed NULL pixmap to gdk_pixmap_destroy");
@@ -135,7 +147,9 @@ gdk_pixmap_destroy (GdkPixmap *pixmap)
 
   pixmap->parent->children = gdk_window_remove_sibling (pixmap->parent->children, pixmap);
   gdk_window_table_remove (pixmap);
-  
+
+  if (private->damage)
+    gdk_region_destroy (private->damage);
   g_free (pixmap);
 
   g_function_leave ("gdk_pixmap_destroy");
@@ -43,9 +43,21 @@ struct _GdkWindowPrivate
   GdkWindow window;
   Window xwindow;
   Display *xdisplay;
+  GdkRegion *damage;
+  Pixmap paint_pixmap;
+  GdkRectangle paint_area;
+  gint paint_count;
+  gulong background;
   unsigned int destroyed : 1;
 };
 
+/* The X drawable that drawing into a window goes to. While the
+ *  window is being painted that is its off-screen pixmap.
+ */
+#define GDK_DRAWABLE_XID(private)  (((private)->paint_pixmap != None) ? \
+				    ((private)->paint_pixmap) : \
+				    ((private)->xwindow))
+
 struct _GdkImagePrivate
 {
   GdkImage image;
@@ -94,6 +106,9 @@ struct _GdkFontPrivate
   GdkFont font;
   XFontStruct *xfont;
   Display *xdisplay;
+  gchar *name;
+  gint ref_count;
+  gint16 widths[256];
 };
 
 struct _GdkCursorPrivate
@@ -112,11 +127,19 @@ void gdk_window_real_destroy (GdkWindow *window);
 void gdk_window_table_insert (GdkWindow *window);
 void gdk_window_table_remove (GdkWindow *window);
 GdkWindow* gdk_window_table_lookup (Window xwindow);
+void gdk_window_table_info (void);
+void gdk_window_paint_info (void);
+void gdk_font_info (void);
 GdkWindow* gdk_window_insert_sibling (GdkWindow *windows, GdkWindow *sibling);
 GdkWindow* gdk_window_remove_sibling (GdkWindow *windows, GdkWindow *sibling);
 
 void gdk_window_add_colormap_windows (GdkWindow *window);
 
+void gdk_event_scroll_exposes (GdkWindow *window,
+			       gint       dx,
+			       gint       dy,
+			       GdkRegion *invalid);
+
 
 extern gint              gdk_debug_level;
 extern gint              gdk_show_events;
@@ -133,6 +156,7 @@ extern gchar            *gdk_progname;
 extern gint              gdk_error_code;
 extern gint              gdk_error_warnings;
 extern gint              gdk_motion_events;
+extern gint              gdk_motion_hints;
 
 
 #ifdef __cplusplus
@@ -19,12 +19,23 @@
 /*
  * File:         gdkrectangle.c
  * Author:       Peter Mattis
- * Description:  This module contains the routine for determining
- *               the intersection of 2 rectangles.
+ * Description:  This module contains the routines for determining
+ *               the intersection, union and difference of 2
+ *               rectangles and for building regions out of them.
  */
 #include "gdk.h"
 
 
+/* Regions which grow beyond this many rectangles are
+ *  simplified to their extents.
+ */
+#define MAX_REGION_RECTS  32
+
+
+static void gdk_region_append (GdkRegion    *region,
+			       GdkRectangle *rect);
+
+
 gint 
 gdk_rectangle_intersect (GdkRectangle *src1, 
 			 GdkRectangle *src2, 
@@ -48,11 +59,6 @@ gdk_rectangle_intersect (GdkRectangle *src1,
 
   return_val = FALSE;
 
-  src1_x2 = src1->x + src1->width;
-  src1_y2 = src1->y + src1->height;
-  src2_x2 = src2->x + src2->width;
-  src2_y2 = src2->y + src2->height;
-
   if (src2->x < src1->x)
     {
       temp = src1;
@@ -61,6 +67,9 @@ gdk_rectangle_intersect (GdkRectangle *src1,
     }
   dest->x = src2->x;
 
+  src1_x2 = src1->x + src1->width;
+  src2_x2 = src2->x + src2->width;
+
   if (src2->x < src1_x2)
     {
       if (src1_x2 < src2_x2)
@@ -75,7 +84,10 @@ gdk_rectangle_intersect (GdkRectangle *src1,
 	  src2 = temp;
 	}
       dest->y = src2->y;
-  
+
+      src1_y2 = src1->y + src1->height;
+      src2_y2 = src2->y + src2->height;
+
       if (src2->y < src1_y2)
 	{
 	  return_val = TRUE;
@@ -90,3 +102,319 @@ gdk_rectangle_intersect (GdkRectangle *src1,
   g_function_leave ("gdk_rectangle_intersect");
   return return_val;
 }
+
+void
+gdk_rectangle_union (GdkRectangle *src1,
+		     GdkRectangle *src2,
+		     GdkRectangle *dest)
+{
+  gint x1, y1;
+  gint x2, y2;
+
+  g_function_enter ("gdk_rectangle_union");
+
+  if (!src1)
+    g_error ("passed NULL src1 to gdk_rectangle_union");
+
+  if (!src2)
+    g_error ("passed NULL src2 to gdk_rectangle_union");
+
+  if (!dest)
+    g_error ("passed NULL dest to gdk_rectangle_union");
+
+  /* The union is the smallest rectangle which contains
+   *  both "src1" and "src2". "dest" may be the same as
+   *  either of the sources.
+   */
+  x1 = MIN (src1->x, src2->x);
+  y1 = MIN (src1->y, src2->y);
+  x2 = MAX (src1->x + src1->width, src2->x + src2->width);
+  y2 = MAX (src1->y + src1->height, src2->y + src2->height);
+
+  dest->x = x1;
+  dest->y = y1;
+  dest->width = x2 - x1;
+  dest->height = y2 - y1;
+
+  g_function_leave ("gdk_rectangle_union");
+}
+
+gint
+gdk_rectangle_subtract (GdkRectangle *src,
+			GdkRectangle *sub,
+			GdkRectangle *dest)
+{
+  GdkRectangle overlap;
+  gint src_x2, src_y2;
+  gint overlap_x2, overlap_y2;
+  gint n;
+
+  g_function_enter ("gdk_rectangle_subtract");
+
+  if (!src)
+    g_error ("passed NULL src to gdk_rectangle_subtract");
+
+  if (!sub)
+    g_error ("passed NULL sub to gdk_rectangle_subtract");
+
+  if (!dest)
+    g_error ("passed NULL dest to gdk_rectangle_subtract");
+
+  /* The part of "src" not covered by "sub" is returned in
+   *  "dest" as up to 4 non-overlapping rectangles: a band above
+   *  the overlap, a band below it and the pieces to its left
+   *  and right. "dest" must have room for 4 rectangles. The
+   *  number of rectangles is returned.
+   */
+  n = 0;
+  if (!gdk_rectangle_intersect (src, sub, &overlap) ||
+      (overlap.width == 0) || (overlap.height == 0))
+    {
+      dest[n++] = *src;
+      goto done;
+    }
+
+  src_x2 = src->x + src->width;
+  src_y2 = src->y + src->height;
+  overlap_x2 = overlap.x + overlap.width;
+  overlap_y2 = overlap.y + overlap.height;
+
+  if (overlap.y > src->y)
+    {
+      dest[n].x = src->x;
+      dest[n].y = src->y;
+      dest[n].width = src->width;
+      dest[n].height = overlap.y - src->y;
+      n++;
+    }
+
+  if (overlap_y2 < src_y2)
+    {
+      dest[n].x = src->x;
+      dest[n].y = overlap_y2;
+      dest[n].width = src->width;
+      dest[n].height = src_y2 - overlap_y2;
+      n++;
+    }
+
+  if (overlap.x > src->x)
+    {
+      dest[n].x = src->x;
+      dest[n].y = overlap.y;
+      dest[n].width = overlap.x - src->x;
+      dest[n].height = overlap.height;
+      n++;
+    }
+
+  if (overlap_x2 < src_x2)
+    {
+      dest[n].x = overlap_x2;
+      dest[n].y = overlap.y;
+      dest[n].width = src_x2 - overlap_x2;
+      dest[n].height = overlap.height;
+      n++;
+    }
+
+done:
+  g_function_leave ("gdk_rectangle_subtract");
+  return n;
+}
+
+GdkRegion*
+gdk_region_new ()
+{
+  GdkRegion *region;
+
+  g_function_enter ("gdk_region_new");
+
+  region = g_new (GdkRegion, 1);
+  region->rects = NULL;
+  region->size = 0;
+  gdk_region_clear (region);
+
+  g_function_leave ("gdk_region_new");
+  return region;
+}
+
+void
+gdk_region_destroy (GdkRegion *region)
+{
+  g_function_enter ("gdk_region_destroy");
+
+  if (!region)
+    g_error ("passed NULL region to gdk_region_destroy");
+
+  g_free (region->rects);
+  g_free (region);
+
+  g_function_leave ("gdk_region_destroy");
+}
+
+void
+gdk_region_clear (GdkRegion *region)
+{
+  g_function_enter ("gdk_region_clear");
+
+  if (!region)
+    g_error ("passed NULL region to gdk_region_clear");
+
+  region->nrects = 0;
+  region->extents.x = 0;
+  region->extents.y = 0;
+  region->extents.width = 0;
+  region->extents.height = 0;
+
+  g_function_leave ("gdk_region_clear");
+}
+
+gint
+gdk_region_empty (GdkRegion *region)
+{
+  return (region->nrects == 0);
+}
+
+glong
+gdk_region_area (GdkRegion *region)
+{
+  glong area;
+  gint i;
+
+  g_function_enter ("gdk_region_area");
+
+  area = 0;
+  for (i = 0; i < region->nrects; i++)
+    area += (glong) region->rects[i].width * region->rects[i].height;
+
+  g_function_leave ("gdk_region_area");
+  return area;
+}
+
+void
+gdk_region_union_with_rect (GdkRegion    *region,
+			    GdkRectangle *rect)
+{
+  GdkRectangle buffers[2][MAX_REGION_RECTS * 4];
+  GdkRectangle *pieces;
+  GdkRectangle *new_pieces;
+  GdkRectangle *temp;
+  gint npieces;
+  gint nsplit;
+  gint i, j, k;
+
+  g_function_enter ("gdk_region_union_with_rect");
+
+  if (!region)
+    g_error ("passed NULL region to gdk_region_union_with_rect");
+
+  if (!rect)
+    g_error ("passed NULL rect to gdk_region_union_with_rect");
+
+  if ((rect->width == 0) || (rect->height == 0))
+    goto done;
+
+  if (region->nrects == 0)
+    {
+      gdk_region_append (region, rect);
+      region->extents = *rect;
+      goto done;
+    }
+
+  /* Cut away the parts of "rect" which the region already
+   *  covers so that the rectangles stay non-overlapping.
+   */
+  pieces = buffers[0];
+  new_pieces = buffers[1];
+  pieces[0] = *rect;
+  npieces = 1;
+
+  for (i = 0; (i < region->nrects) && (npieces > 0); i++)
+    {
+      k = 0;
+      for (j = 0; j < npieces; j++)
+	{
+	  if ((k + 4) > (MAX_REGION_RECTS * 4))
+	    {
+	      npieces = -1;
+	      break;
+	    }
+
+	  nsplit = gdk_rectangle_subtract (&pieces[j], &region->rects[i], &new_pieces[k]);
+	  k += nsplit;
+	}
+
+      if (npieces < 0)
+	break;
+
+      temp = pieces;
+      pieces = new_pieces;
+      new_pieces = temp;
+      npieces = k;
+    }
+
+  gdk_rectangle_union (&region->extents, rect, &region->extents);
+
+  /* A region that gets too complicated is simply replaced
+   *  by its extents.
+   */
+  if ((npieces < 0) || ((region->nrects + npieces) > MAX_REGION_RECTS))
+    {
+      region->nrects = 0;
+      gdk_region_append (region, &region->extents);
+    }
+  else
+    for (i = 0; i < npieces; i++)
+      gdk_region_append (region, &pieces[i]);
+
+done:
+  g_function_leave ("gdk_region_union_with_rect");
+}
+
+void
+gdk_region_subtract_rect (GdkRegion    *region,
+			  GdkRectangle *rect)
+{
+  GdkRectangle *old_rects;
+  GdkRectangle split[4];
+  gint old_nrects;
+  gint nsplit;
+  gint i, j;
+
+  g_function_enter ("gdk_region_subtract_rect");
+
+  if (!region)
+    g_error ("passed NULL region to gdk_region_subtract_rect");
+
+  if (!rect)
+    g_error ("passed NULL rect to gdk_region_subtract_rect");
+
+  old_rects = region->rects;
+  old_nrects = region->nrects;
+
+  region->rects = NULL;
+  region->size = 0;
+  gdk_region_clear (region);
+
+  for (i = 0; i < old_nrects; i++)
+    {
+      nsplit = gdk_rectangle_subtract (&old_rects[i], rect, split);
+      for (j = 0; j < nsplit; j++)
+	gdk_region_union_with_rect (region, &split[j]);
+    }
+
+  g_free (old_rects);
+
+  g_function_leave ("gdk_region_subtract_rect");
+}
+
+static void
+gdk_region_append (GdkRegion    *region,
+		   GdkRectangle *rect)
+{
+  if (region->nrects == region->size)
+    {
+      region->size = (region->size) ? (region->size * 2) : 4;
+      region->rects = g_realloc (region->rects, sizeof (GdkRectangle) * region->size);
+    }
+
+  region->rects[region->nrects++] = *rect;
+}
@@ -42,6 +42,7 @@ typedef struct _GdkImage          GdkImage;
 typedef struct _GdkGC             GdkGC;
 typedef struct _GdkPoint          GdkPoint;
 typedef struct _GdkRectangle      GdkRectangle;
+typedef struct _GdkRegion         GdkRegion;
 typedef struct _GdkSegment        GdkSegment;
 typedef struct _GdkFont           GdkFont;
 typedef struct _GdkCursor         GdkCursor;
@@ -505,6 +506,17 @@ struct _GdkRectangle
   guint16 height;
 };
 
+/* A region is a set of non-overlapping rectangles.
+ *  "extents" is the smallest rectangle containing all of them.
+ */
+struct _GdkRegion
+{
+  GdkRectangle extents;
+  GdkRectangle *rects;
+  gint nrects;
+  gint size;
+};
+
 struct _GdkSegment
 {
   gint16 x1;
@@ -545,6 +557,8 @@ struct _GdkEventMotion
   guint32 time;
   gint16 x;
   gint16 y;
+  gint16 x_root;
+  gint16 y_root;
   guint state;
   gint16 is_hint;
 };
@@ -556,6 +570,8 @@ struct _GdkEventButton
   guint32 time;
   gint16 x;
   gint16 y;
+  gint16 x_root;
+  gint16 y_root;
   guint state;
   guint button;
 };
@@ -30,7 +30,84 @@
 #include "gdkprivate.h"
 
 
-static XContext xcontext;
+#define PAINT_POOL_MAX     32
+#define PAINT_POOL_BYTES   (32 * 1024 * 1024)
+#define PAINT_BUCKET_MIN   64
+#define PAINT_BUFFER_MAX   4096
+
+
+typedef struct _GdkWindowTableEntry GdkWindowTableEntry;
+typedef struct _GdkPaintBuffer      GdkPaintBuffer;
+typedef struct _GdkScrollWait       GdkScrollWait;
+
+struct _GdkWindowTableEntry
+{
+  Window xwindow;
+  GdkWindow *window;
+};
+
+struct _GdkPaintBuffer
+{
+  Pixmap xpixmap;
+  GC xgc;
+  gint width;
+  gint height;
+  gint depth;
+  gint in_use;
+  gulong bytes;
+};
+
+struct _GdkScrollWait
+{
+  Window xwindow;
+  unsigned long serial;
+};
+
+static guint gdk_window_table_hash   (Window xwindow);
+static void  gdk_window_table_resize (guint  size);
+
+static GdkPaintBuffer* gdk_paint_buffer_get     (gint       depth,
+						 gint       width,
+						 gint       height);
+static GdkPaintBuffer* gdk_paint_buffer_find    (Pixmap     xpixmap);
+static void            gdk_paint_buffer_release (Pixmap     xpixmap);
+static void            gdk_paint_buffer_destroy (gint       index);
+
+static Bool gdk_window_scroll_predicate (Display *display,
+					 XEvent  *xevent,
+					 XPointer arg);
+
+static GdkWindow* gdk_window_child_offset (GdkWindow *window,
+					   gint      *x,
+					   gint      *y);
+
+/* The table mapping X window ids to GdkWindows (and GdkPixmaps).
+ *  It is an open addressing hash table using linear probing and
+ *  its size is always a power of 2. The last window found is
+ *  remembered since events tend to arrive in runs for the same
+ *  window.
+ */
+static GdkWindowTableEntry *window_table = NULL;
+static guint window_table_size = 0;
+static guint window_table_count = 0;
+static Window last_xwindow = None;
+static GdkWindow *last_window = NULL;
+static gulong window_table_lookups = 0;
+static gulong window_table_cache_hits = 0;
+
+/* The off-screen pixmaps windows are painted into. A pixmap is
+ *  handed to any window of the same depth that fits in it. The
+ *  pool never holds more than "paint_pool_limit" pixmaps, nor
+ *  more than PAINT_POOL_BYTES of them in "paint_pool_bytes".
+ *  Windows wider or taller than PAINT_BUFFER_MAX (a list with
+ *  many rows, say) are drawn to directly.
+ */
+static GdkPaintBuffer paint_pool[PAINT_POOL_MAX];
+static gint paint_pool_size = 0;
+static gulong paint_pool_bytes = 0;
+static gint paint_pool_limit = 8;
+static gulong paint_pool_hits = 0;
+static gulong paint_pool_misses = 0;
 
 int nevent_masks = 15;
 int event_mask_table[15] =
@@ -65,8 +142,6 @@ gdk_window_init ()
 
   g_function_enter ("gdk_window_init");
 
-  xcontext = 1;
-
   XGetGeometry (gdk_display, gdk_root_window, &gdk_root_window,
 		&x, &y, &width, &height, &border_width, &depth);
   XGetWindowAttributes (gdk_display, gdk_root_window, &xattributes);
@@ -130,6 +205,10 @@ gdk_window_new (GdkWindow     *parent,
   window = (GdkWindow*) private;
 
   private->xdisplay = parent_display;
+  private->damage = NULL;
+  private->paint_pixmap = None;
+  private->paint_count = 0;
+  private->background = BlackPixel (gdk_display, gdk_screen);
   private->destroyed = FALSE;
   xattributes_mask = 0;
 
@@ -165,6 +244,8 @@ gdk_window_new (GdkWindow     *parent,
     }
 
   xattributes.event_mask |= StructureNotifyMask;
+  if (!gdk_motion_hints)
+    xattributes.event_mask &= ~PointerMotionHintMask;
   if (gdk_motion_events &&
       !(attributes->event_mask & GDK_POINTER_MOTION_HINT_MASK))
     xattributes.event_mask |= PointerMotionMask;
@@ -182,7 +263,7 @@ gdk_window_new (GdkWindow     *parent,
       else
 	window->colormap = parent->colormap;
 
-      xattributes.background_pixel = BlackPixel (gdk_display, gdk_screen);
+      xattributes.background_pixel = private->background;
       xattributes.border_pixel = BlackPixel (gdk_display, gdk_screen);
       xattributes_mask |= CWBorderPixel | CWBackPixel;
 
@@ -299,6 +380,8 @@ gdk_window_destroy (GdkWindow *window)
 
   g_function_enter ("gdk_window_destroy");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_window_destroy");
 
@@ -349,6 +432,10 @@ gdk_window_real_destroy (GdkWindow *window)
   window->parent->children = gdk_window_remove_sibling (window->parent->children, window);
   gdk_window_table_remove (window);
 
+  if (((GdkWindowPrivate*) window)->paint_pixmap != None)
+    gdk_paint_buffer_release (((GdkWindowPrivate*) window)->paint_pixmap);
+  if (((GdkWindowPrivate*) window)->damage)
+    gdk_region_destroy (((GdkWindowPrivate*) window)->damage);
   g_free (window);
 
   g_function_leave ("gdk_real_window_destroy");
@@ -443,12 +530,17 @@ gdk_window_clear (GdkWindow *window)
 
   g_function_enter ("gdk_window_clear");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_window_clear");
 
   private = (GdkWindowPrivate*) window;
 
-  XClearWindow (private->xdisplay, private->xwindow);
+  if (private->paint_pixmap != None)
+    gdk_window_clear_area (window, 0, 0, window->width, window->height);
+  else
+    XClearWindow (private->xdisplay, private->xwindow);
 
   g_function_leave ("gdk_window_clear");
 }
@@ -461,16 +553,35 @@ gdk_window_clear_area (GdkWindow *window,
 		       gint       height)
 {
   GdkWindowPrivate *private;
+  GdkPaintBuffer *buffer;
 
   g_function_enter ("gdk_window_clear_area");
 
+  gdk_draw_batch_flush ();
+
   if (!window)
     g_error ("passed NULL window to gdk_window_clear_area");
 
   private = (GdkWindowPrivate*) window;
 
-  XClearArea (private->xdisplay, private->xwindow,
-	      x, y, width, height, False);
+  if (private->paint_pixmap != None)
+    {
+      /* As with XClearArea a width or height of 0 means
+       *  the rest of the window.
+       */
+      if (width == 0)
+	width = window->width - x;
+      if (height == 0)
+	height = window->height - y;
+
+      buffer = gdk_paint_buffer_find (private->paint_pixmap);
+      XSetForeground (private->xdisplay, buffer->xgc, private->background);
+      XFillRectangle (private->xdisplay, GDK_DRAWABLE_XID (private),
+		      buffer->xgc, x, y, width, height);
+    }
+  else
+    XClearArea (private->xdisplay, private->xwindow,
+		x, y, width, height, False);
 
   g_function_leave ("gdk_window_clear_area");
 }
@@ -642,6 +753,7 @@ gdk_window_set_background (GdkWindow *window,
     g_error ("passed NULL window to gdk_window_set_background");
 
   private = (GdkWindowPrivate*) window;
+  private->background = color->pixel;
   XSetWindowBackground (private->xdisplay, private->xwindow, color->pixel);
 
   g_function_leave ("gdk_window_set_background");
@@ -744,6 +856,30 @@ gdk_window_get_origin (GdkWindow *window,
   return return_val;
 }
 
+/* Returns the outermost non child window above "window" and
+ *  the position of "window" within it.
+ */
+static GdkWindow*
+gdk_window_child_offset (GdkWindow *window,
+			 gint      *x,
+			 gint      *y)
+{
+  g_function_enter ("gdk_window_child_offset");
+
+  *x = 0;
+  *y = 0;
+
+  while (window && (window->window_type == GDK_WINDOW_CHILD))
+    {
+      *x += window->x;
+      *y += window->y;
+      window = window->parent;
+    }
+
+  g_function_leave ("gdk_window_child_offset");
+  return window;
+}
+
 GdkWindow*
 gdk_window_get_pointer (GdkWindow       *window,
 			gint            *x,
@@ -781,6 +917,91 @@ gdk_window_get_pointer (GdkWindow       *window,
   return return_val;
 }
 
+/* Gets the position of the pointer for a motion event relative
+ *  to "window". Normally this is worked out from the event alone,
+ *  using the positions gdk keeps for child windows. Motion hints
+ *  (which carry no useful position), synthetic events and windows
+ *  in different toplevels ask the server instead.
+ */
+void
+gdk_event_get_pointer (GdkEvent        *event,
+		       GdkWindow       *window,
+		       gint            *x,
+		       gint            *y,
+		       GdkModifierType *mask)
+{
+  GdkWindow *src_top;
+  GdkWindow *dest_top;
+  gint src_x, src_y;
+  gint dest_x, dest_y;
+
+  g_function_enter ("gdk_event_get_pointer");
+
+  if (!event || (event->type != GDK_MOTION_NOTIFY))
+    g_error ("passed a non motion event to gdk_event_get_pointer");
+  if (!window)
+    g_error ("passed NULL window to gdk_event_get_pointer");
+
+  src_top = NULL;
+  dest_top = NULL;
+
+  if (!event->motion.is_hint && !event->any.send_event)
+    {
+      src_top = gdk_window_child_offset (event->any.window, &src_x, &src_y);
+      dest_top = gdk_window_child_offset (window, &dest_x, &dest_y);
+    }
+
+  if (src_top && (src_top == dest_top))
+    {
+      if (x) *x = event->motion.x + src_x - dest_x;
+      if (y) *y = event->motion.y + src_y - dest_y;
+      if (mask) *mask = event->motion.state;
+    }
+  else
+    {
+      gdk_window_get_pointer (window, x, y, mask);
+    }
+
+  g_function_leave ("gdk_event_get_pointer");
+}
+
+/* Gets the position of the pointer for a motion event relative
+ *  to "window", a window which may have been moved since the
+ *  event was generated. "origin_x" and "origin_y" give the root
+ *  position of the parent of "window", found when it last stood
+ *  still, so that the root position in the event can be used.
+ *  Motion hints and synthetic events ask the server.
+ */
+void
+gdk_event_get_root_pointer (GdkEvent        *event,
+			    GdkWindow       *window,
+			    gint             origin_x,
+			    gint             origin_y,
+			    gint            *x,
+			    gint            *y,
+			    GdkModifierType *mask)
+{
+  g_function_enter ("gdk_event_get_root_pointer");
+
+  if (!event || (event->type != GDK_MOTION_NOTIFY))
+    g_error ("passed a non motion event to gdk_event_get_root_pointer");
+  if (!window)
+    g_error ("passed NULL window to gdk_event_get_root_pointer");
+
+  if (event->motion.is_hint || event->any.send_event)
+    {
+      gdk_window_get_pointer (window, x, y, mask);
+    }
+  else
+    {
+      if (x) *x = event->motion.x_root - origin_x - window->x;
+      if (y) *y = event->motion.y_root - origin_y - window->y;
+      if (mask) *mask = event->motion.state;
+    }
+
+  g_function_leave ("gdk_event_get_root_pointer");
+}
+
 GdkWindow*
 gdk_window_get_parent (GdkWindow *window)
 {
@@ -808,6 +1029,272 @@ gdk_window_get_toplevel (GdkWindow *window)
   return window;
 }
 
+/* Scrolls the contents of "window" by "dx" and "dy" with a single
+ *  XCopyArea. What the copy can't fill in, the strip uncovered
+ *  by the scroll and anything the server couldn't copy because
+ *  it was obscured, is added to "invalid" for the caller to
+ *  redraw. Exposes which haven't been delivered yet refer to the
+ *  old contents, so they are moved along and added as well.
+ */
+void
+gdk_window_scroll (GdkWindow *window,
+		   gint       dx,
+		   gint       dy,
+		   GdkRegion *invalid)
+{
+  GdkWindowPrivate *private;
+  GdkScrollWait wait;
+  GdkRectangle area;
+  XGCValues values;
+  XEvent xevent;
+  GC xgc;
+  gint width, height;
+  gint i;
+
+  g_function_enter ("gdk_window_scroll");
+
+  gdk_draw_batch_flush ();
+
+  if (!window)
+    g_error ("passed NULL window to gdk_window_scroll");
+
+  if (!invalid)
+    g_error ("passed NULL region to gdk_window_scroll");
+
+  private = (GdkWindowPrivate*) window;
+  width = window->width;
+  height = window->height;
+
+  if (private->destroyed)
+    goto done;
+
+  if ((ABS (dx) >= width) || (ABS (dy) >= height))
+    {
+      area.x = 0;
+      area.y = 0;
+      area.width = width;
+      area.height = height;
+      gdk_region_union_with_rect (invalid, &area);
+      goto done;
+    }
+
+  values.graphics_exposures = True;
+  xgc = XCreateGC (private->xdisplay, private->xwindow, GCGraphicsExposures, &values);
+
+  wait.xwindow = private->xwindow;
+  wait.serial = NextRequest (private->xdisplay);
+
+  XCopyArea (private->xdisplay, private->xwindow, private->xwindow, xgc,
+	     MAX (-dx, 0), MAX (-dy, 0),
+	     width - ABS (dx), height - ABS (dy),
+	     MAX (dx, 0), MAX (dy, 0));
+  XFreeGC (private->xdisplay, xgc);
+
+  if (dx != 0)
+    {
+      area.x = (dx > 0) ? (0) : (width + dx);
+      area.y = 0;
+      area.width = ABS (dx);
+      area.height = height;
+      gdk_region_union_with_rect (invalid, &area);
+    }
+
+  if (dy != 0)
+    {
+      area.x = 0;
+      area.y = (dy > 0) ? (0) : (height + dy);
+      area.width = width;
+      area.height = ABS (dy);
+      gdk_region_union_with_rect (invalid, &area);
+    }
+
+  while (XCheckTypedWindowEvent (private->xdisplay, private->xwindow, Expose, &xevent))
+    {
+      area.x = xevent.xexpose.x + dx;
+      area.y = xevent.xexpose.y + dy;
+      area.width = xevent.xexpose.width;
+      area.height = xevent.xexpose.height;
+      gdk_region_union_with_rect (invalid, &area);
+    }
+
+  gdk_event_scroll_exposes (window, dx, dy, invalid);
+
+  if (private->damage)
+    {
+      for (i = 0; i < private->damage->nrects; i++)
+	{
+	  area = private->damage->rects[i];
+	  area.x += dx;
+	  area.y += dy;
+	  gdk_region_union_with_rect (invalid, &area);
+	}
+      gdk_region_clear (private->damage);
+    }
+
+  /* The server answers the copy with either a NoExpose or a
+   *  run of GraphicsExpose events ending with a count of 0.
+   */
+  while (1)
+    {
+      XIfEvent (private->xdisplay, &xevent, gdk_window_scroll_predicate, (XPointer) &wait);
+      if (xevent.type == NoExpose)
+	break;
+
+      area.x = xevent.xgraphicsexpose.x;
+      area.y = xevent.xgraphicsexpose.y;
+      area.width = xevent.xgraphicsexpose.width;
+      area.height = xevent.xgraphicsexpose.height;
+      gdk_region_union_with_rect (invalid, &area);
+
+      if (xevent.xgraphicsexpose.count == 0)
+	break;
+    }
+
+done:
+  g_function_leave ("gdk_window_scroll");
+}
+
+/* Between "gdk_window_begin_paint" and "gdk_window_end_paint"
+ *  drawing into the window goes to an off-screen pixmap which
+ *  starts out as a copy of "area". When the last paint ends the
+ *  area is copied back to the window in one go. Calls nest and
+ *  the area painted is the union of their areas.
+ */
+void
+gdk_window_begin_paint (GdkWindow    *window,
+			GdkRectangle *area)
+{
+  GdkWindowPrivate *private;
+  GdkPaintBuffer *buffer;
+  GdkRectangle clip;
+  gint x2, y2;
+
+  g_function_enter ("gdk_window_begin_paint");
+
+  if (!window)
+    g_error ("passed NULL window to gdk_window_begin_paint");
+
+  if (!area)
+    g_error ("passed NULL area to gdk_window_begin_paint");
+
+  private = (GdkWindowPrivate*) window;
+
+  clip.x = MAX (area->x, 0);
+  clip.y = MAX (area->y, 0);
+  x2 = MIN (area->x + area->width, window->width);
+  y2 = MIN (area->y + area->height, window->height);
+  clip.width = MAX (x2 - clip.x, 0);
+  clip.height = MAX (y2 - clip.y, 0);
+
+  private->paint_count += 1;
+
+  if (private->paint_count > 1)
+    {
+      if (private->paint_pixmap != None)
+	{
+	  x2 = MAX (clip.x + clip.width, private->paint_area.x + private->paint_area.width);
+	  y2 = MAX (clip.y + clip.height, private->paint_area.y + private->paint_area.height);
+	  private->paint_area.x = MIN (clip.x, private->paint_area.x);
+	  private->paint_area.y = MIN (clip.y, private->paint_area.y);
+	  private->paint_area.width = x2 - private->paint_area.x;
+	  private->paint_area.height = y2 - private->paint_area.y;
+	}
+    }
+  else if (!private->destroyed &&
+	   (window->window_type != GDK_WINDOW_PIXMAP) &&
+	   (window->depth > 0))
+    {
+      buffer = gdk_paint_buffer_get (window->depth, window->width, window->height);
+      if (buffer)
+	{
+	  gdk_draw_batch_flush ();
+
+	  private->paint_pixmap = buffer->xpixmap;
+	  private->paint_area = clip;
+
+	  XCopyArea (private->xdisplay, private->xwindow,
+		     GDK_DRAWABLE_XID (private), buffer->xgc,
+		     clip.x, clip.y, clip.width, clip.height,
+		     clip.x, clip.y);
+	}
+    }
+
+  g_function_leave ("gdk_window_begin_paint");
+}
+
+void
+gdk_window_end_paint (GdkWindow *window)
+{
+  GdkWindowPrivate *private;
+  GdkPaintBuffer *buffer;
+  GdkRectangle *area;
+
+  g_function_enter ("gdk_window_end_paint");
+
+  if (!window)
+    g_error ("passed NULL window to gdk_window_end_paint");
+
+  private = (GdkWindowPrivate*) window;
+
+  if (private->paint_count <= 0)
+    g_error ("unbalanced call to gdk_window_end_paint");
+
+  private->paint_count -= 1;
+
+  if ((private->paint_count == 0) && (private->paint_pixmap != None))
+    {
+      gdk_draw_batch_flush ();
+
+      buffer = gdk_paint_buffer_find (private->paint_pixmap);
+      area = &private->paint_area;
+
+      if (!private->destroyed)
+	XCopyArea (private->xdisplay, GDK_DRAWABLE_XID (private),
+		   private->xwindow, buffer->xgc,
+		   area->x, area->y, area->width, area->height,
+		   area->x, area->y);
+
+      gdk_paint_buffer_release (private->paint_pixmap);
+      private->paint_pixmap = None;
+    }
+
+  g_function_leave ("gdk_window_end_paint");
+}
+
+/* Setting the pool size to 0 turns off painting into off-screen
+ *  pixmaps. Pixmaps which are not in use beyond the new size are
+ *  freed right away; the rest are freed as they are given back.
+ */
+void
+gdk_window_set_paint_pool_size (gint size)
+{
+  gint i;
+
+  g_function_enter ("gdk_window_set_paint_pool_size");
+
+  paint_pool_limit = MAX (MIN (size, PAINT_POOL_MAX), 0);
+
+  for (i = paint_pool_size - 1; (i >= 0) && (paint_pool_size > paint_pool_limit); i--)
+    if (!paint_pool[i].in_use)
+      gdk_paint_buffer_destroy (i);
+
+  g_function_leave ("gdk_window_set_paint_pool_size");
+}
+
+void
+gdk_window_get_paint_stats (gulong *hits,
+			    gulong *misses)
+{
+  g_function_enter ("gdk_window_get_paint_stats");
+
+  if (hits)
+    *hits = paint_pool_hits;
+  if (misses)
+    *misses = paint_pool_misses;
+
+  g_function_leave ("gdk_window_get_paint_stats");
+}
+
 
 GdkWindow*
 gdk_window_find (Window xwindow)
@@ -826,7 +1313,7 @@ void
 gdk_window_table_insert (GdkWindow *window)
 {
   GdkWindowPrivate *private;
-  int val;
+  guint index;
 
   g_function_enter ("gdk_window_table_insert");
 
@@ -835,8 +1322,25 @@ gdk_window_table_insert (GdkWindow *window)
 
   private = (GdkWindowPrivate*) window;
 
-  val = XSaveContext (private->xdisplay, private->xwindow,
-		      xcontext, (XPointer) window);
+  /* Keep the load factor below 1/2 so that probe sequences
+   *  stay short.
+   */
+  if ((window_table_count + 1) * 2 > window_table_size)
+    gdk_window_table_resize ((window_table_size) ? (window_table_size * 2) : 256);
+
+  index = gdk_window_table_hash (private->xwindow);
+  while (window_table[index].window &&
+	 (window_table[index].xwindow != private->xwindow))
+    index = (index + 1) & (window_table_size - 1);
+
+  if (!window_table[index].window)
+    window_table_count += 1;
+
+  window_table[index].xwindow = private->xwindow;
+  window_table[index].window = window;
+
+  if (last_xwindow == private->xwindow)
+    last_window = window;
 
   g_function_leave ("gdk_window_table_insert");
 }
@@ -845,7 +1349,9 @@ void
 gdk_window_table_remove (GdkWindow *window)
 {
   GdkWindowPrivate *private;
-  int val;
+  guint index;
+  guint next;
+  guint home;
 
   g_function_enter ("gdk_window_table_remove");
 
@@ -853,24 +1359,200 @@ gdk_window_table_remove (GdkWindow *window)
     g_error ("passed NULL window to gdk_window_table_remove");
 
   private = (GdkWindowPrivate*) window;
-  val = XDeleteContext (private->xdisplay, private->xwindow, xcontext);
 
+  if (last_xwindow == private->xwindow)
+    {
+      last_xwindow = None;
+      last_window = NULL;
+    }
+
+  if (!window_table_count)
+    goto done;
+
+  index = gdk_window_table_hash (private->xwindow);
+  while (window_table[index].window &&
+	 (window_table[index].xwindow != private->xwindow))
+    index = (index + 1) & (window_table_size - 1);
+
+  if (!window_table[index].window)
+    goto done;
+
+  /* Remove the entry by shifting back any entries after it
+   *  in the probe sequence which would no longer be found.
+   *  This way the table never needs tombstones.
+   */
+  next = index;
+  while (1)
+    {
+      next = (next + 1) & (window_table_size - 1);
+      if (!window_table[next].window)
+	break;
+
+      home = gdk_window_table_hash (window_table[next].xwindow);
+      if (((next - home) & (window_table_size - 1)) >=
+	  ((next - index) & (window_table_size - 1)))
+	{
+	  window_table[index] = window_table[next];
+	  index = next;
+	}
+    }
+
+  window_table[index].xwindow = None;
+  window_table[index].window = NULL;
+  window_table_count -= 1;
+
+ done:
   g_function_leave ("gdk_window_table_remove");
 }
 
+/* This is called for every event we receive, so it doesn't
+ *  bother with "g_function_enter" and "g_function_leave".
+ */
 GdkWindow*
 gdk_window_table_lookup (Window xwindow)
 {
-  GdkWindow *window;
-  int val;
+  guint index;
 
-  g_function_enter ("gdk_window_table_lookup");
+  window_table_lookups += 1;
 
-  val = XFindContext (gdk_display, xwindow,
-		      xcontext, (XPointer*) &window);
+  if ((xwindow == last_xwindow) && last_window)
+    {
+      window_table_cache_hits += 1;
+      return last_window;
+    }
 
-  g_function_leave ("gdk_window_table_lookup");
-  return window;
+  if (!window_table_count)
+    return NULL;
+
+  index = gdk_window_table_hash (xwindow);
+  while (window_table[index].window)
+    {
+      if (window_table[index].xwindow == xwindow)
+	{
+	  last_xwindow = xwindow;
+	  last_window = window_table[index].window;
+	  return last_window;
+	}
+
+      index = (index + 1) & (window_table_size - 1);
+    }
+
+  return NULL;
+}
+
+/*
+ * Print the number of windows in the table, its load factor,
+ *  the average and longest probe sequences and how often the
+ *  last window cache was hit.
+ */
+void
+gdk_window_table_info ()
+{
+  guint index;
+  guint probe;
+  guint max_probe;
+  gulong total_probe;
+
+  g_function_enter ("gdk_window_table_info");
+
+  max_probe = 0;
+  total_probe = 0;
+
+  for (index = 0; index < window_table_size; index++)
+    if (window_table[index].window)
+      {
+	probe = ((index - gdk_window_table_hash (window_table[index].xwindow)) &
+		 (window_table_size - 1)) + 1;
+
+	total_probe += probe;
+	max_probe = MAX (max_probe, probe);
+      }
+
+  g_message ("window table: %d windows in %d slots (load factor %.2f)",
+	     window_table_count, window_table_size,
+	     (window_table_size) ? ((gdouble) window_table_count / window_table_size) : 0.0);
+  g_message ("window table: average probe length %.2f, longest probe length %d",
+	     (window_table_count) ? ((gdouble) total_probe / window_table_count) : 0.0,
+	     max_probe);
+  g_message ("window table: %ld lookups, %ld last window cache hits",
+	     window_table_lookups, window_table_cache_hits);
+
+  g_function_leave ("gdk_window_table_info");
+}
+
+/*
+ * Print the pixmaps in the paint pool and how often painting
+ *  found one it could reuse.
+ */
+void
+gdk_window_paint_info ()
+{
+  gint i;
+
+  g_function_enter ("gdk_window_paint_info");
+
+  for (i = 0; i < paint_pool_size; i++)
+    g_message ("paint pool: %dx%d depth %d%s",
+	       paint_pool[i].width, paint_pool[i].height, paint_pool[i].depth,
+	       (paint_pool[i].in_use) ? (" (in use)") : (""));
+
+  g_message ("paint pool: %d of %d pixmaps, %ld of %ld bytes, %ld hits, %ld misses (hit rate %.2f)",
+	     paint_pool_size, paint_pool_limit, paint_pool_bytes, (gulong) PAINT_POOL_BYTES,
+	     paint_pool_hits, paint_pool_misses,
+	     (paint_pool_hits + paint_pool_misses) ?
+	     ((gdouble) paint_pool_hits / (paint_pool_hits + paint_pool_misses)) : 0.0);
+
+  g_function_leave ("gdk_window_paint_info");
+}
+
+static guint
+gdk_window_table_hash (Window xwindow)
+{
+  guint64 key;
+
+  /* XIDs from one client share their high bits and count up
+   *  in their low bits, so mix them before masking.
+   */
+  key = xwindow;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+
+  return (guint) key & (window_table_size - 1);
+}
+
+static void
+gdk_window_table_resize (guint size)
+{
+  GdkWindowTableEntry *old_table;
+  guint old_size;
+  guint index;
+  guint i;
+
+  old_table = window_table;
+  old_size = window_table_size;
+
+  window_table = g_new (GdkWindowTableEntry, size);
+  window_table_size = size;
+
+  for (i = 0; i < size; i++)
+    {
+      window_table[i].xwindow = None;
+      window_table[i].window = NULL;
+    }
+
+  for (i = 0; i < old_size; i++)
+    if (old_table[i].window)
+      {
+	index = gdk_window_table_hash (old_table[i].xwindow);
+	while (window_table[index].window)
+	  index = (index + 1) & (window_table_size - 1);
+
+	window_table[index] = old_table[i];
+      }
+
+  if (old_table)
+    g_free (old_table);
 }
 
 GdkWindow*
@@ -963,3 +1645,186 @@ gdk_window_add_colormap_windows (GdkWindow *window)
  done:
   g_function_leave ("gdk_window_add_colormap_windows");
 }
+
+/* Returns the smallest free pixmap of the right depth that is at
+ *  least "width" by "height". A new pixmap is rounded up to a
+ *  power of 2 in each direction so that windows of similar sizes
+ *  share it. If the pool is full free pixmaps are thrown out to
+ *  make room. NULL is returned, and the caller draws straight to
+ *  the window, if there still isn't room or the window is larger
+ *  than PAINT_BUFFER_MAX (which also keeps clear of the server's
+ *  limit on pixmap sizes).
+ */
+static GdkPaintBuffer*
+gdk_paint_buffer_get (gint depth,
+		      gint width,
+		      gint height)
+{
+  GdkPaintBuffer *buffer;
+  XGCValues values;
+  gulong bytes;
+  gint best;
+  gint i;
+
+  g_function_enter ("gdk_paint_buffer_get");
+
+  buffer = NULL;
+  if ((paint_pool_limit == 0) ||
+      (width > PAINT_BUFFER_MAX) ||
+      (height > PAINT_BUFFER_MAX))
+    goto done;
+
+  best = -1;
+  for (i = 0; i < paint_pool_size; i++)
+    {
+      buffer = &paint_pool[i];
+
+      if (!buffer->in_use &&
+	  (buffer->depth == depth) &&
+	  (buffer->width >= width) &&
+	  (buffer->height >= height) &&
+	  ((best == -1) ||
+	   ((buffer->width * buffer->height) <
+	    (paint_pool[best].width * paint_pool[best].height))))
+	best = i;
+    }
+
+  if (best != -1)
+    {
+      paint_pool_hits += 1;
+      buffer = &paint_pool[best];
+      buffer->in_use = TRUE;
+      goto done;
+    }
+
+  paint_pool_misses += 1;
+  buffer = NULL;
+
+  for (i = PAINT_BUCKET_MIN; i < width; i <<= 1)
+    ;
+  width = i;
+  for (i = PAINT_BUCKET_MIN; i < height; i <<= 1)
+    ;
+  height = i;
+
+  /* The size the server needs for the pixmap, roughly. Pixels
+   *  are padded out to 1, 2 or 4 bytes.
+   */
+  bytes = (gulong) width * height * ((depth > 16) ? 4 : ((depth > 8) ? 2 : 1));
+
+  /* Destroying a pixmap moves the last one into its slot, so "i"
+   *  only moves on past pixmaps which are in use.
+   */
+  i = 0;
+  while ((i < paint_pool_size) &&
+	 ((paint_pool_size >= paint_pool_limit) ||
+	  (paint_pool_bytes + bytes > PAINT_POOL_BYTES)))
+    {
+      if (!paint_pool[i].in_use)
+	gdk_paint_buffer_destroy (i);
+      else
+	i++;
+    }
+
+  if ((paint_pool_size >= paint_pool_limit) ||
+      (paint_pool_bytes + bytes > PAINT_POOL_BYTES))
+    goto done;
+
+  buffer = &paint_pool[paint_pool_size++];
+  buffer->xpixmap = XCreatePixmap (gdk_display, gdk_root_window, width, height, depth);
+  buffer->width = width;
+  buffer->height = height;
+  buffer->depth = depth;
+  buffer->in_use = TRUE;
+  buffer->bytes = bytes;
+  paint_pool_bytes += bytes;
+
+  values.graphics_exposures = False;
+  buffer->xgc = XCreateGC (gdk_display, buffer->xpixmap, GCGraphicsExposures, &values);
+
+done:
+  g_function_leave ("gdk_paint_buffer_get");
+  return buffer;
+}
+
+static GdkPaintBuffer*
+gdk_paint_buffer_find (Pixmap xpixmap)
+{
+  gint i;
+
+  g_function_enter ("gdk_paint_buffer_find");
+
+  for (i = 0; i < paint_pool_size; i++)
+    if (paint_pool[i].xpixmap == xpixmap)
+      break;
+
+  if (i == paint_pool_size)
+    g_error ("pixmap is not in the paint pool");
+
+  g_function_leave ("gdk_paint_buffer_find");
+  return &paint_pool[i];
+}
+
+/* Gives a pixmap back to the pool. If the pool has been made
+ *  smaller while it was in use it is freed instead.
+ */
+static void
+gdk_paint_buffer_release (Pixmap xpixmap)
+{
+  GdkPaintBuffer *buffer;
+
+  g_function_enter ("gdk_paint_buffer_release");
+
+  buffer = gdk_paint_buffer_find (xpixmap);
+  buffer->in_use = FALSE;
+
+  if (paint_pool_size > paint_pool_limit)
+    gdk_paint_buffer_destroy (buffer - paint_pool);
+
+  g_function_leave ("gdk_paint_buffer_release");
+}
+
+/* The last pixmap in the pool is moved into the freed slot. That
+ *  is safe because windows being painted refer to their pixmap,
+ *  not to its slot.
+ */
+static void
+gdk_paint_buffer_destroy (gint index)
+{
+  g_function_enter ("gdk_paint_buffer_destroy");
+
+  XFreeGC (gdk_display, paint_pool[index].xgc);
+  XFreePixmap (gdk_display, paint_pool[index].xpixmap);
+
+  paint_pool_bytes -= paint_pool[index].bytes;
+  paint_pool_size -= 1;
+  paint_pool[index] = paint_pool[paint_pool_size];
+
+  g_function_leave ("gdk_paint_buffer_destroy");
+}
+
+/* Picks out the NoExpose or GraphicsExpose events sent in
+ *  reply to the copy made by "gdk_window_scroll".
+ */
+static Bool
+gdk_window_scroll_predicate (Display *display,
+			     XEvent  *xevent,
+			     XPointer arg)
+{
+  GdkScrollWait *wait;
+
+  wait = (GdkScrollWait*) arg;
+
+  if ((long) (xevent->xany.serial - wait->serial) < 0)
+    return False;
+
+  switch (xevent->type)
+    {
+    case NoExpose:
+      return (xevent->xnoexpose.drawable == wait->xwindow);
+    case GraphicsExpose:
+      return (xevent->xgraphicsexpose.drawable == wait->xwindow);
+    default:
+      return False;
+    }
+}
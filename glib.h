@@ -85,11 +85,29 @@
 #define G_MEM_TEMP 0
 #define G_MEM_PERM 1
 
+/* Function tracing. By default every "g_function_enter" and
+ *  "g_function_leave" maintains a call stack which is printed
+ *  when a fatal error occurs. Release builds should define
+ *  G_DO_STACK_TRACE to FALSE which compiles the calls away.
+ * Defining G_DO_PROFILE to TRUE instead records a time stamp for
+ *  each enter and leave in a per-thread ring buffer which may be
+ *  written out with "g_profile_dump".
+ */
+#ifndef G_DO_PROFILE
+#define G_DO_PROFILE FALSE
+#endif /* G_DO_PROFILE */
+
 #ifndef G_DO_STACK_TRACE
 #define G_DO_STACK_TRACE TRUE
 #endif /* G_DO_STACK_TRACE */
 
-#if (G_DO_STACK_TRACE == TRUE)
+#if (G_DO_PROFILE == TRUE)
+
+#define g_function_enter(fname)  (g_real_profile_enter (fname))
+#define g_function_leave(fname)  (g_real_profile_leave (fname))
+#define g_function_trace()
+
+#elif (G_DO_STACK_TRACE == TRUE)
 
 #define g_function_enter(fname)  (g_real_function_enter (fname))
 #define g_function_leave(fname)  (g_real_function_leave (fname))
@@ -159,6 +177,9 @@ typedef unsigned char   guint8;
 typedef unsigned short  guint16;
 typedef unsigned long   guint32;
 
+typedef long long           gint64;
+typedef unsigned long long  guint64;
+
 typedef struct _GList     GList;
 typedef struct _GTimer    GTimer;
 typedef struct _GMemChunk GMemChunk;
@@ -263,6 +284,12 @@ void    g_timer_reset   (GTimer  *timer);
 gdouble g_timer_elapsed (GTimer  *timer,
 			 gulong  *microseconds);
 
+/* "g_time_monotonic_ns" returns the time in nanoseconds from
+ *  a clock which is not affected by changes to the wall clock.
+ *  Only the difference between two values is meaningful.
+ */
+guint64 g_time_monotonic_ns (void);
+
 
 /* Output
  */
@@ -278,6 +305,21 @@ void g_real_function_enter (char *fname);
 void g_real_function_leave (char *fname);
 void g_real_function_trace (void);
 
+
+/* Profiling
+ */
+void g_real_profile_enter (char *fname);
+void g_real_profile_leave (char *fname);
+
+/* "g_profile_dump" writes the contents of every thread's
+ *  profile ring buffer to "filename" in the Chrome trace event
+ *  format. (Load the file with "chrome://tracing"). Returns
+ *  FALSE if the file could not be written. It is called when the
+ *  program exits if the environment variable "G_PROFILE_FILE"
+ *  names a file.
+ */
+gint g_profile_dump (char *filename);
+
 /* Utility routines
  */
 gchar* g_strdup (gchar *str);
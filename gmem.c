@@ -3,45 +3,78 @@
 
 
 #define MAX_MEM_AREA  65536L
-#define MEM_AREA_SIZE 4L
-#define MEM_ALIGN     SIZEOF_LONG
+
+/* The alignment of every atom. This is large enough for
+ *  doubles and pointers.
+ */
+#define MEM_ALIGN     (sizeof (union { gdouble d; gpointer p; glong l; }))
+#define MEM_ALIGN_SIZE(size)  (((size) + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1))
+
+#define G_MEM_AREA_MEM(chunk, area)   ((gchar*) (area) + (chunk)->mem_offset)
+#define G_MEM_AREA_FULL(chunk, area)  (((area)->free_atoms == NULL) && \
+				       (((area)->index + (chunk)->atom_size) > (chunk)->area_size))
 
 
 typedef struct _GMemArea      GMemArea;
+typedef struct _GMemAtom      GMemAtom;
 typedef struct _GRealMemChunk GRealMemChunk;
 
 struct _GMemArea {
   GMemArea *next;            /* the next mem area */
   GMemArea *prev;            /* the previous mem area */
-  gulong index;              /* the current index into the "mem" array */
-  gulong free;               /* the number of free bytes in this mem area */
+  GMemArea *free_next;       /* the next mem area with room for an atom */
+  GMemArea *free_prev;       /* the previous mem area with room for an atom */
+  GMemAtom *free_atoms;      /* the atoms in this area which have been freed */
+  gulong index;              /* the current index into the atoms which have
+			      *  never been allocated */
   gulong allocated;          /* the number of atoms allocated from this area */
-  gulong mark;               /* is this mem area marked for deletion */
-  gchar mem[MEM_AREA_SIZE];  /* the mem array from which atoms get allocated 
-			      * this actual size of this array is determined by
-			      *  the mem chunk "area_size". ANSI says that it
-			      *  must be declared to be the maximum size it
-			      *  can possibly be (even though the actual size
-			      *  may be less).
+  gint on_free_list;         /* is this area on the "free_areas" list */
+  guint32 bitmap[1];         /* one bit per atom which is set while the atom
+			      *  is allocated. The actual size of this array
+			      *  is determined by the mem chunk "bitmap_words".
+			      *  The atoms follow the bitmap.
 			      */
 };
 
+/* A freed atom. The free list is threaded through the
+ *  atoms themselves so that freeing never allocates. The
+ *  link is kept after the header which points back to the
+ *  area, so that header stays intact while the atom is free.
+ */
+struct _GMemAtom {
+  GMemAtom *next;
+};
+
 struct _GRealMemChunk {
   gchar *name;               /* name of this MemChunk...used for debugging output */
   gint type;                 /* the type of MemChunk: ALLOC_ONLY or ALLOC_AND_FREE */
   gint num_mem_areas;        /* the number of memory areas */
-  gint num_marked_areas;     /* the number of areas marked for deletion */
+  gint peak_mem_areas;       /* the largest number of memory areas */
   gint atom_size;            /* the size of an atom */
   gulong area_size;          /* the size of a memory area */
-  GMemArea *mem_area;        /* the current memory area */
+  gulong mem_offset;         /* the offset of the first atom in a memory area */
+  gulong bitmap_words;       /* the number of words in each area's bitmap */
+  gulong num_allocated;      /* the number of atoms allocated */
+  gulong peak_allocated;     /* the largest number of atoms allocated */
   GMemArea *mem_areas;       /* a list of all the mem areas owned by this chunk */
-  GMemArea *free_mem_area;   /* the free area...which is about to be destroyed */
-  GList *free_atoms;         /* the free atoms list */
+  GMemArea *free_areas;      /* a list of the mem areas with room for an atom */
+  GMemArea *empty_area;      /* an empty area held on to for reuse */
   GRealMemChunk *next;       /* pointer to the next chunk */
   GRealMemChunk *prev;       /* pointer to the previous chunk */
 };
 
 
+static GMemArea* g_mem_area_new         (GRealMemChunk *mem_chunk);
+static void      g_mem_area_destroy     (GRealMemChunk *mem_chunk,
+					 GMemArea      *mem_area);
+static void      g_mem_area_reset       (GRealMemChunk *mem_chunk,
+					 GMemArea      *mem_area);
+static void      g_mem_area_link_free   (GRealMemChunk *mem_chunk,
+					 GMemArea      *mem_area);
+static void      g_mem_area_unlink_free (GRealMemChunk *mem_chunk,
+					 GMemArea      *mem_area);
+
+
 static GRealMemChunk *mem_chunks = NULL;
 
 
@@ -98,6 +131,7 @@ g_mem_chunk_new (gchar  *name,
 		 gint    type)
 {
   GRealMemChunk *mem_chunk;
+  gulong num_atoms;
 
   g_function_enter ("g_mem_chunk_new");
   
@@ -105,11 +139,20 @@ g_mem_chunk_new (gchar  *name,
   mem_chunk->name = name;
   mem_chunk->type = type;
   mem_chunk->num_mem_areas = 0;
-  mem_chunk->num_marked_areas = 0;
-  mem_chunk->mem_area = NULL;
-  mem_chunk->free_mem_area = NULL;
-  mem_chunk->free_atoms = NULL;
+  mem_chunk->num_allocated = 0;
+  mem_chunk->peak_allocated = 0;
+  mem_chunk->peak_mem_areas = 0;
   mem_chunk->mem_areas = NULL;
+  mem_chunk->free_areas = NULL;
+  mem_chunk->empty_area = NULL;
+
+  /* Atoms are always a multiple of MEM_ALIGN in size so that
+   *  every atom is suitably aligned for any type.
+   */
+  if (atom_size < SIZEOF_VOID_P)
+    atom_size = SIZEOF_VOID_P;
+  if (atom_size % MEM_ALIGN)
+    atom_size += MEM_ALIGN - (atom_size % MEM_ALIGN);
 
   switch (mem_chunk->type)
     {
@@ -117,15 +160,12 @@ g_mem_chunk_new (gchar  *name,
       mem_chunk->atom_size = atom_size;
       break;
     case G_ALLOC_AND_FREE:
-      mem_chunk->atom_size = atom_size + SIZEOF_VOID_P;
+      mem_chunk->atom_size = atom_size + MEM_ALIGN;
       break;
     default:
       g_error ("unknown memory chunk type: %d", type);
       break;
     }
-  
-  if (mem_chunk->atom_size % MEM_ALIGN)
-    mem_chunk->atom_size += MEM_ALIGN - (mem_chunk->atom_size % MEM_ALIGN);
 
   mem_chunk->area_size = area_size;
   if (mem_chunk->area_size > MAX_MEM_AREA)
@@ -136,6 +176,20 @@ g_mem_chunk_new (gchar  *name,
   if (mem_chunk->area_size % mem_chunk->atom_size)
     mem_chunk->area_size += mem_chunk->atom_size - (mem_chunk->area_size % mem_chunk->atom_size);
 
+  /* An area is laid out as the area header, followed by the
+   *  occupancy bitmap (only for ALLOC_AND_FREE chunks), followed
+   *  by the atoms. Both the header and the bitmap are padded out
+   *  so that the atoms start on a MEM_ALIGN boundary.
+   */
+  num_atoms = mem_chunk->area_size / mem_chunk->atom_size;
+  if (mem_chunk->type == G_ALLOC_AND_FREE)
+    mem_chunk->bitmap_words = (num_atoms + 31) / 32;
+  else
+    mem_chunk->bitmap_words = 0;
+
+  mem_chunk->mem_offset = MEM_ALIGN_SIZE (sizeof (GMemArea)) +
+    MEM_ALIGN_SIZE (mem_chunk->bitmap_words * sizeof (guint32));
+
   mem_chunk->next = mem_chunks;
   mem_chunk->prev = NULL;
   if (mem_chunks)
@@ -166,8 +220,6 @@ g_mem_chunk_destroy (GMemChunk *mem_chunk)
       mem_areas = mem_areas->next;
       g_free (temp_area);
     }
-  
-  g_list_free (rmem_chunk->free_atoms);
 
   if (rmem_chunk->next)
     rmem_chunk->next->prev = rmem_chunk->prev;
@@ -186,153 +238,72 @@ gpointer
 g_mem_chunk_alloc (GMemChunk *mem_chunk)
 {
   GRealMemChunk *rmem_chunk;
-  GMemArea *temp_area;
-  GList *temp_list;
+  GMemArea *mem_area;
+  GMemAtom *atom;
+  gulong index;
   gpointer mem;
-  gpointer *t;
 
   g_function_enter ("g_mem_chunk_alloc");
 
   g_assert (mem_chunk != NULL);
 
   rmem_chunk = (GRealMemChunk*) mem_chunk;
-  while (rmem_chunk->free_atoms)
+
+  /* Every area which has room for another atom is on the
+   *  "free_areas" list. If the list is empty we need a new
+   *  area, preferably the empty one we held on to.
+   */
+  mem_area = rmem_chunk->free_areas;
+  if (!mem_area)
     {
-      /* Get the first piece of memory on the "free_atoms" list.
-       * We can go ahead and destroy the list node we used to keep
-       *  track of it with and to update the "free_atoms" list to
-       *  point to its next element.
-       */
-      mem = rmem_chunk->free_atoms->data;
-      temp_list = rmem_chunk->free_atoms;
-      rmem_chunk->free_atoms = rmem_chunk->free_atoms->next;
-      temp_list->next = NULL;
-      g_list_free (temp_list);
-      
-      /* Determine which area this piece of memory is allocated from */
-      temp_area = (GMemArea*) *((gpointer*) ((gchar*) mem - SIZEOF_VOID_P));
-      
-      /* If the area has been marked, then it is being destroyed.
-       *  (ie marked to be destroyed).
-       * We check to see if all of the segments on the free list that
-       *  reference this area have been removed. This occurs when
-       *  the ammount of free memory is less than the allocatable size.
-       * If the chunk should be freed, then we place it in the "free_mem_area".
-       * This is so we make sure not to free the mem area here and then
-       *  allocate it again a few lines down.
-       * If we don't allocate a chunk a few lines down then the "free_mem_area"
-       *  will be freed.
-       * If there is already a "free_mem_area" then we'll just free this mem area.
-       */
-      if (temp_area->mark)
-        {
-          /* Update the "free" memory available in that area */
-          temp_area->free += rmem_chunk->atom_size;
-
-          if (temp_area->free == rmem_chunk->area_size)
-            {
-              if (temp_area == rmem_chunk->mem_area)
-                rmem_chunk->mem_area = NULL;
-	      
-              if (rmem_chunk->free_mem_area)
-                {
-                  rmem_chunk->num_mem_areas -= 1;
-                  rmem_chunk->num_marked_areas -= 1;
-		  
-                  if (temp_area->next)
-                    temp_area->next->prev = temp_area->prev;
-                  if (temp_area->prev)
-                    temp_area->prev->next = temp_area->next;
-                  if (temp_area == rmem_chunk->mem_areas)
-                    rmem_chunk->mem_areas = rmem_chunk->mem_areas->next;
-                  if (temp_area == rmem_chunk->mem_area)
-                    rmem_chunk->mem_area = NULL;
-
-                  g_free (temp_area);
-                }
-              else
-                rmem_chunk->free_mem_area = temp_area;
-	    }
+      if (rmem_chunk->empty_area)
+	{
+	  mem_area = rmem_chunk->empty_area;
+	  rmem_chunk->empty_area = NULL;
 	}
       else
-        {
-          /* Update the "free" memory available in that area 
-	   */
-          temp_area->free -= rmem_chunk->atom_size;
-          temp_area->allocated += 1;
-	  
-          /* The area wasn't marked...return the memory 
-	   */
-          goto done;
-        }
+	mem_area = g_mem_area_new (rmem_chunk);
+
+      g_mem_area_link_free (rmem_chunk, mem_area);
     }
-  
-  /* If there isn't a current mem area or the current mem area is out of space
-   *  then allocate a new mem area. We'll first check and see if we can use
-   *  the "free_mem_area". Otherwise we'll just malloc the mem area.
+
+  /* Atoms which have been freed are reused before carving
+   *  new ones off of the end of the area.
    */
-  if ((!rmem_chunk->mem_area) || 
-      ((rmem_chunk->mem_area->index + rmem_chunk->atom_size) > rmem_chunk->area_size))
+  if (mem_area->free_atoms)
     {
-      if (rmem_chunk->free_mem_area)
-        {
-          rmem_chunk->mem_area = rmem_chunk->free_mem_area;
-	  rmem_chunk->free_mem_area = NULL;
-        }
-      else
-        {
-	  rmem_chunk->mem_area = (GMemArea*) g_malloc (sizeof (GMemArea) - 
-						       MEM_AREA_SIZE +
-						       rmem_chunk->area_size);
-	  
-	  rmem_chunk->num_mem_areas += 1;
-	  rmem_chunk->mem_area->next = rmem_chunk->mem_areas;
-	  rmem_chunk->mem_area->prev = NULL;
-	  
-	  if (rmem_chunk->mem_areas)
-	    rmem_chunk->mem_areas->prev = rmem_chunk->mem_area;
-	  rmem_chunk->mem_areas = rmem_chunk->mem_area;
-        }
-
-      rmem_chunk->mem_area->index = 0;
-      rmem_chunk->mem_area->free = rmem_chunk->area_size;
-      rmem_chunk->mem_area->allocated = 0;
-      rmem_chunk->mem_area->mark = 0;
+      atom = mem_area->free_atoms;
+      mem_area->free_atoms = atom->next;
+      mem = (gpointer) ((gchar*) atom - MEM_ALIGN);
     }
-  else if (rmem_chunk->free_mem_area)
+  else
     {
-      rmem_chunk->num_mem_areas -= 1;
-      
-      if (rmem_chunk->free_mem_area->next)
-	rmem_chunk->free_mem_area->next->prev = rmem_chunk->free_mem_area->prev;
-      if (rmem_chunk->free_mem_area->prev)
-	rmem_chunk->free_mem_area->prev->next = rmem_chunk->free_mem_area->next;
-      if (rmem_chunk->free_mem_area == rmem_chunk->mem_areas)
-	rmem_chunk->mem_areas = rmem_chunk->mem_areas->next;
-
-      g_free (rmem_chunk->free_mem_area);
-      rmem_chunk->free_mem_area = NULL;
+      mem = (gpointer) &G_MEM_AREA_MEM (rmem_chunk, mem_area)[mem_area->index];
+      mem_area->index += rmem_chunk->atom_size;
     }
 
-  /* Get the memory and modify the state variables appropriately.
-   */
-  mem = (gpointer) &rmem_chunk->mem_area->mem[rmem_chunk->mem_area->index];
-  rmem_chunk->mem_area->index += rmem_chunk->atom_size;
-  rmem_chunk->mem_area->free -= rmem_chunk->atom_size;
-  rmem_chunk->mem_area->allocated += 1;
-
-  /* If this is an ALLOC_AND_FREE chunk we calculated the atom_size with 4 extra bytes
-   *  so that we can use that space to keep track of which mem area this piece 
-   *  of memory came from.
+  mem_area->allocated += 1;
+  if (G_MEM_AREA_FULL (rmem_chunk, mem_area))
+    g_mem_area_unlink_free (rmem_chunk, mem_area);
+
+  rmem_chunk->num_allocated += 1;
+  if (rmem_chunk->num_allocated > rmem_chunk->peak_allocated)
+    rmem_chunk->peak_allocated = rmem_chunk->num_allocated;
+
+  /* If this is an ALLOC_AND_FREE chunk we calculated the atom_size with
+   *  MEM_ALIGN extra bytes so that we can use that space to keep track of
+   *  which mem area this piece of memory came from. We also mark the
+   *  atom as being in use in the area's bitmap.
    */
   if (rmem_chunk->type == G_ALLOC_AND_FREE)
     {
-      t = (gpointer*) mem;
-      *t = (gpointer) rmem_chunk->mem_area;
-      mem = (gpointer) ((gchar*) mem + SIZEOF_VOID_P);
+      index = ((gchar*) mem - G_MEM_AREA_MEM (rmem_chunk, mem_area)) / rmem_chunk->atom_size;
+      mem_area->bitmap[index / 32] |= ((guint32) 1 << (index % 32));
+
+      *((GMemArea**) mem) = mem_area;
+      mem = (gpointer) ((gchar*) mem + MEM_ALIGN);
     }
 
-done:
   g_function_leave ("g_mem_chunk_alloc");
   return mem;
 }
@@ -342,8 +313,9 @@ g_mem_chunk_free (GMemChunk *mem_chunk,
 		  gpointer   mem)
 {
   GRealMemChunk *rmem_chunk;
-  GMemArea *temp_area;
-  GList *new_list;
+  GMemArea *mem_area;
+  GMemAtom *atom;
+  gulong index;
 
   g_function_enter ("g_mem_chunk_free");
 
@@ -356,25 +328,48 @@ g_mem_chunk_free (GMemChunk *mem_chunk,
    */
   if (rmem_chunk->type == G_ALLOC_AND_FREE)
     {
-      /* Place the memory on the "free_atoms" list 
+      atom = (GMemAtom*) mem;
+      mem_area = *((GMemArea**) ((gchar*) mem - MEM_ALIGN));
+
+      index = ((gchar*) mem - MEM_ALIGN - G_MEM_AREA_MEM (rmem_chunk, mem_area)) / rmem_chunk->atom_size;
+      if (!(mem_area->bitmap[index / 32] & ((guint32) 1 << (index % 32))))
+	{
+	  g_warning ("%s: atom freed twice", rmem_chunk->name);
+	  goto done;
+	}
+      mem_area->bitmap[index / 32] &= ~((guint32) 1 << (index % 32));
+
+      /* A full area isn't on the "free_areas" list. It will
+       *  have room once this atom is returned to it.
+       */
+      if (G_MEM_AREA_FULL (rmem_chunk, mem_area))
+	g_mem_area_link_free (rmem_chunk, mem_area);
+
+      atom->next = mem_area->free_atoms;
+      mem_area->free_atoms = atom;
+      mem_area->allocated -= 1;
+      rmem_chunk->num_allocated -= 1;
+
+      /* Hold on to one empty area so that a chunk which
+       *  hovers around an area boundary doesn't keep on
+       *  allocating and freeing it. Any other empty area
+       *  is freed right away.
        */
-      new_list = g_list_alloc ();
-      new_list->data = mem;
-      new_list->next = rmem_chunk->free_atoms;
-      rmem_chunk->free_atoms = new_list;
-      
-      temp_area = (GMemArea*) *((gpointer*) ((gchar*) mem - SIZEOF_VOID_P));
-      temp_area->allocated -= 1;
-      
-      if (temp_area->allocated == 0)
+      if (mem_area->allocated == 0)
 	{
-	  temp_area->mark = 1;
-	  rmem_chunk->num_marked_areas += 1;
-	  
-	  g_mem_chunk_clean (mem_chunk);
+	  g_mem_area_unlink_free (rmem_chunk, mem_area);
+
+	  if (rmem_chunk->empty_area)
+	    g_mem_area_destroy (rmem_chunk, mem_area);
+	  else
+	    {
+	      g_mem_area_reset (rmem_chunk, mem_area);
+	      rmem_chunk->empty_area = mem_area;
+	    }
 	}
     }
-  
+
+done:
   g_function_leave ("g_mem_chunk_free");
 }
 
@@ -382,66 +377,20 @@ void
 g_mem_chunk_clean (GMemChunk *mem_chunk)
 {
   GRealMemChunk *rmem_chunk;
-  GMemArea *mem_area;
-  GList *temp_list;
-  GList *temp_list2;
-  GList *prev_list;
-  gpointer mem;
 
   g_function_enter ("g_mem_chunk_clean");
 
   g_assert (mem_chunk != NULL);
 
   rmem_chunk = (GRealMemChunk*) mem_chunk;
-  
-  if (rmem_chunk->type == G_ALLOC_AND_FREE)
+
+  /* Empty areas are freed as soon as they become empty
+   *  except for the one we hold on to. Free that one now.
+   */
+  if (rmem_chunk->empty_area)
     {
-      prev_list = NULL;
-      temp_list = rmem_chunk->free_atoms;
-      
-      while (temp_list)
-	{
-	  mem = temp_list->data;
-	  temp_list2 = temp_list;
-	  temp_list = temp_list->next;
-	  
-	  mem_area = (GMemArea*) *((gpointer*) ((gchar*) mem - SIZEOF_VOID_P));
-	  
-          /* If this mem area is marked for destruction then delete the
-	   *  area and list node and decrement the free mem.
-           */
-	  if (mem_area->mark)
-	    {
-	      if (temp_list2 == rmem_chunk->free_atoms)
-		rmem_chunk->free_atoms = temp_list2->next;
-	      if (prev_list)
-		prev_list->next = temp_list2->next;
-	      temp_list2->next = NULL;
-	      g_list_free (temp_list2);
-
-	      mem_area->free += rmem_chunk->atom_size;
-	      if (mem_area->free == rmem_chunk->area_size)
-		{
-		  rmem_chunk->num_mem_areas -= 1;
-		  rmem_chunk->num_marked_areas -= 1;
-		  
-		  if (mem_area->next)
-		    mem_area->next->prev = mem_area->prev;
-		  if (mem_area->prev)
-		    mem_area->prev->next = mem_area->next;
-		  if (mem_area == rmem_chunk->mem_areas)
-		    rmem_chunk->mem_areas = rmem_chunk->mem_areas->next;
-		  if (mem_area == rmem_chunk->mem_area)
-		    rmem_chunk->mem_area = NULL;
-		  
-		  g_free (mem_area);
-		}
-	    }
-	  else
-	    {
-	      prev_list = temp_list2;
-	    }
-	}
+      g_mem_area_destroy (rmem_chunk, rmem_chunk->empty_area);
+      rmem_chunk->empty_area = NULL;
     }
 
   g_function_leave ("g_mem_chunk_clean");
@@ -462,8 +411,10 @@ g_mem_chunk_reset (GMemChunk *mem_chunk)
 
   mem_areas = rmem_chunk->mem_areas;
   rmem_chunk->num_mem_areas = 0;
+  rmem_chunk->num_allocated = 0;
   rmem_chunk->mem_areas = NULL;
-  rmem_chunk->mem_area = NULL;
+  rmem_chunk->free_areas = NULL;
+  rmem_chunk->empty_area = NULL;
   
   while (mem_areas)
     {
@@ -472,9 +423,6 @@ g_mem_chunk_reset (GMemChunk *mem_chunk)
       g_free (temp_area);
     }
 
-  g_list_free (rmem_chunk->free_atoms);
-  rmem_chunk->free_atoms = NULL;
-  
   g_function_leave ("g_mem_chunk_reset");
 }
 
@@ -482,24 +430,31 @@ void
 g_mem_chunk_print (GMemChunk *mem_chunk)
 {
   GRealMemChunk *rmem_chunk;
-  GMemArea *mem_areas;
   gulong mem;
+  gulong area_mem;
+  gdouble fragmentation;
   
   g_function_enter ("g_mem_chunk_print");
 
   g_assert (mem_chunk != NULL);
   
   rmem_chunk = (GRealMemChunk*) mem_chunk;
-  mem_areas = rmem_chunk->mem_areas;
-  mem = 0;
 
-  while (mem_areas)
-    {
-      mem += rmem_chunk->area_size - mem_areas->free;
-      mem_areas = mem_areas->next;
-    }
+  /* Fragmentation is the fraction of the area memory which
+   *  isn't handed out as atoms right now.
+   */
+  mem = rmem_chunk->num_allocated * rmem_chunk->atom_size;
+  area_mem = rmem_chunk->num_mem_areas * rmem_chunk->area_size;
+  if (area_mem)
+    fragmentation = 100.0 * (area_mem - mem) / area_mem;
+  else
+    fragmentation = 0.0;
 
-  g_message ("%s: %ld bytes using %d mem areas", rmem_chunk->name, mem, rmem_chunk->num_mem_areas);
+  g_message ("%s: %ld bytes using %d mem areas (%.1f%% fragmentation)",
+	     rmem_chunk->name, mem, rmem_chunk->num_mem_areas, fragmentation);
+  g_message ("%s: peak %ld bytes using %d mem areas",
+	     rmem_chunk->name, rmem_chunk->peak_allocated * rmem_chunk->atom_size,
+	     rmem_chunk->peak_mem_areas);
 
   g_function_leave ("g_mem_chunk_print");
 }
@@ -549,3 +504,87 @@ g_blow_chunks ()
   g_function_leave ("g_blow_chunks");
 }
 
+
+static GMemArea*
+g_mem_area_new (GRealMemChunk *mem_chunk)
+{
+  GMemArea *mem_area;
+
+  mem_area = (GMemArea*) g_malloc (mem_chunk->mem_offset + mem_chunk->area_size);
+  g_mem_area_reset (mem_chunk, mem_area);
+
+  mem_area->prev = NULL;
+  mem_area->next = mem_chunk->mem_areas;
+  if (mem_chunk->mem_areas)
+    mem_chunk->mem_areas->prev = mem_area;
+  mem_chunk->mem_areas = mem_area;
+
+  mem_chunk->num_mem_areas += 1;
+  if (mem_chunk->num_mem_areas > mem_chunk->peak_mem_areas)
+    mem_chunk->peak_mem_areas = mem_chunk->num_mem_areas;
+
+  return mem_area;
+}
+
+static void
+g_mem_area_destroy (GRealMemChunk *mem_chunk,
+		    GMemArea      *mem_area)
+{
+  if (mem_area->next)
+    mem_area->next->prev = mem_area->prev;
+  if (mem_area->prev)
+    mem_area->prev->next = mem_area->next;
+  if (mem_area == mem_chunk->mem_areas)
+    mem_chunk->mem_areas = mem_area->next;
+
+  mem_chunk->num_mem_areas -= 1;
+  g_free (mem_area);
+}
+
+static void
+g_mem_area_reset (GRealMemChunk *mem_chunk,
+		  GMemArea      *mem_area)
+{
+  gulong i;
+
+  mem_area->free_next = NULL;
+  mem_area->free_prev = NULL;
+  mem_area->free_atoms = NULL;
+  mem_area->index = 0;
+  mem_area->allocated = 0;
+  mem_area->on_free_list = FALSE;
+
+  for (i = 0; i < mem_chunk->bitmap_words; i++)
+    mem_area->bitmap[i] = 0;
+}
+
+static void
+g_mem_area_link_free (GRealMemChunk *mem_chunk,
+		      GMemArea      *mem_area)
+{
+  mem_area->free_prev = NULL;
+  mem_area->free_next = mem_chunk->free_areas;
+  if (mem_chunk->free_areas)
+    mem_chunk->free_areas->free_prev = mem_area;
+  mem_chunk->free_areas = mem_area;
+  mem_area->on_free_list = TRUE;
+}
+
+static void
+g_mem_area_unlink_free (GRealMemChunk *mem_chunk,
+			GMemArea      *mem_area)
+{
+  if (!mem_area->on_free_list)
+    return;
+
+  if (mem_area->free_next)
+    mem_area->free_next->free_prev = mem_area->free_prev;
+  if (mem_area->free_prev)
+    mem_area->free_prev->free_next = mem_area->free_next;
+  if (mem_area == mem_chunk->free_areas)
+    mem_chunk->free_areas = mem_area->free_next;
+
+  mem_area->free_next = NULL;
+  mem_area->free_prev = NULL;
+  mem_area->on_free_list = FALSE;
+}
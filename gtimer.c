@@ -1,4 +1,5 @@
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include "glib.h"
 
@@ -7,12 +8,30 @@ typedef struct _PRealTimer PRealTimer;
 
 struct _PRealTimer
 {
-  struct timeval start;
-  struct timeval end;
+  guint64 start;
+  guint64 end;
   gint active;
 };
 
 
+guint64
+g_time_monotonic_ns ()
+{
+  struct timeval tv;
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+    return ((guint64) ts.tv_sec * 1000000000) + ts.tv_nsec;
+#endif /* CLOCK_MONOTONIC */
+
+  /* No monotonic clock. Fall back to the wall clock.
+   */
+  gettimeofday (&tv, NULL);
+  return ((guint64) tv.tv_sec * 1000000000) + ((guint64) tv.tv_usec * 1000);
+}
+
+
 GTimer* 
 g_timer_new ()
 {
@@ -23,7 +42,7 @@ g_timer_new ()
   timer = g_new (PRealTimer, 1);
   timer->active = TRUE;
   
-  gettimeofday (&timer->start, NULL);
+  timer->start = g_time_monotonic_ns ();
 
   g_function_leave ("g_timer_new");
   return ((GTimer*) timer);
@@ -51,7 +70,7 @@ g_timer_start (GTimer *timer)
   g_assert (timer != NULL);
 
   rtimer = (PRealTimer*) timer;
-  gettimeofday (&rtimer->start, NULL);
+  rtimer->start = g_time_monotonic_ns ();
   rtimer->active = 1;
 
   g_function_leave ("g_timer_start");
@@ -67,7 +86,7 @@ g_timer_stop (GTimer *timer)
   g_assert (timer != NULL);
 
   rtimer = (PRealTimer*) timer;
-  gettimeofday (&rtimer->end, NULL);
+  rtimer->end = g_time_monotonic_ns ();
   rtimer->active = 0;
 
   g_function_leave ("g_timer_stop");
@@ -83,7 +102,7 @@ g_timer_reset (GTimer *timer)
   g_assert (timer != NULL);
 
   rtimer = (PRealTimer*) timer;
-  gettimeofday (&rtimer->start, NULL);
+  rtimer->start = g_time_monotonic_ns ();
   
   g_function_leave ("g_timer_reset");
 }
@@ -93,7 +112,7 @@ g_timer_elapsed (GTimer *timer,
 		 gulong *microseconds)
 {
   PRealTimer *rtimer;
-  struct timeval elapsed;
+  guint64 elapsed;
   gdouble total;
 
   g_function_enter ("g_timer_elapsed");
@@ -103,21 +122,13 @@ g_timer_elapsed (GTimer *timer,
   rtimer = (PRealTimer*) timer;
 
   if (rtimer->active)
-    gettimeofday (&rtimer->end, NULL);
-
-  if (rtimer->start.tv_usec > rtimer->end.tv_usec)
-    {
-      rtimer->end.tv_usec += 1000000;
-      rtimer->end.tv_sec--;
-    }
-
-  elapsed.tv_usec = rtimer->end.tv_usec - rtimer->start.tv_usec;
-  elapsed.tv_sec = rtimer->end.tv_sec - rtimer->start.tv_sec;
+    rtimer->end = g_time_monotonic_ns ();
 
-  total = elapsed.tv_sec + ((gdouble) elapsed.tv_usec / 1e6);
+  elapsed = rtimer->end - rtimer->start;
+  total = (gdouble) elapsed / 1e9;
 
   if (microseconds)
-    *microseconds = elapsed.tv_usec;
+    *microseconds = (elapsed % 1000000000) / 1000;
 
   g_function_leave ("g_timer_elapsed");
   return total;
@@ -24,6 +24,9 @@
 #include "gtkprivate.h"
 
 
+#define EVENT_BATCH_SIZE  128
+
+
 /* Private type definitions
  */
 typedef struct _GtkOption           GtkOption;
@@ -39,12 +42,14 @@ struct _GtkOption
 struct _GtkTimeoutFunction
 {
   gint tag;
-  guint32 start;
+  guint64 deadline;
   guint32 interval;
-  guint32 originterval;
-  gint expired;
+  gint index;
+  gint removed;
   GtkFunction function;
   gpointer data;
+  GtkTimeoutFunction *hash_next;
+  GtkTimeoutFunction *expired_next;
 };
 
 
@@ -53,10 +58,27 @@ struct _GtkTimeoutFunction
 static void  gtk_handle_foreground       (char *arg);
 static void  gtk_handle_background       (char *arg);
 static void  gtk_handle_shadow_thickness (char *arg);
+static void  gtk_handle_no_double_buffer (char *arg);
 
 static void  gtk_exit_func       (void);
 static void  gtk_handle_timeouts (void);
 static void  gtk_handle_timer    (void);
+static void  gtk_fill_event_batch     (void);
+static void  gtk_compress_event_batch (void);
+static gint  gtk_expose_can_merge     (GdkRectangle *area1,
+				       GdkRectangle *area2);
+
+static gint  gtk_timeout_before      (GtkTimeoutFunction *a,
+				      GtkTimeoutFunction *b);
+static void  gtk_timeout_heap_set    (gint                index,
+				      GtkTimeoutFunction *timeoutf);
+static void  gtk_timeout_heap_up     (gint                index);
+static void  gtk_timeout_heap_down   (gint                index);
+static void  gtk_timeout_heap_insert (GtkTimeoutFunction *timeoutf);
+static void  gtk_timeout_heap_remove (GtkTimeoutFunction *timeoutf);
+static void  gtk_timeout_hash_insert (GtkTimeoutFunction *timeoutf);
+static GtkTimeoutFunction* gtk_timeout_hash_remove (gint tag);
+
 static void  gtk_propogate_event (GtkWidget *widget,
 				  GdkEvent  *event);
 
@@ -104,11 +126,22 @@ static void  gtk_root_focus_advance       (GtkContainer      *container,
 static int initialized = 0;                /* 1 if "gtk" is initialized,
 					    * 0 otherwise
 					    */
-static GdkEvent next_event;
 static GtkWidget *event_widget;
 static GtkWidget *grab_widget;
-static gint have_event;
-static gint have_next_event;
+
+static GdkEvent event_batch[EVENT_BATCH_SIZE];
+					   /* The events read from "gdk" but not yet
+					    *  dispatched. Every event which is pending
+					    *  when the batch is filled is read at once
+					    *  so that runs of motion, expose and
+					    *  enter/leave events may be compressed.
+					    */
+static gint event_batch_head = 0;
+static gint event_batch_length = 0;
+static gulong coalesced_events = 0;        /* The number of events which have been
+					    *  merged into another event or dropped
+					    *  by compression.
+					    */
 
 static GtkOption options[] =
 {
@@ -118,19 +151,31 @@ static GtkOption options[] =
   { "bg",               TRUE,  gtk_handle_background },
   { "shadow_thickness", TRUE,  gtk_handle_shadow_thickness },
   { "st",               TRUE,  gtk_handle_shadow_thickness },
+  { "no_double_buffer", FALSE, gtk_handle_no_double_buffer },
 };
 static int noptions = sizeof (options) / sizeof (GtkOption);
 
 static GList *grabs = NULL;                /* A list of grabs. The grabbing widget
 					    *  is the first one on the list.
 					    */
-static GList *timeout_functions = NULL;    /* A list of timeout functions sorted by
-					    *  when the length of the time interval
-					    *  remaining. Therefore, the first timeout
-					    *  function to expire is at the head of
-					    *  the list and the last to expire is at
-					    *  the tail of the list.
+static GtkTimeoutFunction **timeout_heap = NULL;
+					   /* A binary min-heap of timeout functions
+					    *  keyed on their absolute deadline. The
+					    *  first timeout function to expire is
+					    *  always at index 0. Each timeout function
+					    *  records its own index so that it may be
+					    *  removed without searching the heap.
+					    */
+static gint timeout_heap_size = 0;
+static gint timeout_heap_alloc = 0;
+
+static GtkTimeoutFunction **timeout_hash = NULL;
+					   /* Timeout functions hashed by tag. Tags are
+					    *  handed out sequentially so masking off
+					    *  the low bits spreads them evenly over
+					    *  the buckets.
 					    */
+static gint timeout_hash_size = 0;
 
 static GdkVisual *gtk_visual;              /* The visual to be used in creating new
 					    *  widgets.
@@ -315,15 +360,10 @@ gtk_main ()
 {
   g_function_enter ("gtk_main");
 
-  /* 'have_event' specifies whether the 'current_event' stucture contains
-   *  a valid new event.
-   * 'have_next_event' specifies whether the 'next_event' structure
-   *  contains a valid new event.
-   * The 'current_event' and 'next_event' structures are used to implement
-   *  enter/leave notify event compression.
+  /* Start out with an empty event batch.
    */
-  have_event = FALSE;
-  have_next_event = FALSE;
+  event_batch_head = 0;
+  event_batch_length = 0;
 
   grabs = NULL;
 
@@ -350,50 +390,25 @@ gtk_main_iteration ()
    */
   gtk_handle_timer ();
 
-  /* If there is a valid event in 'next_event' then copy
-   *  it to 'event' an unset the flag.
+  /* If every event in the batch has been dispatched then
+   *  perform any resizes which have been queued and read in
+   *  a new batch. Doing the resizes here means that windows
+   *  are laid out once no matter how many changes the events
+   *  in the last batch made.
    */
-  if (have_next_event)
+  if (event_batch_head == event_batch_length)
     {
-      have_next_event = FALSE;
-      have_event = TRUE;
-      current_event = next_event;
+      gtk_window_process_resizes ();
+      gtk_fill_event_batch ();
     }
 
-  /* If we don't have an event then get one.
-   */
-  if (!have_event)
-    have_event = gdk_event_get (&current_event);
-
   /* "gdk_event_get" can return FALSE if the timer goes off
    *  and no events are pending. Therefore, we should make
    *  sure that we got an event before continuing.
    */
-  if (have_event)
+  if (event_batch_head < event_batch_length)
     {
-      have_event = FALSE;
-
-      /* If there are any events pending then get the next one.
-       */
-      if (gdk_events_pending () > 0)
-	have_next_event = gdk_event_get (&next_event);
-
-      /* Try to compress enter/leave notify events. These event
-       *  pairs occur when the mouse is dragged quickly across
-       *  a window with many buttons (or through a menu). Instead
-       *  of highlighting and de-highlighting each widget that
-       *  is crossed it is better to simply de-highlight the widget
-       *  which contained the mouse initially and highlight the
-       *  widget which ends up containing the mouse.
-       */
-      if (have_next_event)
-	if (((current_event.type == GDK_ENTER_NOTIFY) ||
-	     (current_event.type == GDK_LEAVE_NOTIFY)) &&
-	    ((next_event.type == GDK_ENTER_NOTIFY) ||
-	     (next_event.type == GDK_LEAVE_NOTIFY)) &&
-	    (next_event.type != current_event.type) &&
-	    (next_event.any.window == current_event.any.window))
-	  goto done;
+      current_event = event_batch[event_batch_head++];
 
       /* Find the widget which got the event. We store the widget
        *  in the user_data field of GdkWindow's.
@@ -451,7 +466,6 @@ gtk_main_iteration ()
 	}
     }
 
-done:
   g_function_leave ("gtk_main_iteration");
 }
 
@@ -489,63 +503,34 @@ gtk_timeout_add (guint32     interval,
 {
   static gint timeout_tag = 1;
 
-  GList *temp_list;
-  GList *new_list;
   GtkTimeoutFunction *timeoutf;
-  GtkTimeoutFunction *temp;
 
   g_function_enter ("gtk_timeout_add");
 
   /* Create a new timeout function structure.
-   * The start time is the current time.
+   * The deadline is measured from the current time
+   *  in nanoseconds. The interval is in milliseconds.
    */
   timeoutf = g_new (GtkTimeoutFunction, 1);
   timeoutf->tag = timeout_tag++;
-  timeoutf->start = gdk_time_get ();
+  timeoutf->deadline = gdk_time_get_ns () + (guint64) interval * 1000000;
   timeoutf->interval = interval;
-  timeoutf->originterval = interval;
-  timeoutf->expired = FALSE;
+  timeoutf->index = -1;
+  timeoutf->removed = FALSE;
   timeoutf->function = function;
   timeoutf->data = data;
+  timeoutf->hash_next = NULL;
+  timeoutf->expired_next = NULL;
 
-  /* Insert the timeout function appropriately.
-   * Appropriately meaning sort it into the list
-   *  of timeout functions.
-   */
-  temp_list = timeout_functions;
-  while (temp_list)
-    {
-      temp = temp_list->data;
-      if (timeoutf->interval < temp->interval)
-	{
-	  new_list = g_list_alloc ();
-	  new_list->data = timeoutf;
-	  new_list->next = temp_list;
-	  new_list->prev = temp_list->prev;
-	  if (temp_list->prev)
-	    temp_list->prev->next = new_list;
-	  temp_list->prev = new_list;
-
-	  if (temp_list == timeout_functions)
-	    {
-	      timeout_functions = new_list;
-
-	      /* Set the "gdk" timer. We only really need to do this if the
-	       *  new timeout function was placed on the front of the timeout
-	       *  functions list. (This is the case if we got here).
-	       */
-	      gtk_handle_timer ();
-	    }
-
-	  goto done;
-	}
-
-      temp_list = temp_list->next;
-    }
+  gtk_timeout_hash_insert (timeoutf);
+  gtk_timeout_heap_insert (timeoutf);
 
-  timeout_functions = g_list_append (timeout_functions, timeoutf);
+  /* Set the "gdk" timer. We only really need to do this if the
+   *  new timeout function ended up at the top of the heap.
+   */
+  if (timeoutf->index == 0)
+    gtk_handle_timer ();
 
- done:
   g_function_leave ("gtk_timeout_add");
   return timeoutf->tag;
 }
@@ -554,30 +539,28 @@ void
 gtk_timeout_remove (tag)
      gint tag;
 {
-  GList *temp_list;
   GtkTimeoutFunction *timeoutf;
 
   g_function_enter ("gtk_timeout_remove");
 
-  /* Remove a timeout function.
-   * (Which, basically, involves searching the
-   *  list for the tag).
+  /* Remove a timeout function. The tag hash gives us the
+   *  timeout function and the timeout function knows where
+   *  it lives in the heap.
    */
-
-  temp_list = timeout_functions;
-  while (temp_list)
+  timeoutf = gtk_timeout_hash_remove (tag);
+  if (timeoutf)
     {
-      timeoutf = temp_list->data;
-
-      if (timeoutf->tag == tag)
+      /* A timeout function which is not in the heap is
+       *  currently being dispatched by "gtk_handle_timeouts".
+       *  It will be freed once its function returns.
+       */
+      if (timeoutf->index < 0)
+	timeoutf->removed = TRUE;
+      else
 	{
-	  timeout_functions = g_list_remove_link (timeout_functions, temp_list);
-	  g_list_free (temp_list);
+	  gtk_timeout_heap_remove (timeoutf);
 	  g_free (timeoutf);
-	  break;
 	}
-
-      temp_list = temp_list->next;
     }
 
   g_function_leave ("gtk_timeout_remove");
@@ -595,6 +578,27 @@ gtk_get_current_event (GdkEvent *event)
   g_function_leave ("gtk_get_current_event");
 }
 
+gulong
+gtk_get_coalesced_events ()
+{
+  return coalesced_events;
+}
+
+/* When double buffering is on "gtk_widget_draw" paints widgets
+ *  which have their own window into an off-screen pixmap and
+ *  copies the result to the window, so nothing flickers while
+ *  the widget clears and redraws itself.
+ */
+void
+gtk_set_double_buffer (gint double_buffer)
+{
+  g_function_enter ("gtk_set_double_buffer");
+
+  gtk_double_buffer = (double_buffer != FALSE);
+
+  g_function_leave ("gtk_set_double_buffer");
+}
+
 GtkWidget*
 gtk_get_event_widget (GdkEvent *event)
 {
@@ -791,6 +795,16 @@ gtk_handle_shadow_thickness (char *arg)
   g_function_leave ("gtk_handle_shadow_thickness");
 }
 
+static void
+gtk_handle_no_double_buffer (char *arg)
+{
+  g_function_enter ("gtk_handle_no_double_buffer");
+
+  gtk_double_buffer = FALSE;
+
+  g_function_leave ("gtk_handle_no_double_buffer");
+}
+
 static void
 gtk_exit_func ()
 {
@@ -805,92 +819,60 @@ gtk_exit_func ()
 static void
 gtk_handle_timeouts ()
 {
-  guint32 the_time;
-  GList *temp_list;
-  GList *temp_list2;
+  guint64 the_time;
+  GtkTimeoutFunction *expired;
+  GtkTimeoutFunction *expired_tail;
   GtkTimeoutFunction *timeoutf;
-  GtkTimeoutFunction *timeoutf2;
-  GtkTimeoutFunction temp_timeoutf;
-  gint i, j, length;
 
   g_function_enter ("gtk_handle_timeouts");
 
-  if (timeout_functions)
+  if (timeout_heap_size > 0)
     {
-      the_time = gdk_time_get ();
-
-      temp_list = timeout_functions;
-      while (temp_list)
+      the_time = gdk_time_get_ns ();
+
+      /* Pull every expired timeout function off of the heap
+       *  before calling any of them. A timeout function which
+       *  is re-armed (or added) while we are dispatching will
+       *  therefore not be run again until the next iteration.
+       *  They come off of the heap in order and are run in
+       *  that order.
+       */
+      expired = NULL;
+      expired_tail = NULL;
+      while ((timeout_heap_size > 0) &&
+	     (timeout_heap[0]->deadline <= the_time))
 	{
-	  timeoutf = temp_list->data;
+	  timeoutf = timeout_heap[0];
+	  gtk_timeout_heap_remove (timeoutf);
 
-	  if (timeoutf->interval <= (the_time - timeoutf->start))
-	    {
-	      timeoutf->interval = 0;
-	      timeoutf->expired = TRUE;
-	    }
+	  timeoutf->expired_next = NULL;
+	  if (expired_tail)
+	    expired_tail->expired_next = timeoutf;
 	  else
-	    timeoutf->interval -= (the_time - timeoutf->start);
-	  timeoutf->start = the_time;
-
-	  temp_list = temp_list->next;
+	    expired = timeoutf;
+	  expired_tail = timeoutf;
 	}
 
-      temp_list = timeout_functions;
-      while (temp_list)
+      while (expired)
 	{
-	  timeoutf = temp_list->data;
+	  timeoutf = expired;
+	  expired = expired->expired_next;
+	  timeoutf->expired_next = NULL;
 
-	  if (timeoutf->expired)
+	  if (!timeoutf->removed &&
+	      ((* timeoutf->function) (timeoutf->data)) == FALSE)
 	    {
-	      if (((* timeoutf->function) (timeoutf->data)) == FALSE)
-		{
-		  temp_list2 = temp_list;
-		  temp_list = temp_list->next;
-
-		  if (temp_list2->prev)
-		    temp_list2->prev->next = temp_list2->next;
-		  if (temp_list2->next)
-		    temp_list2->next->prev = temp_list2->prev;
-
-		  if (temp_list2 == timeout_functions)
-		    timeout_functions = timeout_functions->next;
-
-		  temp_list2->next = NULL;
-		  temp_list2->prev = NULL;
-		  g_list_free (temp_list2);
-		  g_free (timeoutf);
-		}
-	      else
-		{
-		  timeoutf->expired = FALSE;
-		  timeoutf->interval = timeoutf->originterval;
-		  temp_list = temp_list->next;
-		}
+	      if (!timeoutf->removed)
+		gtk_timeout_hash_remove (timeoutf->tag);
+	      timeoutf->removed = TRUE;
 	    }
-	  else
-	    break;
-	}
 
-      length = g_list_length (timeout_functions);
-      for (i = 1; i < length; i++)
-	{
-	  j = i;
-	  temp_list = g_list_nth (timeout_functions, j);
-	  timeoutf = temp_list->data;
-
-	  while (j > 0)
+	  if (timeoutf->removed)
+	    g_free (timeoutf);
+	  else
 	    {
-	      timeoutf2 = temp_list->prev->data;
-	      if (timeoutf->interval < timeoutf2->interval)
-		{
-		  temp_timeoutf = *timeoutf;
-		  *timeoutf = *timeoutf2;
-		  *timeoutf2 = temp_timeoutf;
-		  j--;
-		}
-	      else
-		break;
+	      timeoutf->deadline = the_time + (guint64) timeoutf->interval * 1000000;
+	      gtk_timeout_heap_insert (timeoutf);
 	    }
 	}
     }
@@ -902,13 +884,24 @@ static void
 gtk_handle_timer ()
 {
   GtkTimeoutFunction *timeoutf;
+  guint64 the_time;
 
   g_function_enter ("gtk_handle_timers");
 
-  if (timeout_functions)
+  if (timeout_heap_size > 0)
     {
-      timeoutf = timeout_functions->data;
-      gdk_timer_set (timeoutf->interval);
+      /* A timer value of 0 means "block forever" to "gdk",
+       *  so a deadline which has already passed is turned
+       *  into the shortest wait possible. The remaining time
+       *  is rounded up so that we never wake up early.
+       */
+      timeoutf = timeout_heap[0];
+      the_time = gdk_time_get_ns ();
+
+      if (timeoutf->deadline > the_time)
+	gdk_timer_set ((timeoutf->deadline - the_time + 999999) / 1000000);
+      else
+	gdk_timer_set (1);
     }
   else
     gdk_timer_set (0);
@@ -916,6 +909,335 @@ gtk_handle_timer ()
   g_function_leave ("gtk_handle_timers");
 }
 
+static gint
+gtk_timeout_before (GtkTimeoutFunction *a,
+		    GtkTimeoutFunction *b)
+{
+  /* Returns TRUE if "a" is due before "b". Timeout functions
+   *  with the same deadline are run in the order in which they
+   *  were added.
+   */
+  if (a->deadline != b->deadline)
+    return (a->deadline < b->deadline);
+  return (a->tag < b->tag);
+}
+
+static void
+gtk_timeout_heap_set (gint                index,
+		      GtkTimeoutFunction *timeoutf)
+{
+  timeout_heap[index] = timeoutf;
+  timeoutf->index = index;
+}
+
+static void
+gtk_timeout_heap_up (gint index)
+{
+  GtkTimeoutFunction *timeoutf;
+  gint parent;
+
+  timeoutf = timeout_heap[index];
+  while (index > 0)
+    {
+      parent = (index - 1) / 2;
+      if (!gtk_timeout_before (timeoutf, timeout_heap[parent]))
+	break;
+
+      gtk_timeout_heap_set (index, timeout_heap[parent]);
+      index = parent;
+    }
+
+  gtk_timeout_heap_set (index, timeoutf);
+}
+
+static void
+gtk_timeout_heap_down (gint index)
+{
+  GtkTimeoutFunction *timeoutf;
+  gint child;
+
+  timeoutf = timeout_heap[index];
+  while (1)
+    {
+      child = index * 2 + 1;
+      if (child >= timeout_heap_size)
+	break;
+
+      if (((child + 1) < timeout_heap_size) &&
+	  gtk_timeout_before (timeout_heap[child + 1], timeout_heap[child]))
+	child += 1;
+
+      if (!gtk_timeout_before (timeout_heap[child], timeoutf))
+	break;
+
+      gtk_timeout_heap_set (index, timeout_heap[child]);
+      index = child;
+    }
+
+  gtk_timeout_heap_set (index, timeoutf);
+}
+
+static void
+gtk_timeout_heap_insert (GtkTimeoutFunction *timeoutf)
+{
+  if (timeout_heap_size == timeout_heap_alloc)
+    {
+      timeout_heap_alloc = (timeout_heap_alloc) ? (timeout_heap_alloc * 2) : 16;
+      timeout_heap = g_realloc (timeout_heap, sizeof (GtkTimeoutFunction*) * timeout_heap_alloc);
+    }
+
+  gtk_timeout_heap_set (timeout_heap_size, timeoutf);
+  timeout_heap_size += 1;
+  gtk_timeout_heap_up (timeoutf->index);
+}
+
+static void
+gtk_timeout_heap_remove (GtkTimeoutFunction *timeoutf)
+{
+  GtkTimeoutFunction *last;
+  gint index;
+
+  index = timeoutf->index;
+  timeoutf->index = -1;
+
+  timeout_heap_size -= 1;
+  if (index == timeout_heap_size)
+    return;
+
+  /* Move the last element into the hole and let it find
+   *  its place. It may need to move in either direction.
+   */
+  last = timeout_heap[timeout_heap_size];
+  gtk_timeout_heap_set (index, last);
+  gtk_timeout_heap_up (index);
+  if (last->index == index)
+    gtk_timeout_heap_down (index);
+}
+
+static void
+gtk_timeout_hash_insert (GtkTimeoutFunction *timeoutf)
+{
+  GtkTimeoutFunction **old_hash;
+  GtkTimeoutFunction *tmp;
+  gint old_size;
+  gint i;
+
+  /* Keep the load factor at or below 1 by doubling the
+   *  number of buckets whenever the heap outgrows them.
+   */
+  if (timeout_heap_size >= timeout_hash_size)
+    {
+      old_hash = timeout_hash;
+      old_size = timeout_hash_size;
+
+      timeout_hash_size = (old_size) ? (old_size * 2) : 16;
+      timeout_hash = g_new (GtkTimeoutFunction*, timeout_hash_size);
+      for (i = 0; i < timeout_hash_size; i++)
+	timeout_hash[i] = NULL;
+
+      for (i = 0; i < old_size; i++)
+	while (old_hash[i])
+	  {
+	    tmp = old_hash[i];
+	    old_hash[i] = tmp->hash_next;
+
+	    tmp->hash_next = timeout_hash[tmp->tag & (timeout_hash_size - 1)];
+	    timeout_hash[tmp->tag & (timeout_hash_size - 1)] = tmp;
+	  }
+
+      if (old_hash)
+	g_free (old_hash);
+    }
+
+  timeoutf->hash_next = timeout_hash[timeoutf->tag & (timeout_hash_size - 1)];
+  timeout_hash[timeoutf->tag & (timeout_hash_size - 1)] = timeoutf;
+}
+
+static GtkTimeoutFunction*
+gtk_timeout_hash_remove (gint tag)
+{
+  GtkTimeoutFunction **link;
+  GtkTimeoutFunction *timeoutf;
+
+  if (!timeout_hash)
+    return NULL;
+
+  link = &timeout_hash[tag & (timeout_hash_size - 1)];
+  while (*link)
+    {
+      timeoutf = *link;
+      if (timeoutf->tag == tag)
+	{
+	  *link = timeoutf->hash_next;
+	  timeoutf->hash_next = NULL;
+	  return timeoutf;
+	}
+
+      link = &timeoutf->hash_next;
+    }
+
+  return NULL;
+}
+
+static void
+gtk_fill_event_batch ()
+{
+  g_function_enter ("gtk_fill_event_batch");
+
+  event_batch_head = 0;
+  event_batch_length = 0;
+
+  /* Wait for the first event (or for the timer to go off).
+   */
+  if (gdk_event_get (&event_batch[0]))
+    {
+      event_batch_length = 1;
+
+      /* Then read every event which is already pending without
+       *  waiting any longer. We stop after a destroy event since
+       *  the next call to "gdk_event_get" frees the window the
+       *  destroy event refers to.
+       */
+      while ((event_batch_length < EVENT_BATCH_SIZE) &&
+	     (event_batch[event_batch_length - 1].type != GDK_DESTROY) &&
+	     (gdk_events_pending () > 0))
+	{
+	  if (gdk_event_get (&event_batch[event_batch_length]))
+	    event_batch_length += 1;
+	}
+
+      gtk_compress_event_batch ();
+    }
+
+  g_function_leave ("gtk_fill_event_batch");
+}
+
+/* Takes the exposes for "window" which are waiting in the event
+ *  batch out of it and adds their areas, moved by "dx" and "dy",
+ *  to "invalid". Called after the contents of the window have
+ *  been scrolled, when those exposes would repaint the old places.
+ */
+void
+gtk_scroll_queued_exposes (GdkWindow *window,
+			   gint       dx,
+			   gint       dy,
+			   GdkRegion *invalid)
+{
+  GdkEvent *event;
+  GdkRectangle area;
+  gint i, j;
+
+  g_function_enter ("gtk_scroll_queued_exposes");
+
+  j = event_batch_head;
+  for (i = event_batch_head; i < event_batch_length; i++)
+    {
+      event = &event_batch[i];
+
+      if ((event->type == GDK_EXPOSE) && (event->any.window == window))
+	{
+	  area = event->expose.area;
+	  area.x += dx;
+	  area.y += dy;
+	  gdk_region_union_with_rect (invalid, &area);
+	  continue;
+	}
+
+      if (j != i)
+	event_batch[j] = *event;
+      j += 1;
+    }
+  event_batch_length = j;
+
+  g_function_leave ("gtk_scroll_queued_exposes");
+}
+
+static void
+gtk_compress_event_batch ()
+{
+  GdkEvent *event;
+  GdkEvent *prev;
+  gint i, j;
+
+  g_function_enter ("gtk_compress_event_batch");
+
+  j = 0;
+  for (i = 0; i < event_batch_length; i++)
+    {
+      event = &event_batch[i];
+      prev = (j > 0) ? &event_batch[j - 1] : NULL;
+
+      if (prev && (prev->any.window == event->any.window))
+	{
+	  /* Only the last of a run of motion events for a window
+	   *  is interesting. It carries the latest position and
+	   *  modifier state.
+	   */
+	  if ((prev->type == GDK_MOTION_NOTIFY) &&
+	      (event->type == GDK_MOTION_NOTIFY))
+	    {
+	      *prev = *event;
+	      coalesced_events += 1;
+	      continue;
+	    }
+
+	  /* Exposes for a window whose areas overlap or touch are
+	   *  merged into a single expose of the area which covers
+	   *  both. (As long as that doesn't mean repainting pixels
+	   *  which neither of them exposed).
+	   */
+	  if ((prev->type == GDK_EXPOSE) &&
+	      (event->type == GDK_EXPOSE) &&
+	      gtk_expose_can_merge (&prev->expose.area, &event->expose.area))
+	    {
+	      gdk_rectangle_union (&prev->expose.area, &event->expose.area, &prev->expose.area);
+	      coalesced_events += 1;
+	      continue;
+	    }
+
+	  /* Try to compress enter/leave notify events. These event
+	   *  pairs occur when the mouse is dragged quickly across
+	   *  a window with many buttons (or through a menu). Instead
+	   *  of highlighting and de-highlighting each widget that
+	   *  is crossed it is better to simply de-highlight the widget
+	   *  which contained the mouse initially and highlight the
+	   *  widget which ends up containing the mouse.
+	   */
+	  if (((prev->type == GDK_ENTER_NOTIFY) ||
+	       (prev->type == GDK_LEAVE_NOTIFY)) &&
+	      ((event->type == GDK_ENTER_NOTIFY) ||
+	       (event->type == GDK_LEAVE_NOTIFY)) &&
+	      (prev->type != event->type))
+	    {
+	      *prev = *event;
+	      coalesced_events += 1;
+	      continue;
+	    }
+	}
+
+      if (j != i)
+	event_batch[j] = *event;
+      j += 1;
+    }
+
+  event_batch_length = j;
+
+  g_function_leave ("gtk_compress_event_batch");
+}
+
+static gint
+gtk_expose_can_merge (GdkRectangle *area1,
+		      GdkRectangle *area2)
+{
+  GdkRectangle bounds;
+  glong area;
+
+  gdk_rectangle_union (area1, area2, &bounds);
+
+  area = (glong) area1->width * area1->height + (glong) area2->width * area2->height;
+  return ((glong) bounds.width * bounds.height <= area);
+}
+
 static void
 gtk_propogate_event (GtkWidget *widget,
 		     GdkEvent  *event)
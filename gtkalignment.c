@@ -298,9 +298,6 @@ gtk_alignment_size_request (GtkWidget      *widget,
 
   if (alignment->child)
     {
-      alignment->child->requisition.width = 0;
-      alignment->child->requisition.height = 0;
-
       gtk_widget_size_request (alignment->child, &alignment->child->requisition);
 
       requisition->width = (alignment->child->requisition.width +
@@ -602,9 +602,6 @@ gtk_hbox_size_request (GtkWidget      *widget,
 
 	  if (GTK_WIDGET_VISIBLE (child->widget))
 	    {
-	      child->widget->requisition.width = 0;
-	      child->widget->requisition.height = 0;
-
 	      gtk_widget_size_request (child->widget, &child->widget->requisition);
 
 	      if (box->homogeneous)
@@ -841,9 +838,6 @@ gtk_vbox_size_request (GtkWidget      *widget,
 
 	  if (GTK_WIDGET_VISIBLE (child->widget))
 	    {
-	      child->widget->requisition.width = 0;
-	      child->widget->requisition.height = 0;
-
 	      gtk_widget_size_request (child->widget, &child->widget->requisition);
 
 	      if (box->homogeneous)
@@ -647,9 +647,6 @@ gtk_button_size_request (GtkWidget      *widget,
 
       if (button->child)
 	{
-	  button->child->requisition.width = 0;
-	  button->child->requisition.height = 0;
-
 	  gtk_widget_size_request (button->child, &button->child->requisition);
 
 	  requisition->width = (button->child->requisition.width +
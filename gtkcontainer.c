@@ -34,6 +34,7 @@ gtk_container_add (GtkWidget *container,
   g_assert (rcontainer->function_table->add != NULL);
 
   widget->parent = rcontainer;
+  gtk_widget_invalidate_requisition (container);
   (* rcontainer->function_table->add) (rcontainer, widget);
 
   g_function_leave ("gtk_container_add");
@@ -56,6 +57,7 @@ gtk_container_remove (GtkWidget *container,
   if (rcontainer->focus_child == widget)
     rcontainer->focus_child = NULL;
 
+  gtk_widget_invalidate_requisition (container);
   (* rcontainer->function_table->remove) (rcontainer, widget);
   widget->parent = NULL;
 
@@ -73,6 +75,7 @@ gtk_container_need_resize (GtkContainer *container,
   g_assert (container->function_table != NULL);
   g_assert (container->function_table->need_resize != NULL);
 
+  gtk_widget_invalidate_requisition (widget);
   (* container->function_table->need_resize) (container, widget);
 
   g_function_leave ("gtk_container_need_resize");
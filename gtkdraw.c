@@ -39,19 +39,25 @@ gtk_draw_hline (GdkWindow *window,
 
   thickness_light = thickness / 2;
   thickness_dark = thickness - thickness_light;
+
+  /* Each row only overlaps itself, so drawing all of the lines
+   *  for one gc before the other keeps the result the same and
+   *  lets them go out as one batch per gc.
+   */
+  gdk_draw_batch_begin ();
   
   for (i = 0; i < thickness_dark; i++)
-    {
-      gdk_draw_line (window, lightgc, x2 - i - 1, y + i, x2, y + i);
-      gdk_draw_line (window, darkgc, x1, y + i, x2 - i - 1, y + i);
-    }
+    gdk_draw_line (window, lightgc, x2 - i - 1, y + i, x2, y + i);
+  for (i = 0; i < thickness_dark; i++)
+    gdk_draw_line (window, darkgc, x1, y + i, x2 - i - 1, y + i);
 
   y += thickness_dark;
   for (i = 0; i < thickness_light; i++)
-    {
-      gdk_draw_line (window, darkgc, x1, y + i, x1 + thickness_light - i - 1, y + i);
-      gdk_draw_line (window, lightgc, x1 + thickness_light - i - 1, y + i, x2, y + i);
-    }
+    gdk_draw_line (window, darkgc, x1, y + i, x1 + thickness_light - i - 1, y + i);
+  for (i = 0; i < thickness_light; i++)
+    gdk_draw_line (window, lightgc, x1 + thickness_light - i - 1, y + i, x2, y + i);
+
+  gdk_draw_batch_end ();
 
   g_function_leave ("gtk_draw_hline");
 }
@@ -77,19 +83,21 @@ gtk_draw_vline (GdkWindow *window,
 
   thickness_light = thickness / 2;
   thickness_dark = thickness - thickness_light;
+
+  gdk_draw_batch_begin ();
   
   for (i = 0; i < thickness_dark; i++)
-    {
-      gdk_draw_line (window, lightgc, x + i, y2 - i - 1, x + i, y2);
-      gdk_draw_line (window, darkgc, x + i, y1, x + i, y2 - i - 1);
-    }
+    gdk_draw_line (window, lightgc, x + i, y2 - i - 1, x + i, y2);
+  for (i = 0; i < thickness_dark; i++)
+    gdk_draw_line (window, darkgc, x + i, y1, x + i, y2 - i - 1);
 
   x += thickness_dark;
   for (i = 0; i < thickness_light; i++)
-    {
-      gdk_draw_line (window, darkgc, x + i, y1, x + i, y1 + thickness_light - i);
-      gdk_draw_line (window, lightgc, x + i, y1 + thickness_light - i, x + i, y2);
-    }
+    gdk_draw_line (window, darkgc, x + i, y1, x + i, y1 + thickness_light - i);
+  for (i = 0; i < thickness_light; i++)
+    gdk_draw_line (window, lightgc, x + i, y1 + thickness_light - i, x + i, y2);
+
+  gdk_draw_batch_end ();
 
   g_function_leave ("gtk_draw_vline");
 }
@@ -118,6 +126,8 @@ gtk_draw_shadow (GdkWindow     *window,
   g_assert (lightgc != NULL);
   g_assert (darkgc != NULL);
 
+  gdk_draw_batch_begin ();
+
   if (backgc)
     gdk_draw_rectangle (window, backgc, TRUE,
 			x, y, width, height);
@@ -184,6 +194,10 @@ gtk_draw_shadow (GdkWindow     *window,
       thickness_light = thickness / 2;
       thickness_dark = thickness - thickness_light;
 
+      /* The lines of one gc only cross the lines of the other
+       *  gc drawn at the same or an earlier step, so all of the
+       *  "gc1" lines can be drawn before the "gc2" lines.
+       */
       for (i = 0; i < thickness_dark; i++)
 	{
 	  gdk_draw_line (window, gc1, 
@@ -196,7 +210,9 @@ gtk_draw_shadow (GdkWindow     *window,
 			 y + i, 
 			 x + width - i - 1, 
 			 y + height - i - 1);
-	  
+	}
+      for (i = 0; i < thickness_dark; i++)
+	{
 	  gdk_draw_line (window, gc2, 
 			 x + i, 
 			 y + i, 
@@ -221,7 +237,9 @@ gtk_draw_shadow (GdkWindow     *window,
 			 y + thickness_dark + i,
 			 x + thickness_dark + i,
 			 y + height - thickness_dark - i - 1);
-
+	}
+      for (i = 0; i < thickness_light; i++)
+	{
 	  gdk_draw_line (window, gc2, 
 			 x + thickness_dark + i,
 			 y + height - thickness_light - i - 1,
@@ -239,6 +257,8 @@ gtk_draw_shadow (GdkWindow     *window,
       g_error ("unknown shadow type: %d", shadow_type);
       break;
     }
+
+  gdk_draw_batch_end ();
   
   g_function_leave ("gtk_draw_shadow");
 }
@@ -292,6 +312,8 @@ gtk_draw_arrow (GdkWindow     *window,
   half_width = width / 2;
   half_height = height / 2;
 
+  gdk_draw_batch_begin ();
+
   switch (arrow_type)
     {
     case GTK_ARROW_UP:
@@ -428,6 +450,8 @@ gtk_draw_arrow (GdkWindow     *window,
       break;
     }
 
+  gdk_draw_batch_end ();
+
 done:
   g_function_leave ("gtk_draw_arrow");
 }
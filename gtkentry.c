@@ -28,6 +28,20 @@
 #define MIN_ENTRY_WIDTH  150
 #define DRAW_TIMEOUT     20
 
+/* The text is kept in a gap buffer. These give the character at
+ *  position "i" and the x offset of its left edge, skipping over
+ *  the gap.
+ */
+#define TEXT_INDEX(entry, i)   (((i) < (entry)->gap_start) ? \
+				(i) : \
+				((i) + (entry)->gap_end - (entry)->gap_start))
+#define TEXT_CHAR(entry, i)    ((entry)->text[TEXT_INDEX (entry, i)])
+#define TEXT_OFFSET(entry, i)  (((i) < (entry)->gap_start) ? \
+				((entry)->text_offsets[i]) : \
+				(((i) >= (entry)->text_length) ? \
+				 ((entry)->text_width) : \
+				 ((entry)->text_width - (entry)->text_offsets[TEXT_INDEX (entry, i)])))
+
 
 typedef struct _GtkEntry  GtkEntry;
 typedef void (*GtkTextFunction) (GtkEntry *);
@@ -37,15 +51,39 @@ struct _GtkEntry
   GtkWidget widget;
   GdkWindow *text_area;
 
+  /* "text" holds "text_length" characters and a gap between
+   *  "gap_start" and "gap_end" which is moved to wherever text
+   *  is inserted or deleted. For each character "text_offsets"
+   *  holds its x offset from the start of the text if it comes
+   *  before the gap and its distance from the end of the text
+   *  ("text_width") if it comes after. Neither changes when text
+   *  is inserted or deleted at the gap.
+   */
   gchar *text;
-  gint16 text_size;
-  gint16 text_length;
-  gint16 current_pos;
-  gint16 select_start_pos;
-  gint16 select_end_pos;
-  gint16 scroll_offset;
+  gint *text_offsets;
+  gint text_size;
+  gint text_length;
+  gint gap_start;
+  gint gap_end;
+  gint text_width;
+  GdkFont *text_font;
+
+  gint current_pos;
+  gint select_start_pos;
+  gint select_end_pos;
+  gint scroll_offset;
   guint32 timer;
 
+  /* What is on the screen, so that only what has changed
+   *  since is redrawn. "changed_pos" is the first position
+   *  whose text has changed, or -1.
+   */
+  gint changed_pos;
+  gint drawn_pos;
+  gint drawn_select_start;
+  gint drawn_select_end;
+  gint drawn_scroll_offset;
+
   GtkKeyFunction key_function;
   gpointer key_function_data;
 };
@@ -57,6 +95,14 @@ static void  gtk_text_entry_draw          (GtkWidget      *widget,
 					   GdkRectangle   *area,
 					   gint            is_expose);
 static void  gtk_text_entry_draw_text     (GtkWidget      *widget);
+static void  gtk_text_entry_draw_changes  (GtkWidget      *widget);
+static void  gtk_text_entry_draw_range    (GtkWidget      *widget,
+					   gint            start_pos,
+					   gint            end_pos);
+static void  gtk_text_entry_draw_span     (GtkEntry       *entry,
+					   GdkGC          *gc,
+					   gint            start_pos,
+					   gint            end_pos);
 static void  gtk_text_entry_draw_cursor   (GtkWidget      *widget);
 static void  gtk_text_entry_draw_focus    (GtkWidget      *widget);
 static gint  gtk_text_entry_event         (GtkWidget      *widget,
@@ -84,6 +130,11 @@ static void  gtk_text_entry_adjust_scroll (GtkEntry       *entry);
 static gint  gtk_text_entry_handle_key    (GtkEntry       *entry,
 					   GdkEvent       *event);
 static void  gtk_text_entry_grow_text     (GtkEntry       *entry);
+static void  gtk_text_entry_move_gap      (GtkEntry       *entry,
+					   gint            position);
+static void  gtk_text_entry_measure_text  (GtkEntry       *entry);
+static gint  gtk_text_entry_is_word_char  (GtkEntry       *entry,
+					   gint            position);
 static void  gtk_text_entry_insert_text   (GtkEntry       *entry,
 					   gchar          *new_text,
 					   gint            new_text_length);
@@ -207,13 +258,23 @@ gtk_text_entry_new ()
 
   entry->text_area = NULL;
   entry->text = NULL;
+  entry->text_offsets = NULL;
   entry->text_size = 0;
   entry->text_length = 0;
+  entry->gap_start = 0;
+  entry->gap_end = 0;
+  entry->text_width = 0;
+  entry->text_font = NULL;
   entry->current_pos = 0;
   entry->select_start_pos = 0;
   entry->select_end_pos = 0;
   entry->scroll_offset = 0;
   entry->timer = 0;
+  entry->changed_pos = -1;
+  entry->drawn_pos = 0;
+  entry->drawn_select_start = 0;
+  entry->drawn_select_end = 0;
+  entry->drawn_scroll_offset = 0;
 
   entry->key_function = NULL;
   entry->key_function_data = NULL;
@@ -232,6 +293,15 @@ gtk_text_entry_get_text (GtkWidget *widget)
 
   g_assert (widget != NULL);
   entry = (GtkEntry*) widget;
+
+  /* Closing the gap at the end leaves room for the
+   *  terminating nul as the gap is never empty.
+   */
+  if (entry->text)
+    {
+      gtk_text_entry_move_gap (entry, entry->text_length);
+      entry->text[entry->text_length] = '\0';
+    }
   text = entry->text;
 
   g_function_leave ("gtk_text_entry_get_text");
@@ -258,13 +328,22 @@ gtk_text_entry_set_text (GtkWidget *widget,
   entry->text_size = entry->text_length + 1;
   entry->text = g_new (gchar, entry->text_size);
   strcpy (entry->text, text);
+  entry->gap_start = entry->text_length;
+  entry->gap_end = entry->text_size;
 
   if (old_text)
     g_free (old_text);
 
+  if (entry->text_offsets)
+    g_free (entry->text_offsets);
+  entry->text_offsets = g_new (gint, entry->text_size);
+  entry->text_font = NULL;
+  gtk_text_entry_measure_text (entry);
+
   entry->current_pos = 0;
   entry->select_start_pos = 0;
   entry->select_end_pos = 0;
+  entry->changed_pos = 0;
 
   gtk_widget_draw (widget, NULL, FALSE);
 
@@ -383,6 +462,8 @@ gtk_text_entry_destroy (GtkWidget *widget)
     gdk_window_destroy (entry->widget.window);
   if (entry->text)
     g_free (entry->text);
+  if (entry->text_offsets)
+    g_free (entry->text_offsets);
   g_free (entry);
 
   g_function_leave ("gtk_text_entry_destroy");
@@ -477,78 +558,220 @@ gtk_text_entry_draw (GtkWidget    *widget,
 
 static void
 gtk_text_entry_draw_text (GtkWidget *widget)
+{
+  GtkEntry *entry;
+
+  g_function_enter ("gtk_text_entry_draw_text");
+
+  g_assert (widget != NULL);
+
+  entry = (GtkEntry*) widget;
+  gtk_text_entry_draw_range (widget, 0, entry->text_length + 1);
+
+  g_function_leave ("gtk_text_entry_draw_text");
+}
+
+/* Redraws only what has changed since the text was last drawn:
+ *  the text from the first changed position on, the old and new
+ *  cursor and the ends of the selection that moved. Scrolling
+ *  redraws everything.
+ */
+static void
+gtk_text_entry_draw_changes (GtkWidget *widget)
 {
   GtkEntry *entry;
   gint select_start_pos;
   gint select_end_pos;
-  gint select_start_xoffset;
-  gint select_end_xoffset;
+  gint start_pos;
+  gint end_pos;
 
-  g_function_enter ("gtk_text_entry_draw_cursor");
+  g_function_enter ("gtk_text_entry_draw_changes");
+
+  g_assert (widget != NULL);
+
+  entry = (GtkEntry*) widget;
+
+  if (entry->scroll_offset != entry->drawn_scroll_offset)
+    {
+      gtk_text_entry_draw_text (widget);
+    }
+  else
+    {
+      select_start_pos = MIN (entry->select_start_pos, entry->select_end_pos);
+      select_end_pos = MAX (entry->select_start_pos, entry->select_end_pos);
+
+      if (entry->changed_pos != -1)
+	{
+	  start_pos = entry->changed_pos;
+	  end_pos = entry->text_length + 1;
+	}
+      else
+	{
+	  start_pos = entry->drawn_pos;
+	  end_pos = entry->drawn_pos + 1;
+	}
+
+      start_pos = MIN (start_pos, MIN (entry->drawn_pos, entry->current_pos));
+      end_pos = MAX (end_pos, MAX (entry->drawn_pos, entry->current_pos) + 1);
+
+      if (select_start_pos != entry->drawn_select_start)
+	{
+	  start_pos = MIN (start_pos, MIN (select_start_pos, entry->drawn_select_start));
+	  end_pos = MAX (end_pos, MAX (select_start_pos, entry->drawn_select_start));
+	}
+      if (select_end_pos != entry->drawn_select_end)
+	{
+	  start_pos = MIN (start_pos, MIN (select_end_pos, entry->drawn_select_end));
+	  end_pos = MAX (end_pos, MAX (select_end_pos, entry->drawn_select_end));
+	}
+
+      /* Characters may stick out of their cells a little, so
+       *  their neighbours are redrawn too.
+       */
+      gtk_text_entry_draw_range (widget, start_pos - 1, end_pos + 1);
+    }
+
+  g_function_leave ("gtk_text_entry_draw_changes");
+}
+
+/* Clears and redraws the characters from "start_pos" up to
+ *  "end_pos". An "end_pos" past the end of the text clears to
+ *  the right edge of the text area.
+ */
+static void
+gtk_text_entry_draw_range (GtkWidget *widget,
+			   gint       start_pos,
+			   gint       end_pos)
+{
+  GtkEntry *entry;
+  GdkRectangle area;
+  gint select_start_pos;
+  gint select_end_pos;
+  gint first_pos;
+  gint last_pos;
+  gint pos;
+  gint x1, x2;
+
+  g_function_enter ("gtk_text_entry_draw_range");
 
   g_assert (widget != NULL);
 
   if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_MAPPED (widget))
     {
       entry = (GtkEntry*) widget;
+      gtk_text_entry_measure_text (entry);
 
-      gdk_window_clear (entry->text_area);
+      start_pos = MAX (start_pos, 0);
+      start_pos = MIN (start_pos, entry->text_length);
 
-      if (entry->text)
+      x1 = MAX (TEXT_OFFSET (entry, start_pos) - entry->scroll_offset, 0);
+      if (end_pos > entry->text_length)
+	x2 = entry->text_area->width;
+      else
+	x2 = MIN (TEXT_OFFSET (entry, end_pos) - entry->scroll_offset,
+		  entry->text_area->width);
+
+      if (x2 > x1)
 	{
-	  if (entry->select_start_pos != entry->select_end_pos)
+	  area.x = x1;
+	  area.y = 0;
+	  area.width = x2 - x1;
+	  area.height = entry->text_area->height;
+
+	  /* This is called on its own when the text changes,
+	   *  so the clear and redraw are painted off-screen here
+	   *  rather than relying on "gtk_widget_draw".
+	   */
+	  if (gtk_double_buffer)
+	    gdk_window_begin_paint (entry->text_area, &area);
+
+	  gdk_window_clear_area (entry->text_area, area.x, area.y, area.width, area.height);
+
+	  /* Only the characters that can be seen are drawn.
+	   */
+	  first_pos = gtk_text_entry_position (entry, entry->scroll_offset);
+	  last_pos = gtk_text_entry_position (entry, entry->scroll_offset +
+					      entry->text_area->width) + 1;
+	  start_pos = MAX (start_pos, first_pos);
+	  end_pos = MIN (end_pos, MIN (last_pos, entry->text_length));
+	  end_pos = MAX (end_pos, start_pos);
+
+	  select_start_pos = MIN (entry->select_start_pos, entry->select_end_pos);
+	  select_end_pos = MAX (entry->select_start_pos, entry->select_end_pos);
+	  if (select_start_pos == select_end_pos)
+	    select_start_pos = select_end_pos = end_pos;
+	  select_start_pos = CLAMP (select_start_pos, start_pos, end_pos);
+	  select_end_pos = CLAMP (select_end_pos, start_pos, end_pos);
+
+	  gtk_text_entry_draw_span (entry, widget->style->foreground_gc[GTK_STATE_NORMAL],
+				    start_pos, select_start_pos);
+
+	  if (select_start_pos < select_end_pos)
 	    {
-	      select_start_pos = MIN (entry->select_start_pos, entry->select_end_pos);
-	      select_end_pos = MAX (entry->select_start_pos, entry->select_end_pos);
-
-	      select_start_xoffset = gdk_text_width (widget->style->font,
-						     entry->text,
-						     select_start_pos);
-	      select_end_xoffset = gdk_text_width (widget->style->font,
-						   entry->text,
-						   select_end_pos);
-
-	      if (select_start_pos > 0)
-		gdk_draw_text (entry->text_area,
-			       widget->style->foreground_gc[GTK_STATE_NORMAL],
-			       -entry->scroll_offset, widget->style->font->ascent + 1,
-			       entry->text, select_start_pos);
-
+	      pos = TEXT_OFFSET (entry, select_start_pos);
 	      gdk_draw_rectangle (entry->text_area,
 				  widget->style->background_gc[GTK_STATE_SELECTED],
 				  TRUE,
-				  -entry->scroll_offset + select_start_xoffset,
+				  pos - entry->scroll_offset,
 				  0,
-				  select_end_xoffset - select_start_xoffset,
+				  TEXT_OFFSET (entry, select_end_pos) - pos,
 				  entry->text_area->height);
 
-	      gdk_draw_text (entry->text_area,
-			     widget->style->foreground_gc[GTK_STATE_SELECTED],
-			     -entry->scroll_offset + select_start_xoffset,
-			     widget->style->font->ascent + 1,
-			     entry->text + select_start_pos,
-			     select_end_pos - select_start_pos);
-
-	      if (select_end_pos < entry->text_length)
-		gdk_draw_string (entry->text_area,
-				 widget->style->foreground_gc[GTK_STATE_NORMAL],
-				 -entry->scroll_offset + select_end_xoffset,
-				 widget->style->font->ascent + 1,
-				 entry->text + select_end_pos);
-	    }
-	  else
-	    {
-	      gdk_draw_string (entry->text_area,
-			       widget->style->foreground_gc[GTK_STATE_NORMAL],
-			       -entry->scroll_offset, widget->style->font->ascent + 1,
-			       entry->text);
+	      gtk_text_entry_draw_span (entry, widget->style->foreground_gc[GTK_STATE_SELECTED],
+					select_start_pos, select_end_pos);
 	    }
+
+	  gtk_text_entry_draw_span (entry, widget->style->foreground_gc[GTK_STATE_NORMAL],
+				    select_end_pos, end_pos);
+
+	  gtk_text_entry_draw_cursor (widget);
+
+	  if (gtk_double_buffer)
+	    gdk_window_end_paint (entry->text_area);
 	}
 
-      gtk_text_entry_draw_cursor (widget);
+      entry->changed_pos = -1;
+      entry->drawn_pos = entry->current_pos;
+      entry->drawn_select_start = MIN (entry->select_start_pos, entry->select_end_pos);
+      entry->drawn_select_end = MAX (entry->select_start_pos, entry->select_end_pos);
+      entry->drawn_scroll_offset = entry->scroll_offset;
     }
 
-  g_function_leave ("gtk_text_entry_draw_cursor");
+  g_function_leave ("gtk_text_entry_draw_range");
+}
+
+/* Draws the characters from "start_pos" up to "end_pos", which
+ *  takes two calls to "gdk_draw_text" when the gap falls between
+ *  them.
+ */
+static void
+gtk_text_entry_draw_span (GtkEntry *entry,
+			  GdkGC    *gc,
+			  gint      start_pos,
+			  gint      end_pos)
+{
+  gint y;
+  gint pos;
+
+  g_function_enter ("gtk_text_entry_draw_span");
+
+  y = entry->widget.style->font->ascent + 1;
+
+  if (start_pos < entry->gap_start)
+    {
+      pos = MIN (end_pos, entry->gap_start);
+      gdk_draw_text (entry->text_area, gc,
+		     TEXT_OFFSET (entry, start_pos) - entry->scroll_offset, y,
+		     entry->text + start_pos, pos - start_pos);
+      start_pos = pos;
+    }
+
+  if (start_pos < end_pos)
+    gdk_draw_text (entry->text_area, gc,
+		   TEXT_OFFSET (entry, start_pos) - entry->scroll_offset, y,
+		   entry->text + TEXT_INDEX (entry, start_pos), end_pos - start_pos);
+
+  g_function_leave ("gtk_text_entry_draw_span");
 }
 
 static void
@@ -565,12 +788,9 @@ gtk_text_entry_draw_cursor (GtkWidget *widget)
   if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_MAPPED (widget))
     {
       entry = (GtkEntry*) widget;
+      gtk_text_entry_measure_text (entry);
 
-      if (entry->current_pos > 0)
-	xoffset = gdk_text_width (widget->style->font, entry->text, entry->current_pos);
-      else
-	xoffset = 0;
-      xoffset -= entry->scroll_offset;
+      xoffset = TEXT_OFFSET (entry, entry->current_pos) - entry->scroll_offset;
 
       if (GTK_WIDGET_HAS_FOCUS (widget) &&
 	  (entry->select_start_pos == entry->select_end_pos))
@@ -807,39 +1027,44 @@ gtk_text_entry_timer (gpointer data)
   entry = (GtkEntry*) data;
   g_assert (entry != NULL);
 
-  gtk_text_entry_draw_text ((GtkWidget*) entry);
+  gtk_text_entry_draw_changes ((GtkWidget*) entry);
   entry->timer = 0;
 
   g_function_leave ("gtk_text_entry_queue_draw");
   return FALSE;
 }
 
+/* Returns the position of the character under "x", found by a
+ *  binary search of the character offsets.
+ */
 static gint
 gtk_text_entry_position (GtkEntry *entry,
 			 gint      x)
 {
-  gint return_val;
-  gint sum;
-  gint i;
+  gint low, high, mid;
 
   g_function_enter ("gtk_text_entry_position");
 
   g_assert (entry != NULL);
-  return_val = x;
-
-  i = 0;
-  sum = 0;
-  if (x > sum)
-    for (; i < entry->text_length; i++)
-      {
-	sum += gdk_char_width (entry->widget.style->font, entry->text[i]);
-	if (x < sum)
-	  break;
-      }
-  return_val = i;
+  gtk_text_entry_measure_text (entry);
+
+  low = 0;
+  high = entry->text_length;
+
+  if (x <= 0)
+    high = 0;
+
+  while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (TEXT_OFFSET (entry, mid + 1) > x)
+	high = mid;
+      else
+	low = mid + 1;
+    }
 
   g_function_leave ("gtk_text_entry_position");
-  return return_val;
+  return low;
 }
 
 static void
@@ -850,12 +1075,9 @@ gtk_text_entry_adjust_scroll (GtkEntry *entry)
   g_function_enter ("gtk_text_entry_adjust_scroll");
 
   g_assert (entry != NULL);
+  gtk_text_entry_measure_text (entry);
 
-  if (entry->current_pos > 0)
-    xoffset = gdk_text_width (entry->widget.style->font, entry->text, entry->current_pos);
-  else
-    xoffset = 0;
-  xoffset -= entry->scroll_offset;
+  xoffset = TEXT_OFFSET (entry, entry->current_pos) - entry->scroll_offset;
 
   if (xoffset < 0)
     entry->scroll_offset += xoffset;
@@ -957,11 +1179,14 @@ gtk_text_entry_handle_key (GtkEntry *entry,
   return return_val;
 }
 
+/* Doubles the size of the buffer. The text after the gap is
+ *  moved to the end so that the new space goes to the gap.
+ */
 static void
 gtk_text_entry_grow_text (GtkEntry *entry)
 {
   gint previous_size;
-  gint i;
+  gint tail;
 
   g_function_enter ("gtk_text_entry_grow_text");
 
@@ -973,43 +1198,135 @@ gtk_text_entry_grow_text (GtkEntry *entry)
   else
     entry->text_size *= 2;
   entry->text = g_realloc (entry->text, entry->text_size);
+  entry->text_offsets = g_realloc (entry->text_offsets, entry->text_size * sizeof (gint));
 
-  for (i = previous_size; i < entry->text_size; i++)
-    entry->text[i] = '\0';
+  tail = previous_size - entry->gap_end;
+  memmove (entry->text + entry->text_size - tail,
+	   entry->text + entry->gap_end,
+	   tail);
+  memmove (entry->text_offsets + entry->text_size - tail,
+	   entry->text_offsets + entry->gap_end,
+	   tail * sizeof (gint));
+  entry->gap_end = entry->text_size - tail;
 
   g_function_leave ("gtk_text_entry_grow_text");
 }
 
+/* Moves the gap to "position". Each character that crosses the
+ *  gap has its offset switched between being measured from the
+ *  start and from the end of the text.
+ */
+static void
+gtk_text_entry_move_gap (GtkEntry *entry,
+			 gint      position)
+{
+  g_function_enter ("gtk_text_entry_move_gap");
+
+  g_assert (entry != NULL);
+
+  while (entry->gap_start > position)
+    {
+      entry->gap_start -= 1;
+      entry->gap_end -= 1;
+      entry->text[entry->gap_end] = entry->text[entry->gap_start];
+      entry->text_offsets[entry->gap_end] = (entry->text_width -
+					     entry->text_offsets[entry->gap_start]);
+    }
+
+  while (entry->gap_start < position)
+    {
+      entry->text[entry->gap_start] = entry->text[entry->gap_end];
+      entry->text_offsets[entry->gap_start] = (entry->text_width -
+					       entry->text_offsets[entry->gap_end]);
+      entry->gap_start += 1;
+      entry->gap_end += 1;
+    }
+
+  g_function_leave ("gtk_text_entry_move_gap");
+}
+
+/* Measures every character again if the font has changed since
+ *  the offsets were computed.
+ */
+static void
+gtk_text_entry_measure_text (GtkEntry *entry)
+{
+  GdkFont *font;
+  gint before_width;
+  gint after_width;
+  gint i;
+
+  g_function_enter ("gtk_text_entry_measure_text");
+
+  g_assert (entry != NULL);
+
+  font = entry->widget.style->font;
+
+  if (entry->text_font != font)
+    {
+      entry->text_font = font;
+
+      /* A new entry has no buffer until text is first inserted.
+       */
+      before_width = 0;
+      after_width = 0;
+
+      if (entry->text)
+	{
+	  before_width = gdk_text_offsets (font, entry->text, entry->gap_start,
+					   entry->text_offsets);
+	  after_width = gdk_text_offsets (font, entry->text + entry->gap_end,
+					  entry->text_size - entry->gap_end,
+					  entry->text_offsets + entry->gap_end);
+	}
+      entry->text_width = before_width + after_width;
+
+      /* After the gap offsets are kept as the distance from
+       *  the end of the text.
+       */
+      for (i = entry->gap_end; i < entry->text_size; i++)
+	entry->text_offsets[i] = after_width - entry->text_offsets[i];
+
+      entry->changed_pos = 0;
+    }
+
+  g_function_leave ("gtk_text_entry_measure_text");
+}
+
 static void
 gtk_text_entry_insert_text (GtkEntry *entry,
 			    gchar    *new_text,
 			    gint      new_text_length)
 {
-  gchar *text;
-  gint start_pos;
-  gint end_pos;
-  gint last_pos;
+  gint start_x;
+  gint width;
   gint i;
 
   g_function_enter ("gtk_text_entry_insert_text");
 
   g_assert (entry != NULL);
 
-  start_pos = entry->current_pos;
-  end_pos = start_pos + new_text_length;
-  last_pos = new_text_length + entry->text_length;
-
-  while (last_pos >= entry->text_size)
+  while ((entry->gap_end - entry->gap_start) <= new_text_length)
     gtk_text_entry_grow_text (entry);
 
-  text = entry->text;
-  for (i = last_pos - 1; i >= end_pos; i--)
-    text[i] = text[i- (end_pos - start_pos)];
-  for (i = start_pos; i < end_pos; i++)
-    text[i] = new_text[i - start_pos];
+  gtk_text_entry_measure_text (entry);
+  gtk_text_entry_move_gap (entry, entry->current_pos);
+
+  start_x = TEXT_OFFSET (entry, entry->gap_start);
+
+  memcpy (entry->text + entry->gap_start, new_text, new_text_length);
+  width = gdk_text_offsets (entry->text_font, new_text, new_text_length,
+			    entry->text_offsets + entry->gap_start);
+  for (i = 0; i < new_text_length; i++)
+    entry->text_offsets[entry->gap_start + i] += start_x;
+  entry->gap_start += new_text_length;
 
+  if ((entry->changed_pos == -1) || (entry->changed_pos > entry->current_pos))
+    entry->changed_pos = entry->current_pos;
+
+  entry->text_width += width;
   entry->text_length += new_text_length;
-  entry->current_pos = end_pos;
+  entry->current_pos = entry->gap_start;
 
   g_function_leave ("gtk_text_entry_insert_text");
 }
@@ -1019,9 +1336,7 @@ gtk_text_entry_delete_text (GtkEntry *entry,
 			    gint      start_pos,
 			    gint      end_pos)
 {
-  gchar *text;
-  gint deletion_length;
-  gint i;
+  gint deletion_width;
 
   g_function_enter ("gtk_text_entry_delete_text");
 
@@ -1031,22 +1346,40 @@ gtk_text_entry_delete_text (GtkEntry *entry,
       (start_pos >= 0) &&
       (end_pos <= entry->text_length))
     {
-      text = entry->text;
-      deletion_length = end_pos - start_pos;
+      gtk_text_entry_measure_text (entry);
+      gtk_text_entry_move_gap (entry, start_pos);
 
-      for (i = end_pos; i < entry->text_length; i++)
-	text[i - deletion_length] = text[i];
+      deletion_width = TEXT_OFFSET (entry, end_pos) - TEXT_OFFSET (entry, start_pos);
 
-      for (i = entry->text_length - deletion_length; i < entry->text_length; i++)
-	text[i] = '\0';
-
-      entry->text_length -= deletion_length;
+      entry->gap_end += end_pos - start_pos;
+      entry->text_width -= deletion_width;
+      entry->text_length -= end_pos - start_pos;
       entry->current_pos = start_pos;
+
+      if ((entry->changed_pos == -1) || (entry->changed_pos > start_pos))
+	entry->changed_pos = start_pos;
     }
 
   g_function_leave ("gtk_text_entry_delete_text");
 }
 
+static gint
+gtk_text_entry_is_word_char (GtkEntry *entry,
+			     gint      position)
+{
+  gchar c;
+
+  g_function_enter ("gtk_text_entry_is_word_char");
+
+  if ((position >= 0) && (position < entry->text_length))
+    c = TEXT_CHAR (entry, position);
+  else
+    c = '\0';
+
+  g_function_leave ("gtk_text_entry_is_word_char");
+  return ((c == '_') || isalnum (c));
+}
+
 static void
 gtk_move_forward_character (GtkEntry *entry)
 {
@@ -1084,7 +1417,6 @@ gtk_move_backward_character (GtkEntry *entry)
 static void
 gtk_move_forward_word (GtkEntry *entry)
 {
-  gchar *text;
   gint i;
 
   g_function_enter ("gtk_move_forward_word");
@@ -1093,16 +1425,15 @@ gtk_move_forward_word (GtkEntry *entry)
 
   if (entry->text)
     {
-      text = entry->text;
       i = entry->current_pos;
 
-      if (!((text[i] == '_') || isalnum (text[i])))
+      if (!gtk_text_entry_is_word_char (entry, i))
 	for (; i < entry->text_length; i++)
-	  if ((text[i] == '_') || isalnum (text[i]))
+	  if (gtk_text_entry_is_word_char (entry, i))
 	    break;
 
       for (; i < entry->text_length; i++)
-	if (!((text[i] == '_') || isalnum (text[i])))
+	if (!gtk_text_entry_is_word_char (entry, i))
 	  {
 	    i -= 1;
 	    break;
@@ -1120,7 +1451,6 @@ gtk_move_forward_word (GtkEntry *entry)
 static void
 gtk_move_backward_word (GtkEntry *entry)
 {
-  gchar *text;
   gint i;
 
   g_function_enter ("gtk_move_backward_word");
@@ -1129,16 +1459,15 @@ gtk_move_backward_word (GtkEntry *entry)
 
   if (entry->text)
     {
-      text = entry->text;
       i = entry->current_pos - 1;
 
-      if (!((text[i] == '_') || isalnum (text[i])))
+      if (!gtk_text_entry_is_word_char (entry, i))
 	for (; i >= 0; i--)
-	  if ((text[i] == '_') || isalnum (text[i]))
+	  if (gtk_text_entry_is_word_char (entry, i))
 	    break;
 
       for (; i >= 0; i--)
-	if (!((text[i] == '_') || isalnum (text[i])))
+	if (!gtk_text_entry_is_word_char (entry, i))
 	  {
 	    i += 1;
 	    break;
@@ -1148,7 +1477,8 @@ gtk_move_backward_word (GtkEntry *entry)
       if (entry->current_pos < 0)
 	entry->current_pos = 0;
 
-      if (text[entry->current_pos] == ' ')
+      if ((entry->current_pos < entry->text_length) &&
+	  (TEXT_CHAR (entry, entry->current_pos) == ' '))
 	entry->current_pos += 1;
     }
 
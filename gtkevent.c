@@ -300,9 +300,6 @@ gtk_event_widget_size_request (GtkWidget      *widget,
 
   if (event_widget->child)
     {
-      event_widget->child->requisition.width = 0;
-      event_widget->child->requisition.height = 0;
-
       gtk_widget_size_request (event_widget->child, &event_widget->child->requisition);
 
       requisition->width = (event_widget->child->requisition.width +
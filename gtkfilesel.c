@@ -1853,6 +1853,9 @@ gtk_file_selection_populate (GtkFileSelection *fs,
       gtk_container_foreach ((GtkContainer*) fs->dir_list, gtk_file_selection_free_filename, NULL);
       gtk_container_foreach ((GtkContainer*) fs->file_list, gtk_file_selection_free_filename, NULL);
 
+      gtk_list_begin_update (fs->dir_list);
+      gtk_list_begin_update (fs->file_list);
+
       gtk_list_clear_items (fs->dir_list, 0, -1);
       gtk_list_clear_items (fs->file_list, 0, -1);
 
@@ -1867,6 +1870,9 @@ gtk_file_selection_populate (GtkFileSelection *fs,
 	  file_list = g_list_reverse (file_list);
 	  gtk_list_append_items (fs->file_list, file_list);
 	}
+
+      gtk_list_end_update (fs->dir_list);
+      gtk_list_end_update (fs->file_list);
     }
   else
     {
@@ -406,9 +406,6 @@ gtk_frame_size_request (GtkWidget      *widget,
 
   if (frame->child)
     {
-      frame->child->requisition.width = 0;
-      frame->child->requisition.height = 0;
-
       gtk_widget_size_request (frame->child, &frame->child->requisition);
 
       requisition->width = MAX (frame->child->requisition.width, frame->label_width);
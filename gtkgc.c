@@ -19,25 +19,46 @@
 #include "gtkprivate.h"
 
 
-#define HASH_TABLE_SIZE 127
+typedef struct _GtkGC       GtkGC;
+typedef struct _GtkGCEntry  GtkGCEntry;
 
-
-typedef struct _GtkGC  GtkGC;
+/* A shared GC together with the values it was created with.
+ *  The values are kept here rather than read back from the
+ *  GdkGC so that the hash of a GC never changes.
+ */
 struct _GtkGC
 {
   GdkGC *gc;
   gint depth;
   gint ref_count;
+  guint hash;
+
+  guint32 fg_pixel;
+  guint32 bg_pixel;
+  GdkFont *font;
+  GdkFunction function;
+  GdkFill fill;
+  GdkPixmap *tile;
+  GdkPixmap *stipple;
+  GdkSubwindowMode subwindow_mode;
+  gint graphics_exposures;
+};
+
+struct _GtkGCEntry
+{
+  gpointer key;
+  guint hash;
+  GtkGC *gtk_gc;
 };
 
 
-static void gtk_gc_init (void);
-static void gtk_gc_add (GtkGC *);
-static void gtk_gc_remove (GtkGC *);
-static GtkGC* gtk_gc_find_by_gc (GdkGC *);
-static GtkGC* gtk_gc_find_by_val (gint              depth,
-				  GdkColor         *foreground,
-				  GdkColor         *background,
+static void   gtk_gc_add         (GtkGC *gtk_gc);
+static void   gtk_gc_remove      (GtkGC *gtk_gc);
+static GtkGC* gtk_gc_find_by_gc  (GdkGC *gc);
+static GtkGC* gtk_gc_find_by_val (guint             hash,
+				  gint              depth,
+				  guint32           fg_pixel,
+				  guint32           bg_pixel,
 				  GdkFont          *font,
 				  GdkFunction       function,
 				  GdkFill           fill,
@@ -45,21 +66,47 @@ static GtkGC* gtk_gc_find_by_val (gint              depth,
 				  GdkPixmap        *stipple,
 				  GdkSubwindowMode  subwindow_mode,
 				  gint              graphics_exposures);
-static gint gtk_gc_hash (gint              depth,
-			 GdkColor         *foreground,
-			 GdkColor         *background,
-			 GdkFont          *font,
-			 GdkFunction       function,
-			 GdkFill           fill,
-			 GdkPixmap        *tile,
-			 GdkPixmap        *stipple,
-			 GdkSubwindowMode  subwindow_mode,
-			 gint              graphics_exposures);
-
+static guint  gtk_gc_hash        (gint              depth,
+				  guint32           fg_pixel,
+				  guint32           bg_pixel,
+				  GdkFont          *font,
+				  GdkFunction       function,
+				  GdkFill           fill,
+				  GdkPixmap        *tile,
+				  GdkPixmap        *stipple,
+				  GdkSubwindowMode  subwindow_mode,
+				  gint              graphics_exposures);
+static guint  gtk_gc_hash_pointer (gpointer  pointer);
+static void   gtk_gc_table_insert (GtkGCEntry **table,
+				   guint       *size,
+				   guint       *count,
+				   gpointer     key,
+				   guint        hash,
+				   GtkGC       *gtk_gc);
+static void   gtk_gc_table_remove (GtkGCEntry  *table,
+				   guint        size,
+				   guint       *count,
+				   gpointer     key,
+				   guint        hash,
+				   GtkGC       *gtk_gc);
+
+
+/* Shared GCs are found by their values in "val_table" and by
+ *  their GdkGC in "gc_table". Both are open addressing hash
+ *  tables with linear probing whose size is a power of 2, and
+ *  each entry keeps its hash so that removal and resizing never
+ *  look at the GdkGC.
+ */
+static GtkGCEntry *val_table = NULL;
+static guint val_table_size = 0;
+static guint val_table_count = 0;
+static GtkGCEntry *gc_table = NULL;
+static guint gc_table_size = 0;
+static guint gc_table_count = 0;
 
-static GList *val_hash_table[HASH_TABLE_SIZE];
-static GList *gc_hash_table[HASH_TABLE_SIZE];
-static int initialized = 0;
+static gulong gc_cache_hits = 0;
+static gulong gc_cache_misses = 0;
+static gulong gc_cache_collisions = 0;
 
 
 GdkGC*
@@ -76,29 +123,51 @@ gtk_gc_get (GdkWindow        *window,
 {
   GtkGC *gtk_gc;
   GdkGC *gdk_gc;
+  guint32 fg_pixel;
+  guint32 bg_pixel;
+  guint hash;
 
   g_function_enter ("gtk_gc_get");
 
   if (!window)
     g_error ("passed NULL window to gtk_gc_get");
 
-  gtk_gc = gtk_gc_find_by_val (window->depth, foreground, background, font,
+  fg_pixel = (foreground) ? (foreground->pixel) : (0);
+  bg_pixel = (background) ? (background->pixel) : (0);
+
+  hash = gtk_gc_hash (window->depth, fg_pixel, bg_pixel, font,
+		      function, fill, tile, stipple, subwindow_mode,
+		      graphics_exposures);
+  gtk_gc = gtk_gc_find_by_val (hash, window->depth, fg_pixel, bg_pixel, font,
 			       function, fill, tile, stipple, subwindow_mode,
 			       graphics_exposures);
 
   if (gtk_gc)
     {
+      gc_cache_hits += 1;
       gtk_gc->ref_count += 1;
       gdk_gc = gtk_gc->gc;
     }
   else
     {
+      gc_cache_misses += 1;
       gdk_gc = gdk_gc_new (window);
 
       gtk_gc = g_new (GtkGC, 1);
       gtk_gc->gc = gdk_gc;
       gtk_gc->depth = window->depth;
       gtk_gc->ref_count = 1;
+      gtk_gc->hash = hash;
+
+      gtk_gc->fg_pixel = fg_pixel;
+      gtk_gc->bg_pixel = bg_pixel;
+      gtk_gc->font = font;
+      gtk_gc->function = function;
+      gtk_gc->fill = fill;
+      gtk_gc->tile = tile;
+      gtk_gc->stipple = stipple;
+      gtk_gc->subwindow_mode = subwindow_mode;
+      gtk_gc->graphics_exposures = graphics_exposures;
 
       if (foreground)
 	gdk_gc_set_foreground (gdk_gc, foreground);
@@ -138,9 +207,6 @@ gtk_gc_release (gc)
   if (!gc)
     g_error ("passed NULL gc to gtk_gc_release");
 
-  if (!initialized)
-    gtk_gc_init ();
-
   gtk_gc = gtk_gc_find_by_gc (gc);
 
   if (gtk_gc)
@@ -157,113 +223,112 @@ gtk_gc_release (gc)
   g_function_leave ("gtk_gc_release");
 }
 
-
-static void
-gtk_gc_init ()
+/*
+ * Print the number of shared GCs, the load factor of the
+ *  value table and how often lookups hit, missed and had to
+ *  step over entries for other values.
+ */
+void
+gtk_gc_info ()
 {
-  gint i;
+  g_function_enter ("gtk_gc_info");
 
-  g_function_enter ("gtk_gc_init");
+  g_message ("gc cache: %d gcs in %d slots (load factor %.2f)",
+	     val_table_count, val_table_size,
+	     (val_table_size) ? ((gdouble) val_table_count / val_table_size) : 0.0);
+  g_message ("gc cache: %ld hits, %ld misses, %ld collisions",
+	     gc_cache_hits, gc_cache_misses, gc_cache_collisions);
 
-  for (i = 0; i < HASH_TABLE_SIZE; i++)
-    {
-      val_hash_table[i] = NULL;
-      gc_hash_table[i] = NULL;
-    }
-  initialized = 1;
+  g_function_leave ("gtk_gc_info");
+}
+
+void
+gtk_gc_get_stats (gulong *hits,
+		  gulong *misses,
+		  gulong *collisions)
+{
+  g_function_enter ("gtk_gc_get_stats");
+
+  if (hits)
+    *hits = gc_cache_hits;
+  if (misses)
+    *misses = gc_cache_misses;
+  if (collisions)
+    *collisions = gc_cache_collisions;
 
-  g_function_leave ("gtk_gc_init");
+  g_function_leave ("gtk_gc_get_stats");
 }
 
+
 static void
-gtk_gc_add (gc)
-     GtkGC *gc;
+gtk_gc_add (GtkGC *gtk_gc)
 {
-  gint hash_val;
-
   g_function_enter ("gtk_gc_add");
 
-  if (!gc)
+  if (!gtk_gc)
     g_error ("passed NULL gc to gtk_gc_add");
 
-  hash_val = gtk_gc_hash (gc->depth, &gc->gc->foreground, &gc->gc->background,
-			  gc->gc->font, gc->gc->function, gc->gc->fill, gc->gc->tile,
-			  gc->gc->stipple, gc->gc->subwindow_mode,
-			  gc->gc->graphics_exposures) % HASH_TABLE_SIZE;
-  val_hash_table[hash_val] = g_list_prepend (val_hash_table[hash_val], gc);
-
-  hash_val = ((gint) gc->gc) % HASH_TABLE_SIZE;
-  gc_hash_table[hash_val] = g_list_prepend (gc_hash_table[hash_val], gc);
+  gtk_gc_table_insert (&val_table, &val_table_size, &val_table_count,
+		       gtk_gc, gtk_gc->hash, gtk_gc);
+  gtk_gc_table_insert (&gc_table, &gc_table_size, &gc_table_count,
+		       gtk_gc->gc, gtk_gc_hash_pointer (gtk_gc->gc), gtk_gc);
 
   g_function_leave ("gtk_gc_add");
 }
 
 static void
-gtk_gc_remove (gc)
-     GtkGC *gc;
+gtk_gc_remove (GtkGC *gtk_gc)
 {
-  gint hash_val;
-
   g_function_enter ("gtk_gc_remove");
 
-  if (!gc)
+  if (!gtk_gc)
     g_error ("passed NULL gc to gtk_gc_remove");
 
-  hash_val = gtk_gc_hash (gc->depth, &gc->gc->foreground, &gc->gc->background,
-			  gc->gc->font, gc->gc->function, gc->gc->fill, gc->gc->tile,
-			  gc->gc->stipple, gc->gc->subwindow_mode,
-			  gc->gc->graphics_exposures) % HASH_TABLE_SIZE;
-  val_hash_table[hash_val] = g_list_remove (val_hash_table[hash_val], gc);
-
-  hash_val = ((gint) gc->gc) % HASH_TABLE_SIZE;
-  gc_hash_table[hash_val] = g_list_remove (gc_hash_table[hash_val], gc);
+  gtk_gc_table_remove (val_table, val_table_size, &val_table_count,
+		       gtk_gc, gtk_gc->hash, gtk_gc);
+  gtk_gc_table_remove (gc_table, gc_table_size, &gc_table_count,
+		       gtk_gc->gc, gtk_gc_hash_pointer (gtk_gc->gc), gtk_gc);
 
   g_function_leave ("gtk_gc_remove");
 }
 
 static GtkGC*
-gtk_gc_find_by_gc (gc)
-     GdkGC *gc;
+gtk_gc_find_by_gc (GdkGC *gc)
 {
-  GList *temp_list;
-  gint hash_val;
   GtkGC *gtk_gc;
-  gint got_it;
+  guint index;
 
   g_function_enter ("gtk_gc_find_by_gc");
 
   if (!gc)
     g_error ("passed NULL gc to gtk_gc_find_by_gc");
 
-  hash_val = ((gint) gc) % HASH_TABLE_SIZE;
-  temp_list = gc_hash_table[hash_val];
-
-  got_it = FALSE;
   gtk_gc = NULL;
 
-  while (temp_list)
+  if (gc_table_count)
     {
-      gtk_gc = temp_list->data;
-      temp_list = temp_list->next;
-
-      if (gtk_gc->gc == gc)
+      index = gtk_gc_hash_pointer (gc) & (gc_table_size - 1);
+      while (gc_table[index].gtk_gc)
 	{
-	  got_it = TRUE;
-	  break;
+	  if (gc_table[index].key == gc)
+	    {
+	      gtk_gc = gc_table[index].gtk_gc;
+	      break;
+	    }
+
+	  index = (index + 1) & (gc_table_size - 1);
 	}
     }
 
-  if (!got_it)
-    gtk_gc = NULL;
-
   g_function_leave ("gtk_gc_find_by_gc");
   return gtk_gc;
 }
 
 static GtkGC*
-gtk_gc_find_by_val (gint              depth,
-		    GdkColor         *foreground,
-		    GdkColor         *background,
+gtk_gc_find_by_val (guint             hash,
+		    gint              depth,
+		    guint32           fg_pixel,
+		    guint32           bg_pixel,
 		    GdkFont          *font,
 		    GdkFunction       function,
 		    GdkFill           fill,
@@ -272,60 +337,45 @@ gtk_gc_find_by_val (gint              depth,
 		    GdkSubwindowMode  subwindow_mode,
 		    gint              graphics_exposures)
 {
-  GList *temp_list;
   GtkGC *gtk_gc;
-  GdkGC *gdk_gc;
-  guint32 fg_pixel;
-  guint32 bg_pixel;
-  gint hash_val;
-  gint got_it;
+  guint index;
 
   g_function_enter ("gtk_gc_find_by_val");
 
-  hash_val = gtk_gc_hash (depth, foreground, background, font,
-			  function, fill, tile, stipple, subwindow_mode,
-			  graphics_exposures) % HASH_TABLE_SIZE;
-  temp_list = val_hash_table[hash_val];
-
-  fg_pixel = (foreground) ? (foreground->pixel) : (0);
-  bg_pixel = (background) ? (background->pixel) : (0);
-
-  got_it = FALSE;
-  gtk_gc = NULL;
-
-  while (temp_list)
+  if (!val_table_count)
     {
-      gtk_gc = temp_list->data;
-      temp_list = temp_list->next;
-
-      gdk_gc = gtk_gc->gc;
-      if ((gtk_gc->depth == depth) &&
-	  (gdk_gc->foreground.pixel == fg_pixel) &&
-	  (gdk_gc->background.pixel == bg_pixel) &&
-	  (gdk_gc->font == font) &&
-	  (gdk_gc->function == function) &&
-	  (gdk_gc->fill == fill) &&
-	  (gdk_gc->tile == tile) &&
-	  (gdk_gc->stipple == stipple) &&
-	  (gdk_gc->subwindow_mode == subwindow_mode) &&
-	  (gdk_gc->graphics_exposures == graphics_exposures))
-	{
-	  got_it = TRUE;
-	  break;
-	}
+      g_function_leave ("gtk_gc_find_by_val");
+      return NULL;
     }
 
-  if (!got_it)
-    gtk_gc = NULL;
+  index = hash & (val_table_size - 1);
+  while ((gtk_gc = val_table[index].gtk_gc))
+    {
+      if ((gtk_gc->hash == hash) &&
+	  (gtk_gc->depth == depth) &&
+	  (gtk_gc->fg_pixel == fg_pixel) &&
+	  (gtk_gc->bg_pixel == bg_pixel) &&
+	  (gtk_gc->font == font) &&
+	  (gtk_gc->function == function) &&
+	  (gtk_gc->fill == fill) &&
+	  (gtk_gc->tile == tile) &&
+	  (gtk_gc->stipple == stipple) &&
+	  (gtk_gc->subwindow_mode == subwindow_mode) &&
+	  (gtk_gc->graphics_exposures == graphics_exposures))
+	break;
+
+      gc_cache_collisions += 1;
+      index = (index + 1) & (val_table_size - 1);
+    }
 
   g_function_leave ("gtk_gc_find_by_val");
   return gtk_gc;
 }
 
-static gint
+static guint
 gtk_gc_hash (gint              depth,
-	     GdkColor         *foreground,
-	     GdkColor         *background,
+	     guint32           fg_pixel,
+	     guint32           bg_pixel,
 	     GdkFont          *font,
 	     GdkFunction       function,
 	     GdkFill           fill,
@@ -334,30 +384,144 @@ gtk_gc_hash (gint              depth,
 	     GdkSubwindowMode  subwindow_mode,
 	     gint              graphics_exposures)
 {
-  gint hash_value;
+  guint64 key;
 
   g_function_enter ("gtk_gc_hash");
 
-  hash_value = depth;
+  /* Fold in the values one at a time, multiplying in between
+   *  so that the order matters, and mix the result so that all
+   *  of its bits depend on all of the values.
+   */
+  key = depth;
+  key = key * 0x9e3779b97f4a7c15ULL + fg_pixel;
+  key = key * 0x9e3779b97f4a7c15ULL + bg_pixel;
+  key = key * 0x9e3779b97f4a7c15ULL + (gulong) font;
+  key = key * 0x9e3779b97f4a7c15ULL + function;
+  key = key * 0x9e3779b97f4a7c15ULL + fill;
+  key = key * 0x9e3779b97f4a7c15ULL + (gulong) tile;
+  key = key * 0x9e3779b97f4a7c15ULL + (gulong) stipple;
+  key = key * 0x9e3779b97f4a7c15ULL + subwindow_mode;
+  key = key * 0x9e3779b97f4a7c15ULL + graphics_exposures;
+
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
 
-  if (foreground)
-    hash_value += (foreground->red +
-		   foreground->green +
-		   foreground->blue);
+  g_function_leave ("gtk_gc_hash");
+  return (guint) key;
+}
 
-  if (background)
-    hash_value += (background->red +
-		   background->green +
-		   background->blue);
+static guint
+gtk_gc_hash_pointer (gpointer pointer)
+{
+  guint64 key;
 
-  hash_value += (gint) font;
-  hash_value += function;
-  hash_value += fill;
-  hash_value += (gint) tile;
-  hash_value += (gint) stipple;
-  hash_value += subwindow_mode;
-  hash_value += graphics_exposures;
+  key = (gulong) pointer;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
 
-  g_function_leave ("gtk_gc_hash");
-  return hash_value;
+  return (guint) key;
+}
+
+static void
+gtk_gc_table_insert (GtkGCEntry **table,
+		     guint       *size,
+		     guint       *count,
+		     gpointer     key,
+		     guint        hash,
+		     GtkGC       *gtk_gc)
+{
+  GtkGCEntry *old_table;
+  guint old_size;
+  guint index;
+  guint i;
+
+  /* Keep the load factor below 1/2 so that probe sequences
+   *  stay short.
+   */
+  if ((*count + 1) * 2 > *size)
+    {
+      old_table = *table;
+      old_size = *size;
+
+      *size = (old_size) ? (old_size * 2) : 64;
+      *table = g_new (GtkGCEntry, *size);
+      for (i = 0; i < *size; i++)
+	{
+	  (*table)[i].key = NULL;
+	  (*table)[i].hash = 0;
+	  (*table)[i].gtk_gc = NULL;
+	}
+
+      for (i = 0; i < old_size; i++)
+	if (old_table[i].gtk_gc)
+	  {
+	    index = old_table[i].hash & (*size - 1);
+	    while ((*table)[index].gtk_gc)
+	      index = (index + 1) & (*size - 1);
+	    (*table)[index] = old_table[i];
+	  }
+
+      if (old_table)
+	g_free (old_table);
+    }
+
+  index = hash & (*size - 1);
+  while ((*table)[index].gtk_gc)
+    index = (index + 1) & (*size - 1);
+
+  (*table)[index].key = key;
+  (*table)[index].hash = hash;
+  (*table)[index].gtk_gc = gtk_gc;
+  *count += 1;
+}
+
+static void
+gtk_gc_table_remove (GtkGCEntry  *table,
+		     guint        size,
+		     guint       *count,
+		     gpointer     key,
+		     guint        hash,
+		     GtkGC       *gtk_gc)
+{
+  guint index;
+  guint next;
+  guint home;
+
+  if (!*count)
+    return;
+
+  index = hash & (size - 1);
+  while (table[index].gtk_gc && (table[index].key != key))
+    index = (index + 1) & (size - 1);
+
+  if (!table[index].gtk_gc)
+    return;
+
+  /* Shift back the entries after the removed one which would
+   *  no longer be found, as in the window table.
+   */
+  next = index;
+  while (1)
+    {
+      next = (next + 1) & (size - 1);
+      if (!table[next].gtk_gc)
+	break;
+
+      home = table[next].hash & (size - 1);
+
+      if (((next - home) & (size - 1)) >= ((next - index) & (size - 1)))
+	{
+	  table[index] = table[next];
+	  index = next;
+	}
+    }
+
+  table[index].key = NULL;
+  table[index].hash = 0;
+  table[index].gtk_gc = NULL;
+  *count -= 1;
 }
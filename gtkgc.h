@@ -25,6 +25,11 @@ GdkGC* gtk_gc_get   (GdkWindow        *window,
 		     gint              graphics_exposures);
 void gtk_gc_release (GdkGC      *gc);
 
+void gtk_gc_info      (void);
+void gtk_gc_get_stats (gulong     *hits,
+		       gulong     *misses,
+		       gulong     *collisions);
+
 
 #ifdef __cplusplus
 }
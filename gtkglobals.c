@@ -24,3 +24,4 @@ GdkColor      gtk_default_selected_foreground = { 0, 0, 0, 0 };
 GdkColor      gtk_default_selected_background = { 0, 45000, 45000, 55000 };
 gint          gtk_default_shadow_thickness = 2;
 char         *gtk_default_font_name = NULL;
+gint          gtk_double_buffer = TRUE;
@@ -15,6 +15,7 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
  */
+#include <string.h>
 #include "gtkcontainer.h"
 #include "gtkdata.h"
 #include "gtklist.h"
@@ -28,6 +29,13 @@
 #define LIST_TIMER_LENGTH  40
 
 
+typedef enum
+{
+  GTK_LIST_RANGE_SELECT,
+  GTK_LIST_RANGE_UNSELECT,
+  GTK_LIST_RANGE_INVERT
+} GtkListRangeOp;
+
 typedef struct _GtkList      GtkList;
 typedef struct _GtkListItem  GtkListItem;
 typedef struct _GtkListBox   GtkListBox;
@@ -46,14 +54,66 @@ struct _GtkList
   GtkDataList selection;
 
   guint32 timer;
-  guint16 select_start_pos;
-  guint16 select_end_pos;
+  gint select_start_pos;
+  gint select_end_pos;
   unsigned int scroll_direction : 1;
   unsigned int have_grab : 1;
+  unsigned int is_virtual : 1;
+  unsigned int in_layout : 1;
+  unsigned int windowless_items : 1;
+  unsigned int resize_pending : 1;
+  unsigned int selection_pending : 1;
+  unsigned int changes_unknown : 1;
+
+  /* While "update_depth" is non-zero the list doesn't resize or
+   *  notify its selection. gtk_list_end_update does both once.
+   */
+  gint update_depth;
 
   GtkDataAdjustment *hadjustment;
   GtkDataAdjustment *vadjustment;
   GtkObserver adjustment_observer;
+
+  /* A virtual list only has "npool" children which are reused
+   *  for the rows in view. Since the list items don't last the
+   *  selection is kept in "selected_bits", one bit per row.
+   */
+  GtkListCreateRowFunc create_row;
+  GtkListSetRowFunc set_row;
+  gpointer row_data;
+  gint nrows;
+  gint npool;
+  gint row_height;
+  gint view_offset;
+  gint fixed_row_height;
+  guint32 *selected_bits;
+  gint nselected;
+
+  /* The rows whose selection changed since the selection was
+   *  last notified, as sorted and separate pairs of start and
+   *  (exclusive) end rows. "changes_unknown" is set when a change
+   *  wasn't recorded row by row, and "whole_range" is then
+   *  reported instead.
+   */
+  gint *changed_ranges;
+  gint nchanged_ranges;
+  gint changed_ranges_size;
+  gint whole_range[2];
+
+  /* "row_index" is a Fenwick tree over the heights of the
+   *  children (0 for hidden ones), so that the offset of a row
+   *  and the row at an offset can be found in O(log n). "rows"
+   *  maps a row back to its list item. The index is rebuilt by
+   *  the next size request after children were added or
+   *  removed and is updated in place when only heights change.
+   */
+  gint nchildren;
+  gint nindexed;
+  gint index_size;
+  gint *row_index;
+  gint *row_heights;
+  GtkWidget **rows;
+  unsigned int index_valid : 1;
 };
 
 struct _GtkListItem
@@ -61,6 +121,8 @@ struct _GtkListItem
   GtkContainer container;
 
   GtkWidget *child;
+  gint row;
+  unsigned int removing : 1;
 
   GtkDataInt state;
   GtkObserver state_observer;
@@ -89,6 +151,8 @@ static void   gtk_list_add            (GtkContainer    *container,
 				       GtkWidget       *widget);
 static void   gtk_list_remove         (GtkContainer    *container,
 				       GtkWidget       *widget);
+static void   gtk_list_need_resize    (GtkContainer    *container,
+				       GtkWidget       *widget);
 static void   gtk_list_foreach        (GtkContainer    *container,
 				       GtkCallback      callback,
 				       gpointer         callback_data);
@@ -100,6 +164,62 @@ static void   gtk_list_select_update  (GtkList         *list,
 static void   gtk_list_unselect_child (GtkList         *list,
 				       GtkListItem     *list_item);
 static void   gtk_list_unselect_all   (GtkList         *list);
+static void   gtk_list_prepare_item   (GtkList         *list,
+				       GtkWidget       *widget);
+static gint   gtk_list_remove_marked_selection (GtkList *list);
+static void   gtk_list_children_changed (GtkList       *list,
+					 GtkWidget     *widget,
+					 gint           selection_changed);
+
+static void   gtk_list_index_build          (GtkList      *list);
+static void   gtk_list_index_update         (GtkList      *list,
+					     gint          row,
+					     gint          height);
+static gint   gtk_list_index_offset         (GtkList      *list,
+					     gint          row);
+static gint   gtk_list_index_row            (GtkList      *list,
+					     gint          pos);
+static gint   gtk_list_index_find           (GtkList      *list,
+					     gint          offset);
+static gint   gtk_list_set_item_selected    (GtkList      *list,
+					     GtkListItem  *list_item,
+					     gint          selected);
+
+static void   gtk_list_virtual_grow_pool    (GtkList      *list,
+					     gint          npool);
+static gint   gtk_list_virtual_offset       (GtkList      *list);
+static void   gtk_list_virtual_layout       (GtkList      *list,
+					     gint          scrolled);
+static void   gtk_list_virtual_scroll       (GtkList      *list);
+static void   gtk_list_virtual_select       (GtkList      *list,
+					     gint          row,
+					     gint          toggle);
+static void   gtk_list_virtual_unselect     (GtkList      *list,
+					     gint          row);
+static gint   gtk_list_virtual_set_state    (GtkList      *list,
+					     gint          row,
+					     GtkStateType  state);
+static gint   gtk_list_virtual_get_state    (GtkList      *list,
+					     gint          row);
+static gint   gtk_list_virtual_change_range (GtkList      *list,
+					     gint          start,
+					     gint          end,
+					     GtkListRangeOp op);
+static void   gtk_list_change_range         (GtkList      *list,
+					     gint          start,
+					     gint          end,
+					     GtkListRangeOp op);
+static void   gtk_list_selection_changed    (GtkList      *list,
+					     gint          start,
+					     gint          end);
+static void   gtk_list_selection_notify     (GtkList      *list);
+static void   gtk_list_selection_notify_all (GtkList      *list);
+static void   gtk_list_clip_selection_changes (GtkList    *list,
+					       gint        nrows);
+static void   gtk_list_prune_selection      (GtkList      *list);
+static gint   gtk_list_virtual_unselect_all (GtkList      *list,
+					     gint          except_row);
+static void   gtk_list_virtual_sync_states  (GtkList      *list);
 
 static void   gtk_list_add_timer      (GtkList         *list);
 static void   gtk_list_remove_timer   (GtkList         *list);
@@ -199,7 +319,7 @@ static GtkContainerFunctions list_container_functions =
 {
   gtk_list_add,
   gtk_list_remove,
-  gtk_container_default_need_resize,
+  gtk_list_need_resize,
   gtk_container_default_focus_advance,
   gtk_list_foreach,
 };
@@ -242,6 +362,35 @@ gtk_list_new (GtkDataAdjustment *hadjustment,
   list->timer = 0;
   list->scroll_direction = 0;
   list->have_grab = FALSE;
+  list->is_virtual = FALSE;
+  list->in_layout = FALSE;
+  list->view_offset = 0;
+  list->windowless_items = FALSE;
+  list->resize_pending = FALSE;
+  list->selection_pending = FALSE;
+  list->changes_unknown = FALSE;
+  list->update_depth = 0;
+
+  list->create_row = NULL;
+  list->set_row = NULL;
+  list->row_data = NULL;
+  list->nrows = 0;
+  list->npool = 0;
+  list->row_height = 0;
+  list->fixed_row_height = 0;
+  list->selected_bits = NULL;
+  list->nselected = 0;
+  list->changed_ranges = NULL;
+  list->nchanged_ranges = 0;
+  list->changed_ranges_size = 0;
+
+  list->nchildren = 0;
+  list->nindexed = 0;
+  list->index_size = 0;
+  list->row_index = NULL;
+  list->row_heights = NULL;
+  list->rows = NULL;
+  list->index_valid = FALSE;
 
   if (hadjustment)
     list->hadjustment = hadjustment;
@@ -250,7 +399,7 @@ gtk_list_new (GtkDataAdjustment *hadjustment,
       gtk_data_adjustment_new (0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
 
   if (vadjustment)
-    list->hadjustment = vadjustment;
+    list->vadjustment = vadjustment;
   else
     list->vadjustment = (GtkDataAdjustment*)
       gtk_data_adjustment_new (0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
@@ -283,6 +432,8 @@ gtk_list_item_new ()
   gtk_container_set_defaults ((GtkWidget*) list_item);
 
   list_item->child = NULL;
+  list_item->row = -1;
+  list_item->removing = FALSE;
 
   gtk_data_init ((GtkData*) &list_item->state);
   list_item->state.value = GTK_STATE_NORMAL;
@@ -337,7 +488,15 @@ gtk_list_insert_items (GtkWidget *list,
   g_assert (items != NULL);
 
   rlist = (GtkList*) list;
-  nchildren = g_list_length (rlist->children);
+  if (rlist->is_virtual)
+    {
+      g_warning ("gtk_list_insert_items: can't insert items into a virtual list");
+      g_function_leave ("gtk_list_insert_items");
+      return;
+    }
+
+  nchildren = rlist->nchildren;
+  rlist->index_valid = FALSE;
 
   temp_list = items;
   while (temp_list)
@@ -346,6 +505,8 @@ gtk_list_insert_items (GtkWidget *list,
       temp_list = temp_list->next;
 
       widget->parent = (GtkContainer*) list;
+      gtk_list_prepare_item (rlist, widget);
+      rlist->nchildren += 1;
 
       if (GTK_WIDGET_VISIBLE (widget->parent))
 	{
@@ -390,13 +551,7 @@ gtk_list_insert_items (GtkWidget *list,
 	rlist->children = items;
     }
 
-  widget = rlist->children->data;
-
-  if ((rlist->mode == GTK_SELECTION_BROWSE) && !rlist->selection.list)
-    gtk_list_select_child (rlist, (GtkListItem*) widget, FALSE);
-
-  if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (rlist))
-    gtk_container_need_resize ((GtkContainer*) rlist, widget);
+  gtk_list_children_changed (rlist, rlist->children->data, FALSE);
 
   g_function_leave ("gtk_list_insert_items");
 }
@@ -436,66 +591,63 @@ gtk_list_remove_items (GtkWidget *list,
   GtkList *rlist;
   GtkWidget *widget;
   GList *temp_list;
-  GList *temp_list2;
+  GList *link;
+  gint selection_changed;
 
   g_function_enter ("gtk_list_remove_items");
 
   g_assert (list != NULL);
   g_assert (items != NULL);
 
-  /*  traverse through the list of items, searching for
-   *  each in the list's children list, and removing any located instances
-   */
   rlist = (GtkList*) list;
+  if (rlist->is_virtual)
+    {
+      g_warning ("gtk_list_remove_items: can't remove items from a virtual list");
+      g_function_leave ("gtk_list_remove_items");
+      return;
+    }
+
+  /*  mark the items being removed, so that the list's children
+   *  and selection can each be filtered in a single pass
+   */
   temp_list = items;
   while (temp_list)
     {
-      widget = temp_list->data;
+      ((GtkListItem*) temp_list->data)->removing = TRUE;
       temp_list = temp_list->next;
+    }
 
-      /*  remove link from the list of children  */
-      temp_list2 = rlist->children;
-      while (temp_list2)
-	{
-	  if (widget == (GtkWidget*) temp_list2->data)
-	    {
-	      rlist->children = g_list_remove_link (rlist->children, temp_list2);
-	      break;
-	    }
-	  temp_list2 = temp_list2->next;
-	}
+  temp_list = rlist->children;
+  while (temp_list)
+    {
+      link = temp_list;
+      temp_list = temp_list->next;
 
-      /*  remove link from the list of selected items  */
-      temp_list2 = rlist->selection.list;
-      while (temp_list2)
+      if (((GtkListItem*) link->data)->removing)
 	{
-	  if (widget == (GtkWidget*) temp_list2->data)
-	    {
-	      rlist->selection.list = g_list_remove_link (rlist->selection.list, temp_list2);
-	      break;
-	    }
-	  temp_list2 = temp_list2->next;
+	  rlist->children = g_list_remove_link (rlist->children, link);
+	  g_list_free (link);
+	  rlist->nchildren -= 1;
+	  rlist->index_valid = FALSE;
 	}
-
-      if (GTK_WIDGET_MAPPED (widget))
-	gtk_widget_unmap (widget);
-      widget->parent = NULL;
     }
 
-  if (rlist->children)
-    {
-      widget = rlist->children->data;
+  selection_changed = gtk_list_remove_marked_selection (rlist);
 
-      if ((rlist->mode == GTK_SELECTION_BROWSE) && !rlist->selection.list)
-	gtk_list_select_child (rlist, (GtkListItem*) widget, FALSE);
-    }
-  else
+  temp_list = items;
+  while (temp_list)
     {
-      widget = NULL;
+      widget = temp_list->data;
+      temp_list = temp_list->next;
+
+      ((GtkListItem*) widget)->removing = FALSE;
+      if (GTK_WIDGET_MAPPED (widget))
+	gtk_widget_unmap (widget);
+      widget->parent = NULL;
     }
 
-  if (widget && GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (rlist))
-    gtk_container_need_resize ((GtkContainer*) rlist, widget);
+  gtk_list_children_changed (rlist, rlist->children ? rlist->children->data : NULL,
+			     selection_changed);
 
   g_function_leave ("gtk_list_remove_items");
 }
@@ -508,10 +660,10 @@ gtk_list_clear_items (GtkWidget *list,
   GtkList *rlist;
   GtkWidget *widget;
   GList *temp_list;
-  GList *temp_list2;
   GList *start_list;
   GList *end_list;
   gint nchildren;
+  gint selection_changed;
 
   g_function_enter ("gtk_list_clear_items");
 
@@ -519,7 +671,14 @@ gtk_list_clear_items (GtkWidget *list,
   g_assert (start >= 0);
 
   rlist = (GtkList*) list;
-  nchildren = g_list_length (rlist->children);
+  if (rlist->is_virtual)
+    {
+      g_warning ("gtk_list_clear_items: can't clear items of a virtual list");
+      g_function_leave ("gtk_list_clear_items");
+      return;
+    }
+
+  nchildren = rlist->nchildren;
 
   if (nchildren > 0)
     {
@@ -528,6 +687,9 @@ gtk_list_clear_items (GtkWidget *list,
 
       g_assert (start < end);
 
+      rlist->nchildren -= end - start;
+      rlist->index_valid = FALSE;
+
       start_list = g_list_nth (rlist->children, start);
       end_list = g_list_nth (rlist->children, end);
 
@@ -543,39 +705,25 @@ gtk_list_clear_items (GtkWidget *list,
       temp_list = start_list;
       while (temp_list)
 	{
-	  widget = temp_list->data;
+	  ((GtkListItem*) temp_list->data)->removing = TRUE;
 	  temp_list = temp_list->next;
-
-	  temp_list2 = rlist->selection.list;
-	  while (temp_list2)
-	    {
-	      if (widget == (GtkWidget*) temp_list2->data)
-		{
-		  rlist->selection.list = g_list_remove_link (rlist->selection.list, temp_list2);
-		  break;
-		}
-	      temp_list2 = temp_list2->next;
-	    }
-
-	  gtk_widget_destroy (widget);
 	}
 
-      g_list_free (start_list);
+      selection_changed = gtk_list_remove_marked_selection (rlist);
 
-      if (rlist->children)
+      temp_list = start_list;
+      while (temp_list)
 	{
-	  widget = rlist->children->data;
+	  widget = temp_list->data;
+	  temp_list = temp_list->next;
 
-	  if ((rlist->mode == GTK_SELECTION_BROWSE) && !rlist->selection.list)
-	    gtk_list_select_child (rlist, (GtkListItem*) widget, FALSE);
-	}
-      else
-	{
-	  widget = NULL;
+	  gtk_widget_destroy (widget);
 	}
 
-      if (widget && GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (rlist))
-	gtk_container_need_resize ((GtkContainer*) rlist, widget);
+      g_list_free (start_list);
+
+      gtk_list_children_changed (rlist, rlist->children ? rlist->children->data : NULL,
+				 selection_changed);
     }
 
   g_function_leave ("gtk_list_clear_items");
@@ -597,6 +745,219 @@ gtk_list_set_selection_mode (GtkWidget        *list,
   g_function_leave ("gtk_list_set_selection_mode");
 }
 
+void
+gtk_list_begin_update (GtkWidget *list)
+{
+  GtkList *rlist;
+
+  g_function_enter ("gtk_list_begin_update");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  rlist->update_depth += 1;
+
+  g_function_leave ("gtk_list_begin_update");
+}
+
+void
+gtk_list_end_update (GtkWidget *list)
+{
+  GtkList *rlist;
+  GtkWidget *child;
+  GList *children;
+  gint selection_changed;
+
+  g_function_enter ("gtk_list_end_update");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+  g_assert (rlist->update_depth > 0);
+
+  rlist->update_depth -= 1;
+  if (rlist->update_depth == 0)
+    {
+      selection_changed = rlist->selection_pending;
+      rlist->selection_pending = FALSE;
+
+      if ((rlist->mode == GTK_SELECTION_BROWSE) &&
+	  !rlist->selection.list && rlist->children)
+	{
+	  /* gtk_list_select_child notifies the selection itself */
+	  gtk_list_select_child (rlist, rlist->children->data, FALSE);
+	  selection_changed = FALSE;
+	}
+
+      if (selection_changed)
+	gtk_list_selection_notify (rlist);
+
+      if (rlist->resize_pending)
+	{
+	  rlist->resize_pending = FALSE;
+
+	  if (GTK_WIDGET_VISIBLE (list) && list->parent)
+	    gtk_container_need_resize (list->parent, list);
+
+	  /* Outside of an update each list item added was realized
+	   *  and mapped as it went in. Catch up on that now. (The
+	   *  list items of a virtual list are mapped by its layout).
+	   */
+	  if (GTK_WIDGET_VISIBLE (list) && !rlist->is_virtual)
+	    {
+	      children = rlist->children;
+	      while (children)
+		{
+		  child = children->data;
+		  children = children->next;
+
+		  if (GTK_WIDGET_VISIBLE (child))
+		    {
+		      if (GTK_WIDGET_REALIZED (list) &&
+			  !GTK_WIDGET_REALIZED (child))
+			gtk_widget_realize (child);
+
+		      if (GTK_WIDGET_MAPPED (list) &&
+			  !GTK_WIDGET_MAPPED (child))
+			gtk_widget_map (child);
+		    }
+		}
+	    }
+	}
+    }
+
+  g_function_leave ("gtk_list_end_update");
+}
+
+void
+gtk_list_select_range (GtkWidget *list,
+		       gint       start,
+		       gint       end)
+{
+  g_function_enter ("gtk_list_select_range");
+
+  g_assert (list != NULL);
+  gtk_list_change_range ((GtkList*) list, start, end, GTK_LIST_RANGE_SELECT);
+
+  g_function_leave ("gtk_list_select_range");
+}
+
+void
+gtk_list_unselect_range (GtkWidget *list,
+			 gint       start,
+			 gint       end)
+{
+  g_function_enter ("gtk_list_unselect_range");
+
+  g_assert (list != NULL);
+  gtk_list_change_range ((GtkList*) list, start, end, GTK_LIST_RANGE_UNSELECT);
+
+  g_function_leave ("gtk_list_unselect_range");
+}
+
+void
+gtk_list_invert_range (GtkWidget *list,
+		       gint       start,
+		       gint       end)
+{
+  g_function_enter ("gtk_list_invert_range");
+
+  g_assert (list != NULL);
+  gtk_list_change_range ((GtkList*) list, start, end, GTK_LIST_RANGE_INVERT);
+
+  g_function_leave ("gtk_list_invert_range");
+}
+
+gint
+gtk_list_row_is_selected (GtkWidget *list,
+			  gint       row)
+{
+  GtkList *rlist;
+  gint return_val;
+
+  g_function_enter ("gtk_list_row_is_selected");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  return_val = FALSE;
+  if (rlist->is_virtual)
+    {
+      if ((row >= 0) && (row < rlist->nrows))
+	return_val = (gtk_list_virtual_get_state (rlist, row) == GTK_STATE_SELECTED);
+    }
+  else
+    {
+      if (!rlist->index_valid)
+	gtk_list_index_build (rlist);
+
+      if ((row >= 0) && (row < rlist->nindexed))
+	return_val = (((GtkListItem*) rlist->rows[row])->state.value == GTK_STATE_SELECTED);
+    }
+
+  g_function_leave ("gtk_list_row_is_selected");
+  return return_val;
+}
+
+gint
+gtk_list_get_selection_changes (GtkWidget  *list,
+				gint      **ranges)
+{
+  GtkList *rlist;
+  gint return_val;
+
+  g_function_enter ("gtk_list_get_selection_changes");
+
+  g_assert (list != NULL);
+  g_assert (ranges != NULL);
+  rlist = (GtkList*) list;
+
+  if (rlist->changes_unknown || (rlist->nchanged_ranges == 0))
+    {
+      rlist->whole_range[0] = 0;
+      rlist->whole_range[1] = rlist->is_virtual ? rlist->nrows : rlist->nchildren;
+
+      *ranges = rlist->whole_range;
+      return_val = 1;
+    }
+  else
+    {
+      *ranges = rlist->changed_ranges;
+      return_val = rlist->nchanged_ranges;
+    }
+
+  g_function_leave ("gtk_list_get_selection_changes");
+  return return_val;
+}
+
+void
+gtk_list_set_windowless_items (GtkWidget *list,
+			       gint       windowless)
+{
+  GtkList *rlist;
+  GList *children;
+
+  g_function_enter ("gtk_list_set_windowless_items");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  /* Windowless list items draw directly into the list window
+   *  and the list finds out which item was clicked on itself.
+   *  Only items which haven't been realized yet can be changed,
+   *  either way.
+   */
+  rlist->windowless_items = (windowless != FALSE);
+
+  children = rlist->children;
+  while (children)
+    {
+      gtk_list_prepare_item (rlist, children->data);
+      children = children->next;
+    }
+
+  g_function_leave ("gtk_list_set_windowless_items");
+}
+
 void
 gtk_list_get_list_size (GtkWidget *list,
 			gint    *width,
@@ -669,92 +1030,300 @@ gtk_list_item_get_state (GtkWidget *item)
 }
 
 void
-gtk_list_select_item (GtkWidget *list,
-		      gint     item)
+gtk_list_set_virtual (GtkWidget            *list,
+		      GtkListCreateRowFunc  create_row,
+		      GtkListSetRowFunc     set_row,
+		      gpointer              data)
 {
   GtkList *rlist;
-  GtkListItem *list_item;
-  GList *temp_list;
 
-  g_function_enter ("gtk_list_select_item");
+  g_function_enter ("gtk_list_set_virtual");
 
   g_assert (list != NULL);
+  g_assert (create_row != NULL);
+  g_assert (set_row != NULL);
   rlist = (GtkList*) list;
 
-  temp_list = g_list_nth (rlist->children, item);
-  g_assert (temp_list != NULL);
+  if (rlist->children && !rlist->is_virtual)
+    {
+      g_warning ("gtk_list_set_virtual: list already has items");
+      g_function_leave ("gtk_list_set_virtual");
+      return;
+    }
 
-  list_item = temp_list->data;
-  g_assert (list_item != NULL);
+  rlist->is_virtual = TRUE;
+  rlist->create_row = create_row;
+  rlist->set_row = set_row;
+  rlist->row_data = data;
 
-  gtk_list_select_child (rlist, list_item, FALSE);
+  gtk_list_refresh_rows (list, 0, -1);
 
-  g_function_leave ("gtk_list_select_item");
+  g_function_leave ("gtk_list_set_virtual");
 }
 
 void
-gtk_list_unselect_item (GtkWidget *list,
-			gint     item)
+gtk_list_set_row_count (GtkWidget *list,
+			gint       nrows)
 {
   GtkList *rlist;
-  GtkListItem *list_item;
-  GList *temp_list;
+  gint changed;
+  gint nwords;
+  gint i;
 
-  g_function_enter ("gtk_list_unselect_item");
+  g_function_enter ("gtk_list_set_row_count");
 
   g_assert (list != NULL);
+  g_assert (nrows >= 0);
   rlist = (GtkList*) list;
+  g_assert (rlist->is_virtual);
 
-  temp_list = g_list_nth (rlist->children, item);
-  g_assert (temp_list != NULL);
+  if (nrows != rlist->nrows)
+    {
+      /* Rows beyond the new count are unselected first so that
+       *  the bits are clear if the list grows again. Changes to
+       *  them aren't reported since the rows are gone.
+       */
+      changed = FALSE;
+      if (nrows < rlist->nrows)
+	{
+	  changed = gtk_list_virtual_change_range (rlist, nrows, rlist->nrows,
+						   GTK_LIST_RANGE_UNSELECT);
+	  gtk_list_clip_selection_changes (rlist, nrows);
+	}
 
-  list_item = temp_list->data;
-  g_assert (list_item != NULL);
+      nwords = (nrows + 31) / 32;
+      rlist->selected_bits = g_realloc (rlist->selected_bits, sizeof (guint32) * MAX (nwords, 1));
+      for (i = (rlist->nrows + 31) / 32; i < nwords; i++)
+	rlist->selected_bits[i] = 0;
+      rlist->nrows = nrows;
 
-  gtk_list_unselect_child (rlist, list_item);
+      gtk_list_refresh_rows (list, 0, -1);
 
-  g_function_leave ("gtk_list_unselect_item");
+      if (changed)
+	{
+	  if (rlist->update_depth > 0)
+	    rlist->selection_pending = TRUE;
+	  else
+	    gtk_list_selection_notify (rlist);
+	}
+
+      if (GTK_WIDGET_VISIBLE (list) && list->parent)
+	gtk_container_need_resize (list->parent, list);
+    }
+
+  g_function_leave ("gtk_list_set_row_count");
 }
 
-gint*
-gtk_list_get_selected (GtkWidget *list,
-		       gint      *nitems)
+void
+gtk_list_set_row_height (GtkWidget *list,
+			 gint       height)
 {
   GtkList *rlist;
-  GtkListItem *list_item;
-  GList *temp_list;
-  gint *selected_items;
-  gint n_selected_items;
-  gint index, lindex;
 
-  g_function_enter ("gtk_list_get_selected");
+  g_function_enter ("gtk_list_set_row_height");
 
   g_assert (list != NULL);
   rlist = (GtkList*) list;
 
-  temp_list = rlist->children;
-  n_selected_items = 0;
-
-  while (temp_list)
+  /* A height of 0 means the height is taken from the
+   *  requisition of the list items.
+   */
+  if (rlist->fixed_row_height != height)
     {
-      list_item = temp_list->data;
-      temp_list = temp_list->next;
+      rlist->fixed_row_height = MAX (height, 0);
 
-      if (list_item->state.value == GTK_STATE_SELECTED)
-	n_selected_items += 1;
+      if (GTK_WIDGET_VISIBLE (list) && list->parent)
+	gtk_container_need_resize (list->parent, list);
     }
 
-  if (n_selected_items > 0)
-    {
-      selected_items = g_new (gint, n_selected_items);
+  g_function_leave ("gtk_list_set_row_height");
+}
 
-      index = 0;
-      lindex = 0;
-      temp_list = rlist->children;
+void
+gtk_list_refresh_rows (GtkWidget *list,
+		       gint       start,
+		       gint       end)
+{
+  GtkList *rlist;
+  GtkListItem *list_item;
+  GList *children;
 
-      while (temp_list)
-	{
-	  list_item = temp_list->data;
+  g_function_enter ("gtk_list_refresh_rows");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  if ((end < 0) || (end > rlist->nrows))
+    end = rlist->nrows;
+
+  /* The list items which show rows in the range forget
+   *  which row they show. The next layout then calls
+   *  "set_row" for them again.
+   */
+  children = rlist->children;
+  while (children)
+    {
+      list_item = children->data;
+      children = children->next;
+
+      if ((list_item->row >= start) && (list_item->row < end))
+	list_item->row = -1;
+    }
+
+  gtk_list_virtual_layout (rlist, FALSE);
+
+  g_function_leave ("gtk_list_refresh_rows");
+}
+
+gint
+gtk_list_item_get_row (GtkWidget *item)
+{
+  gint row;
+
+  g_function_enter ("gtk_list_item_get_row");
+
+  g_assert (item != NULL);
+  row = ((GtkListItem*) item)->row;
+
+  g_function_leave ("gtk_list_item_get_row");
+  return row;
+}
+
+void
+gtk_list_select_item (GtkWidget *list,
+		      gint     item)
+{
+  GtkList *rlist;
+  GtkListItem *list_item;
+  GList *temp_list;
+
+  g_function_enter ("gtk_list_select_item");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  if (rlist->is_virtual)
+    {
+      g_assert ((item >= 0) && (item < rlist->nrows));
+      gtk_list_virtual_select (rlist, item, FALSE);
+
+      g_function_leave ("gtk_list_select_item");
+      return;
+    }
+
+  temp_list = g_list_nth (rlist->children, item);
+  g_assert (temp_list != NULL);
+
+  list_item = temp_list->data;
+  g_assert (list_item != NULL);
+
+  gtk_list_select_child (rlist, list_item, FALSE);
+
+  g_function_leave ("gtk_list_select_item");
+}
+
+void
+gtk_list_unselect_item (GtkWidget *list,
+			gint     item)
+{
+  GtkList *rlist;
+  GtkListItem *list_item;
+  GList *temp_list;
+
+  g_function_enter ("gtk_list_unselect_item");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  if (rlist->is_virtual)
+    {
+      g_assert ((item >= 0) && (item < rlist->nrows));
+      gtk_list_virtual_unselect (rlist, item);
+
+      g_function_leave ("gtk_list_unselect_item");
+      return;
+    }
+
+  temp_list = g_list_nth (rlist->children, item);
+  g_assert (temp_list != NULL);
+
+  list_item = temp_list->data;
+  g_assert (list_item != NULL);
+
+  gtk_list_unselect_child (rlist, list_item);
+
+  g_function_leave ("gtk_list_unselect_item");
+}
+
+gint*
+gtk_list_get_selected (GtkWidget *list,
+		       gint      *nitems)
+{
+  GtkList *rlist;
+  GtkListItem *list_item;
+  GList *temp_list;
+  gint *selected_items;
+  gint n_selected_items;
+  gint index, lindex;
+
+  g_function_enter ("gtk_list_get_selected");
+
+  g_assert (list != NULL);
+  rlist = (GtkList*) list;
+
+  if (rlist->is_virtual)
+    {
+      n_selected_items = rlist->nselected;
+
+      selected_items = NULL;
+      if (n_selected_items > 0)
+	{
+	  selected_items = g_new (gint, n_selected_items);
+
+	  index = 0;
+	  for (lindex = 0; lindex < rlist->nrows; lindex++)
+	    {
+	      if (rlist->selected_bits[lindex / 32] == 0)
+		{
+		  lindex |= 31;
+		  continue;
+		}
+
+	      if (gtk_list_virtual_get_state (rlist, lindex) == GTK_STATE_SELECTED)
+		selected_items[index++] = lindex;
+	    }
+	}
+
+      if (nitems)
+	*nitems = n_selected_items;
+
+      g_function_leave ("gtk_list_get_selected");
+      return selected_items;
+    }
+
+  temp_list = rlist->children;
+  n_selected_items = 0;
+
+  while (temp_list)
+    {
+      list_item = temp_list->data;
+      temp_list = temp_list->next;
+
+      if (list_item->state.value == GTK_STATE_SELECTED)
+	n_selected_items += 1;
+    }
+
+  if (n_selected_items > 0)
+    {
+      selected_items = g_new (gint, n_selected_items);
+
+      index = 0;
+      lindex = 0;
+      temp_list = rlist->children;
+
+      while (temp_list)
+	{
+	  list_item = temp_list->data;
 	  temp_list = temp_list->next;
 
 	  if (list_item->state.value == GTK_STATE_SELECTED)
@@ -821,6 +1390,11 @@ gtk_list_destroy (GtkWidget *widget)
     }
 
   g_list_free (list->children);
+  g_free (list->selected_bits);
+  g_free (list->changed_ranges);
+  g_free (list->row_index);
+  g_free (list->row_heights);
+  g_free (list->rows);
   gtk_data_detach ((GtkData*) list->hadjustment, &list->adjustment_observer);
   gtk_data_detach ((GtkData*) list->vadjustment, &list->adjustment_observer);
   gtk_data_destroy ((GtkData*) list->hadjustment);
@@ -857,6 +1431,12 @@ gtk_list_map (GtkWidget *widget)
       child = children->data;
       children = children->next;
 
+      /* Pooled items of a virtual list which don't currently
+       *  show a row are left unmapped.
+       */
+      if (list->is_virtual && (((GtkListItem*) child)->row < 0))
+	continue;
+
       if (GTK_WIDGET_VISIBLE (child) && !GTK_WIDGET_MAPPED (child))
 	gtk_widget_map (child);
     }
@@ -913,12 +1493,25 @@ gtk_list_realize (GtkWidget *widget)
   gdk_window_set_background (list->view_window,
 			     &list->container.widget.style->background[GTK_STATE_NORMAL]);
 
-  /* Create the list window.
+  /* Create the list window. The list window of a virtual list
+   *  is only as tall as the view. Its rows are positioned
+   *  within it instead.
    */
   attributes.x = -list->hadjustment->value;
-  attributes.y = -list->vadjustment->value;
   attributes.width = MAX (list->list_width, widget->allocation.width);
-  attributes.height = list->list_height;
+  attributes.event_mask = (GDK_EXPOSURE_MASK |
+			   GDK_BUTTON_PRESS_MASK |
+			   GDK_BUTTON_RELEASE_MASK);
+  if (list->is_virtual)
+    {
+      attributes.y = 0;
+      attributes.height = widget->allocation.height;
+    }
+  else
+    {
+      attributes.y = -list->vadjustment->value;
+      attributes.height = list->list_height;
+    }
   list->container.widget.window = gdk_window_new (list->view_window,
 						  &attributes, GDK_WA_X | GDK_WA_Y);
   gdk_window_set_user_data (list->container.widget.window, list);
@@ -1000,12 +1593,12 @@ gtk_list_event (GtkWidget *widget,
       break;
 
     case GDK_MOTION_NOTIFY:
-      gdk_window_get_pointer (widget->window, &x, &y, &mods);
+      gdk_event_get_pointer (event, widget->window, &x, &y, &mods);
       if (mods & GDK_BUTTON1_MASK)
 	{
 	  gtk_list_select_update (list, y);
 
-	  gdk_window_get_pointer (list->view_window, &x, &y, NULL);
+	  gdk_event_get_pointer (event, list->view_window, &x, &y, NULL);
 
 	  if (y < 0)
 	    {
@@ -1042,13 +1635,28 @@ gtk_list_event (GtkWidget *widget,
 
     case GDK_BUTTON_PRESS:
       child = gtk_get_event_widget (event);
-      if (gtk_widget_is_child (widget, child))
+
+      /* A click on a windowless list item is reported for the
+       *  list window. Find the item from the position.
+       */
+      if ((child == widget) && (event->any.window == widget->window))
+	if (!gtk_widget_locate (widget, &child, event->button.x, event->button.y))
+	  child = NULL;
+
+      if (child && (child != widget) && gtk_widget_is_child (widget, child))
 	{
 	  while (!gtk_widget_is_immediate_child (widget, child))
 	    child = (GtkWidget*) child->parent;
 
 	  list_item = (GtkListItem*) child;
-	  gtk_list_select_child (list, list_item, event->button.state & GDK_CONTROL_MASK);
+	  if (list->is_virtual)
+	    {
+	      if (list_item->row >= 0)
+		gtk_list_virtual_select (list, list_item->row,
+					 event->button.state & GDK_CONTROL_MASK);
+	    }
+	  else
+	    gtk_list_select_child (list, list_item, event->button.state & GDK_CONTROL_MASK);
 	}
 
       if (list->mode == GTK_SELECTION_EXTENDED)
@@ -1090,6 +1698,7 @@ gtk_list_size_request (GtkWidget      *widget,
 		       GtkRequisition *requisition)
 {
   GtkList *list;
+  GtkListItem *list_item;
   GtkWidget *child;
   GList *children;
   gint nchildren;
@@ -1103,8 +1712,59 @@ gtk_list_size_request (GtkWidget      *widget,
   list->list_width = 0;
   list->list_height = 0;
 
-  if (GTK_WIDGET_VISIBLE (widget))
+  if (GTK_WIDGET_VISIBLE (widget) && list->is_virtual)
+    {
+      /* The rows of a virtual list all have the same height.
+       *  Unless it has been set explicitly it is taken from
+       *  the first list item. The width is the widest of
+       *  the rows in view.
+       */
+      if ((list->nrows > 0) && (list->npool == 0))
+	gtk_list_virtual_grow_pool (list, 1);
+
+      children = list->children;
+      if (children && (list->nrows > 0))
+	{
+	  list_item = children->data;
+	  if (list_item->row < 0)
+	    {
+	      list->in_layout = TRUE;
+	      list_item->row = 0;
+	      (* list->set_row) ((GtkWidget*) list_item, 0, list->row_data);
+	      list->in_layout = FALSE;
+	    }
+	}
+
+      list->row_height = list->fixed_row_height;
+      while (children)
+	{
+	  child = children->data;
+	  children = children->next;
+
+	  if (GTK_WIDGET_VISIBLE (child) && (((GtkListItem*) child)->row >= 0))
+	    {
+	      gtk_widget_size_request (child, &child->requisition);
+
+	      list->list_width = MAX (list->list_width, child->requisition.width);
+	      if (list->row_height <= 0)
+		list->row_height = child->requisition.height;
+	    }
+	}
+
+      list->row_height = MAX (list->row_height, 1);
+      list->list_height = list->nrows * list->row_height;
+
+      list->list_width += list->container.border_width * 2;
+      list->list_height += list->container.border_width * 2;
+
+      list->list_width = MAX (list->list_width, 1);
+      list->list_height = MAX (list->list_height, 1);
+    }
+  else if (GTK_WIDGET_VISIBLE (widget))
     {
+      if (!list->index_valid)
+	gtk_list_index_build (list);
+
       nchildren = 0;
       children = list->children;
 
@@ -1115,16 +1775,20 @@ gtk_list_size_request (GtkWidget      *widget,
 
 	  if (GTK_WIDGET_VISIBLE (child))
 	    {
-	      child->requisition.width = 0;
-	      child->requisition.height = 0;
-
 	      gtk_widget_size_request (child, &child->requisition);
 
 	      list->list_width = MAX (list->list_width, child->requisition.width);
-	      list->list_height += child->requisition.height;
+	      if (list->row_heights[nchildren] != child->requisition.height)
+		gtk_list_index_update (list, nchildren, child->requisition.height);
 	    }
+	  else if (list->row_heights[nchildren] != 0)
+	    gtk_list_index_update (list, nchildren, 0);
+
+	  nchildren += 1;
 	}
 
+      list->list_height = gtk_list_index_offset (list, list->nindexed);
+
       list->list_width += list->container.border_width * 2;
       list->list_height += list->container.border_width * 2;
 
@@ -1166,12 +1830,30 @@ gtk_list_size_allocate (GtkWidget     *widget,
       gdk_window_set_size (list->view_window,
 			   allocation->width,
 			   allocation->height);
-      gdk_window_set_size (widget->window,
-			   MAX (list->list_width, allocation->width),
-			   list->list_height);
+
+      if (list->is_virtual)
+	{
+	  gdk_window_move (widget->window, -list->hadjustment->value, 0);
+	  gdk_window_set_size (widget->window,
+			       MAX (list->list_width, allocation->width),
+			       allocation->height);
+	}
+      else
+	gdk_window_set_size (widget->window,
+			     MAX (list->list_width, allocation->width),
+			     list->list_height);
     }
 
-  if (list->children)
+  if (list->is_virtual)
+    {
+      /* Enough list items are needed to cover the view even
+       *  when the first row in view is only partially visible.
+       */
+      if ((list->nrows > 0) && (list->row_height > 0))
+	gtk_list_virtual_grow_pool (list, MIN (list->nrows, (allocation->height /
+							     list->row_height) + 2));
+    }
+  else if (list->children)
     {
       children = list->children;
 
@@ -1230,8 +1912,24 @@ gtk_list_size_allocate (GtkWidget     *widget,
       list->vadjustment->page_size = 0;
     }
 
-  gtk_data_notify ((GtkData*) list->hadjustment);
-  gtk_data_notify ((GtkData*) list->vadjustment);
+  if (list->is_virtual)
+    {
+      /* Position the rows once rather than once for each of
+       *  the adjustment notifications.
+       */
+      list->vadjustment->step_increment = list->row_height;
+      gtk_list_virtual_layout (list, FALSE);
+
+      list->in_layout = TRUE;
+      gtk_data_notify ((GtkData*) list->hadjustment);
+      gtk_data_notify ((GtkData*) list->vadjustment);
+      list->in_layout = FALSE;
+    }
+  else
+    {
+      gtk_data_notify ((GtkData*) list->hadjustment);
+      gtk_data_notify ((GtkData*) list->vadjustment);
+    }
 
   g_function_leave ("gtk_list_size_allocate");
 }
@@ -1298,6 +1996,7 @@ gtk_list_locate (GtkWidget  *widget,
   gint return_val;
   gint child_x;
   gint child_y;
+  gint row;
 
   g_function_enter ("gtk_list_locate");
 
@@ -1314,18 +2013,37 @@ gtk_list_locate (GtkWidget  *widget,
     {
       return_val = TRUE;
 
-      children = list->children;
+      if (!list->is_virtual && list->index_valid)
+	{
+	  row = gtk_list_index_find (list, y - list->container.border_width);
+	  if (row >= 0)
+	    {
+	      child_widget = list->rows[row];
 
-      while (children)
+	      child_x = x - child_widget->allocation.x;
+	      child_y = y - child_widget->allocation.y;
+
+	      gtk_widget_locate (child_widget, child, child_x, child_y);
+	    }
+	}
+      else
 	{
-	  child_widget = children->data;
-	  children = children->next;
+	  children = list->children;
+
+	  while (children)
+	    {
+	      child_widget = children->data;
+	      children = children->next;
+
+	      if (list->is_virtual && (((GtkListItem*) child_widget)->row < 0))
+		continue;
 
-	  child_x = x - child_widget->allocation.x;
-	  child_y = y - child_widget->allocation.y;
+	      child_x = x - child_widget->allocation.x;
+	      child_y = y - child_widget->allocation.y;
 
-	  if (gtk_widget_locate (child_widget, child, child_x, child_y))
-	    break;
+	      if (gtk_widget_locate (child_widget, child, child_x, child_y))
+		break;
+	    }
 	}
 
       if (!(*child))
@@ -1348,13 +2066,19 @@ gtk_list_add (GtkContainer *container,
   g_assert (list != NULL);
   g_assert (widget != NULL);
 
-  list->children = g_list_append (list->children, widget);
+  if (list->is_virtual)
+    {
+      g_warning ("gtk_list_add: can't add items to a virtual list");
+      g_function_leave ("gtk_list_add");
+      return;
+    }
 
-  if ((list->mode == GTK_SELECTION_BROWSE) && !list->selection.list)
-    gtk_list_select_child (list, (GtkListItem*) widget, FALSE);
+  gtk_list_prepare_item (list, widget);
+  list->children = g_list_append (list->children, widget);
+  list->nchildren += 1;
+  list->index_valid = FALSE;
 
-  if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (container))
-    gtk_container_need_resize (container, widget);
+  gtk_list_children_changed (list, widget, FALSE);
 
   g_function_leave ("gtk_list_add");
 }
@@ -1372,6 +2096,8 @@ gtk_list_remove (GtkContainer *container,
   g_assert (widget != NULL);
 
   list->children = g_list_remove (list->children, widget);
+  list->nchildren = MAX (list->nchildren - 1, 0);
+  list->index_valid = FALSE;
 
   if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (container))
     gtk_container_need_resize (container, widget);
@@ -1460,7 +2186,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_SELECTED;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       else if (list_item->state.value == GTK_STATE_SELECTED)
 	{
@@ -1469,7 +2195,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_NORMAL;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       break;
 
@@ -1510,7 +2236,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_SELECTED;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       break;
 
@@ -1522,7 +2248,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_SELECTED;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       else if (list_item->state.value == GTK_STATE_SELECTED)
 	{
@@ -1531,7 +2257,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_NORMAL;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       break;
 
@@ -1573,7 +2299,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_NORMAL;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       else if (list_item->state.value == GTK_STATE_NORMAL)
 	{
@@ -1582,7 +2308,7 @@ gtk_list_select_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_SELECTED;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       break;
     }
@@ -1594,6 +2320,14 @@ static void
 gtk_list_select_update (GtkList *list,
 			gint     new_end_pos)
 {
+  gint start_row;
+  gint old_end_row;
+  gint new_end_row;
+  gint first, last;
+  gint in_band;
+  gint changed;
+  gint row;
+
   g_function_enter ("gtk_list_select_update");
 
   g_assert (list != NULL);
@@ -1603,11 +2337,87 @@ gtk_list_select_update (GtkList *list,
   else if (new_end_pos > list->list_height)
     new_end_pos = list->list_height;
 
+  /* Dragging in an extended selection selects the rows between
+   *  where the button was pressed and the pointer. Only the rows
+   *  which enter or leave that band are looked at.
+   */
+  if (list->have_grab && (list->mode == GTK_SELECTION_EXTENDED) &&
+      !list->is_virtual && list->index_valid && (list->nindexed > 0))
+    {
+      start_row = gtk_list_index_row (list, list->select_start_pos);
+      old_end_row = gtk_list_index_row (list, list->select_end_pos);
+      new_end_row = gtk_list_index_row (list, new_end_pos);
+
+      first = MIN (MIN (start_row, old_end_row), new_end_row);
+      last = MAX (MAX (start_row, old_end_row), new_end_row);
+      changed = FALSE;
+
+      for (row = first; row <= last; row++)
+	{
+	  /* Hidden list items take up no space and can't be
+	   *  dragged over.
+	   */
+	  if (list->row_heights[row] == 0)
+	    continue;
+
+	  in_band = (((row >= start_row) && (row <= new_end_row)) ||
+		     ((row <= start_row) && (row >= new_end_row)));
+
+	  if (gtk_list_set_item_selected (list, (GtkListItem*) list->rows[row], in_band))
+	    {
+	      gtk_list_selection_changed (list, row, row + 1);
+	      changed = TRUE;
+	    }
+	}
+
+      if (changed)
+	{
+	  gtk_list_prune_selection (list);
+	  gtk_list_selection_notify (list);
+	}
+    }
+
   list->select_end_pos = new_end_pos;
 
   g_function_leave ("gtk_list_select_update");
 }
 
+static gint
+gtk_list_set_item_selected (GtkList     *list,
+			    GtkListItem *list_item,
+			    gint         selected)
+{
+  gint return_val;
+
+  g_function_enter ("gtk_list_set_item_selected");
+
+  g_assert (list != NULL);
+  g_assert (list_item != NULL);
+
+  return_val = FALSE;
+
+  if (selected && (list_item->state.value == GTK_STATE_NORMAL))
+    {
+      list->selection.list = g_list_prepend (list->selection.list, list_item);
+
+      list_item->state.value = GTK_STATE_SELECTED;
+      gtk_data_notify ((GtkData*) &list_item->state);
+      return_val = TRUE;
+    }
+  else if (!selected && (list_item->state.value == GTK_STATE_SELECTED))
+    {
+      /* The caller takes it out of the selection with
+       *  gtk_list_prune_selection.
+       */
+      list_item->state.value = GTK_STATE_NORMAL;
+      gtk_data_notify ((GtkData*) &list_item->state);
+      return_val = TRUE;
+    }
+
+  g_function_leave ("gtk_list_set_item_selected");
+  return return_val;
+}
+
 static void
 gtk_list_unselect_child (GtkList     *list,
 			 GtkListItem *list_item)
@@ -1632,7 +2442,7 @@ gtk_list_unselect_child (GtkList     *list,
 	  list_item->state.value = GTK_STATE_NORMAL;
 	  gtk_data_notify ((GtkData*) &list_item->state);
 
-	  gtk_data_notify ((GtkData*) &list->selection);
+	  gtk_list_selection_notify_all (list);
 	}
       break;
 
@@ -1699,21 +2509,1009 @@ gtk_list_unselect_all (GtkList *list)
 
       g_list_free (list->selection.list);
       list->selection.list = NULL;
-      gtk_data_notify ((GtkData*) &list->selection);
+      gtk_list_selection_notify_all (list);
     }
 
   g_function_leave ("gtk_list_unselect_all");
 }
 
 static void
-gtk_list_add_timer (GtkList *list)
+gtk_list_change_range (GtkList        *list,
+		       gint            start,
+		       gint            end,
+		       GtkListRangeOp  op)
 {
-  g_function_enter ("gtk_list_add_timer");
+  GtkListItem *list_item;
+  gint changed;
+  gint nrows;
+  gint row;
+
+  g_function_enter ("gtk_list_change_range");
 
   g_assert (list != NULL);
 
-  if (!list->timer)
-    list->timer = gtk_timeout_add (LIST_TIMER_LENGTH, gtk_list_timer, (gpointer) list);
+  if ((op != GTK_LIST_RANGE_UNSELECT) &&
+      ((list->mode == GTK_SELECTION_SINGLE) || (list->mode == GTK_SELECTION_BROWSE)))
+    {
+      g_warning ("gtk_list_change_range: range selection needs a multiple or extended selection mode");
+      g_function_leave ("gtk_list_change_range");
+      return;
+    }
+
+  if (!list->is_virtual && !list->index_valid)
+    gtk_list_index_build (list);
+
+  nrows = list->is_virtual ? list->nrows : list->nindexed;
+  if ((end < 0) || (end > nrows))
+    end = nrows;
+  start = MAX (start, 0);
+
+  if (list->is_virtual)
+    {
+      changed = gtk_list_virtual_change_range (list, start, end, op);
+      if (changed)
+	gtk_list_virtual_sync_states (list);
+    }
+  else
+    {
+      changed = FALSE;
+      for (row = start; row < end; row++)
+	{
+	  list_item = (GtkListItem*) list->rows[row];
+
+	  if (gtk_list_set_item_selected (list, list_item,
+					  (op == GTK_LIST_RANGE_SELECT) ||
+					  ((op == GTK_LIST_RANGE_INVERT) &&
+					   (list_item->state.value != GTK_STATE_SELECTED))))
+	    {
+	      gtk_list_selection_changed (list, row, row + 1);
+	      changed = TRUE;
+	    }
+	}
+
+      if (changed)
+	gtk_list_prune_selection (list);
+    }
+
+  if (changed)
+    {
+      if (list->update_depth > 0)
+	list->selection_pending = TRUE;
+      else
+	gtk_list_selection_notify (list);
+    }
+
+  g_function_leave ("gtk_list_change_range");
+}
+
+/* Records that the selection of rows "start" to "end" changed.
+ *  The range is merged with the recorded ranges it overlaps or
+ *  touches. Rows mostly change in order, so the common case is
+ *  extending or appending to the last range.
+ */
+static void
+gtk_list_selection_changed (GtkList *list,
+			    gint     start,
+			    gint     end)
+{
+  gint *ranges;
+  gint first, last;
+  gint low, high, mid;
+
+  g_function_enter ("gtk_list_selection_changed");
+
+  if (list->changes_unknown || (start >= end))
+    {
+      g_function_leave ("gtk_list_selection_changed");
+      return;
+    }
+
+  ranges = list->changed_ranges;
+
+  /* Find the first range which ends at or after "start".
+   */
+  low = 0;
+  high = list->nchanged_ranges;
+  if ((high > 0) && (ranges[high * 2 - 1] < start))
+    low = high;
+  while (low < high)
+    {
+      mid = (low + high) / 2;
+      if (ranges[mid * 2 + 1] < start)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+  first = low;
+
+  /* Take in the ranges which start at or before "end".
+   */
+  for (last = first; (last < list->nchanged_ranges) && (ranges[last * 2] <= end); last++)
+    {
+      start = MIN (start, ranges[last * 2]);
+      end = MAX (end, ranges[last * 2 + 1]);
+    }
+
+  if (first == last)
+    {
+      if (list->nchanged_ranges == list->changed_ranges_size)
+	{
+	  list->changed_ranges_size = MAX (list->changed_ranges_size * 2, 8);
+	  list->changed_ranges = g_realloc (list->changed_ranges,
+					    sizeof (gint) * list->changed_ranges_size * 2);
+	  ranges = list->changed_ranges;
+	}
+
+      memmove (&ranges[(first + 1) * 2], &ranges[first * 2],
+	       sizeof (gint) * (list->nchanged_ranges - first) * 2);
+      list->nchanged_ranges += 1;
+    }
+  else if (last > first + 1)
+    {
+      memmove (&ranges[(first + 1) * 2], &ranges[last * 2],
+	       sizeof (gint) * (list->nchanged_ranges - last) * 2);
+      list->nchanged_ranges -= last - first - 1;
+    }
+
+  ranges[first * 2] = start;
+  ranges[first * 2 + 1] = end;
+
+  g_function_leave ("gtk_list_selection_changed");
+}
+
+static void
+gtk_list_selection_notify (GtkList *list)
+{
+  g_function_enter ("gtk_list_selection_notify");
+
+  /* Observers can ask for the changed rows while they are
+   *  being notified. Afterwards the range starts over.
+   */
+  gtk_data_notify ((GtkData*) &list->selection);
+  list->nchanged_ranges = 0;
+  list->changes_unknown = FALSE;
+
+  g_function_leave ("gtk_list_selection_notify");
+}
+
+/* Drops the recorded changes to rows at or past "nrows", for when
+ *  a virtual list gets shorter.
+ */
+static void
+gtk_list_clip_selection_changes (GtkList *list,
+				 gint     nrows)
+{
+  g_function_enter ("gtk_list_clip_selection_changes");
+
+  while ((list->nchanged_ranges > 0) &&
+	 (list->changed_ranges[list->nchanged_ranges * 2 - 2] >= nrows))
+    list->nchanged_ranges -= 1;
+
+  if (list->nchanged_ranges > 0)
+    list->changed_ranges[list->nchanged_ranges * 2 - 1] =
+      MIN (list->changed_ranges[list->nchanged_ranges * 2 - 1], nrows);
+
+  g_function_leave ("gtk_list_clip_selection_changes");
+}
+
+/* Notifies a change to the selection whose rows weren't recorded.
+ */
+static void
+gtk_list_selection_notify_all (GtkList *list)
+{
+  g_function_enter ("gtk_list_selection_notify_all");
+
+  list->changes_unknown = TRUE;
+  gtk_list_selection_notify (list);
+
+  g_function_leave ("gtk_list_selection_notify_all");
+}
+
+/* Takes the list items which are no longer selected out of the
+ *  selection. Range changes leave unselected list items in place
+ *  and prune them in one pass, rather than searching the
+ *  selection for each of them.
+ */
+static void
+gtk_list_prune_selection (GtkList *list)
+{
+  GList *temp_list;
+  GList *link;
+
+  g_function_enter ("gtk_list_prune_selection");
+
+  g_assert (list != NULL);
+
+  temp_list = list->selection.list;
+  while (temp_list)
+    {
+      link = temp_list;
+      temp_list = temp_list->next;
+
+      if (((GtkListItem*) link->data)->state.value != GTK_STATE_SELECTED)
+	{
+	  list->selection.list = g_list_remove_link (list->selection.list, link);
+	  g_list_free (link);
+	}
+    }
+
+  g_function_leave ("gtk_list_prune_selection");
+}
+
+static gint
+gtk_list_remove_marked_selection (GtkList *list)
+{
+  GList *temp_list;
+  GList *link;
+  gint return_val;
+
+  g_function_enter ("gtk_list_remove_marked_selection");
+
+  g_assert (list != NULL);
+
+  return_val = FALSE;
+
+  temp_list = list->selection.list;
+  while (temp_list)
+    {
+      link = temp_list;
+      temp_list = temp_list->next;
+
+      if (((GtkListItem*) link->data)->removing)
+	{
+	  list->selection.list = g_list_remove_link (list->selection.list, link);
+	  g_list_free (link);
+	  return_val = TRUE;
+	}
+    }
+
+  g_function_leave ("gtk_list_remove_marked_selection");
+  return return_val;
+}
+
+static void
+gtk_list_children_changed (GtkList   *list,
+			   GtkWidget *widget,
+			   gint       selection_changed)
+{
+  g_function_enter ("gtk_list_children_changed");
+
+  g_assert (list != NULL);
+
+  if (list->update_depth > 0)
+    {
+      list->resize_pending = TRUE;
+      if (selection_changed)
+	{
+	  list->selection_pending = TRUE;
+	  list->changes_unknown = TRUE;
+	}
+    }
+  else
+    {
+      if ((list->mode == GTK_SELECTION_BROWSE) &&
+	  !list->selection.list && widget)
+	gtk_list_select_child (list, (GtkListItem*) widget, FALSE);
+      else if (selection_changed)
+	gtk_list_selection_notify_all (list);
+
+      if (widget && GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_VISIBLE (list))
+	gtk_container_need_resize ((GtkContainer*) list, widget);
+    }
+
+  g_function_leave ("gtk_list_children_changed");
+}
+
+static void
+gtk_list_prepare_item (GtkList   *list,
+		       GtkWidget *widget)
+{
+  g_function_enter ("gtk_list_prepare_item");
+
+  /* List items have windows of their own unless the list says
+   *  otherwise, so the flag can be cleared again as well as set.
+   */
+  if (!GTK_WIDGET_REALIZED (widget))
+    {
+      if (list->windowless_items)
+	GTK_WIDGET_SET_FLAGS (widget, GTK_NO_WINDOW);
+      else
+	GTK_WIDGET_UNSET_FLAGS (widget, GTK_NO_WINDOW);
+    }
+
+  g_function_leave ("gtk_list_prepare_item");
+}
+
+static void
+gtk_list_index_build (GtkList *list)
+{
+  GtkWidget *child;
+  GList *children;
+  gint i, j;
+
+  g_function_enter ("gtk_list_index_build");
+
+  g_assert (list != NULL);
+
+  list->nchildren = g_list_length (list->children);
+  if (list->index_size < list->nchildren)
+    {
+      list->index_size = MAX (list->nchildren, list->index_size * 2);
+      list->row_index = g_realloc (list->row_index, sizeof (gint) * (list->index_size + 1));
+      list->row_heights = g_realloc (list->row_heights, sizeof (gint) * list->index_size);
+      list->rows = g_realloc (list->rows, sizeof (GtkWidget*) * list->index_size);
+    }
+
+  /* The tree is 1-based: row_index[i] holds the sum of the
+   *  heights of rows (i - (i & -i), i]. Building it from the
+   *  leaves up is linear.
+   */
+  i = 0;
+  children = list->children;
+  while (children)
+    {
+      child = children->data;
+      children = children->next;
+
+      list->rows[i] = child;
+      list->row_heights[i] = GTK_WIDGET_VISIBLE (child) ? child->requisition.height : 0;
+      list->row_index[i + 1] = list->row_heights[i];
+      i += 1;
+    }
+
+  list->nindexed = i;
+  for (i = 1; i <= list->nindexed; i++)
+    {
+      j = i + (i & -i);
+      if (j <= list->nindexed)
+	list->row_index[j] += list->row_index[i];
+    }
+
+  list->index_valid = TRUE;
+
+  g_function_leave ("gtk_list_index_build");
+}
+
+static void
+gtk_list_index_update (GtkList *list,
+		       gint     row,
+		       gint     height)
+{
+  gint delta;
+  gint i;
+
+  g_function_enter ("gtk_list_index_update");
+
+  g_assert (list != NULL);
+  g_assert ((row >= 0) && (row < list->nindexed));
+
+  delta = height - list->row_heights[row];
+  list->row_heights[row] = height;
+
+  for (i = row + 1; i <= list->nindexed; i += i & -i)
+    list->row_index[i] += delta;
+
+  g_function_leave ("gtk_list_index_update");
+}
+
+static gint
+gtk_list_index_offset (GtkList *list,
+		       gint     row)
+{
+  gint offset;
+  gint i;
+
+  g_function_enter ("gtk_list_index_offset");
+
+  g_assert (list != NULL);
+
+  /* The offset of a row is the sum of the heights of the
+   *  rows before it.
+   */
+  offset = 0;
+  for (i = MIN (row, list->nindexed); i > 0; i -= i & -i)
+    offset += list->row_index[i];
+
+  g_function_leave ("gtk_list_index_offset");
+  return offset;
+}
+
+/* Returns the row at "pos" in the list window. Positions in the
+ *  border above the first row give the first row and positions
+ *  past the end give the last row.
+ */
+static gint
+gtk_list_index_row (GtkList *list,
+		    gint     pos)
+{
+  gint row;
+
+  g_function_enter ("gtk_list_index_row");
+
+  g_assert (list != NULL);
+
+  row = gtk_list_index_find (list, MAX (pos - list->container.border_width, 0));
+  if (row < 0)
+    row = list->nindexed - 1;
+
+  g_function_leave ("gtk_list_index_row");
+  return row;
+}
+
+static gint
+gtk_list_index_find (GtkList *list,
+		     gint     offset)
+{
+  gint row;
+  gint mask;
+
+  g_function_enter ("gtk_list_index_find");
+
+  g_assert (list != NULL);
+
+  if (offset < 0)
+    {
+      g_function_leave ("gtk_list_index_find");
+      return -1;
+    }
+
+  /* Descend the tree to find the number of rows which end at
+   *  or before "offset". That is the row "offset" falls in.
+   */
+  for (mask = 1; (mask << 1) <= list->nindexed; mask <<= 1)
+    ;
+
+  row = 0;
+  for (; mask > 0; mask >>= 1)
+    if (((row + mask) <= list->nindexed) && (list->row_index[row + mask] <= offset))
+      {
+	row += mask;
+	offset -= list->row_index[row];
+      }
+
+  if (row >= list->nindexed)
+    row = -1;
+
+  g_function_leave ("gtk_list_index_find");
+  return row;
+}
+
+static void
+gtk_list_need_resize (GtkContainer *container,
+		      GtkWidget    *widget)
+{
+  GtkList *list;
+
+  g_function_enter ("gtk_list_need_resize");
+
+  g_assert (container != NULL);
+  g_assert (widget != NULL);
+  list = (GtkList*) container;
+
+  /* While a virtual list is assigning rows to its list items
+   *  their contents change, but the list lays them out itself
+   *  afterwards. So the change isn't passed on to the parent.
+   */
+  if (list->in_layout)
+    {
+      if (GTK_WIDGET_VISIBLE (widget) &&
+	  GTK_WIDGET_REALIZED (container) &&
+	  !GTK_WIDGET_REALIZED (widget))
+	gtk_widget_realize (widget);
+    }
+  else
+    gtk_container_default_need_resize (container, widget);
+
+  g_function_leave ("gtk_list_need_resize");
+}
+
+static void
+gtk_list_virtual_grow_pool (GtkList *list,
+			    gint     npool)
+{
+  GtkWidget *widget;
+
+  g_function_enter ("gtk_list_virtual_grow_pool");
+
+  g_assert (list != NULL);
+
+  list->in_layout = TRUE;
+
+  while (list->npool < npool)
+    {
+      widget = (* list->create_row) (list->row_data);
+      g_assert (widget != NULL);
+
+      ((GtkListItem*) widget)->row = -1;
+      widget->parent = (GtkContainer*) list;
+      gtk_list_prepare_item (list, widget);
+      list->children = g_list_append (list->children, widget);
+      list->npool += 1;
+
+      if (!GTK_WIDGET_VISIBLE (widget))
+	gtk_widget_show (widget);
+      else if (GTK_WIDGET_REALIZED (list))
+	gtk_widget_realize (widget);
+    }
+
+  list->in_layout = FALSE;
+
+  g_function_leave ("gtk_list_virtual_grow_pool");
+}
+
+/* Returns how far the view of a virtual list is scrolled down,
+ *  kept within the list.
+ */
+static gint
+gtk_list_virtual_offset (GtkList *list)
+{
+  gfloat value;
+  gint view_height;
+
+  g_function_enter ("gtk_list_virtual_offset");
+
+  view_height = list->container.widget.allocation.height;
+
+  value = list->vadjustment->value;
+  if (value > (list->list_height - view_height))
+    value = list->list_height - view_height;
+  if (value < 0)
+    value = 0;
+
+  g_function_leave ("gtk_list_virtual_offset");
+  return (gint) value;
+}
+
+/* Gives the list items of the pool the rows in view. Each row
+ *  always goes to the same list item ("row" modulo "npool"), so
+ *  when the view scrolls only the rows coming into view need new
+ *  contents. If "scrolled" is TRUE the list window has already
+ *  been scrolled to match and only those rows, or rows whose
+ *  state changed, are drawn; windowless list items are left to
+ *  the caller, which redraws what the scroll uncovered.
+ */
+static void
+gtk_list_virtual_layout (GtkList *list,
+			 gint     scrolled)
+{
+  GtkWidget *widget;
+  GtkListItem *list_item;
+  GtkAllocation child_allocation;
+  GList *children;
+  GtkStateType state;
+  gint view_height;
+  gint offset;
+  gint top;
+  gint row;
+  gint redraw;
+  gint i;
+
+  g_function_enter ("gtk_list_virtual_layout");
+
+  g_assert (list != NULL);
+  widget = (GtkWidget*) list;
+
+  if (!list->is_virtual || (list->row_height <= 0) || (list->npool <= 0))
+    {
+      g_function_leave ("gtk_list_virtual_layout");
+      return;
+    }
+
+  view_height = widget->allocation.height;
+  offset = gtk_list_virtual_offset (list);
+
+  top = (offset - list->container.border_width) / list->row_height;
+  top = MAX (top, 0);
+
+  child_allocation.x = list->container.border_width;
+  child_allocation.width = MAX (list->list_width, widget->allocation.width);
+  child_allocation.width -= list->container.border_width * 2;
+  child_allocation.width = MAX (child_allocation.width, 1);
+  child_allocation.height = list->row_height;
+
+  list->in_layout = TRUE;
+
+  i = 0;
+  children = list->children;
+  while (children)
+    {
+      list_item = children->data;
+      children = children->next;
+
+      row = top + (((i - top) % list->npool) + list->npool) % list->npool;
+      child_allocation.y = (list->container.border_width +
+			    row * list->row_height - offset);
+      i += 1;
+
+      if ((row < list->nrows) && (child_allocation.y < view_height))
+	{
+	  redraw = !scrolled;
+
+	  if (list_item->row != row)
+	    {
+	      list_item->row = row;
+	      (* list->set_row) ((GtkWidget*) list_item, row, list->row_data);
+
+	      if (!GTK_WIDGET_NO_WINDOW (list_item))
+		redraw = TRUE;
+	    }
+
+	  state = gtk_list_virtual_get_state (list, row);
+	  if (list_item->state.value != state)
+	    {
+	      list_item->state.value = state;
+	      redraw = TRUE;
+	    }
+
+	  gtk_widget_size_allocate ((GtkWidget*) list_item, &child_allocation);
+
+	  if (GTK_WIDGET_MAPPED (list) &&
+	      GTK_WIDGET_VISIBLE (list_item) &&
+	      !GTK_WIDGET_MAPPED (list_item))
+	    {
+	      gtk_widget_map ((GtkWidget*) list_item);
+	      redraw = TRUE;
+	    }
+
+	  if (redraw)
+	    gtk_widget_draw ((GtkWidget*) list_item, NULL, FALSE);
+	}
+      else
+	{
+	  list_item->row = -1;
+	  if (GTK_WIDGET_MAPPED (list_item))
+	    gtk_widget_unmap ((GtkWidget*) list_item);
+	}
+    }
+
+  list->view_offset = offset;
+  list->in_layout = FALSE;
+
+  g_function_leave ("gtk_list_virtual_layout");
+}
+
+/* Follows the vertical adjustment. When the list items draw into
+ *  the list window the part of the view still in view is moved
+ *  with one copy and only the strip it uncovers is redrawn, so
+ *  scrolling costs the same however long the list is. List items
+ *  with windows of their own are moved by the server instead.
+ */
+static void
+gtk_list_virtual_scroll (GtkList *list)
+{
+  GtkWidget *widget;
+  GdkRegion *invalid;
+  GdkRectangle *area;
+  gint delta;
+  gint i;
+
+  g_function_enter ("gtk_list_virtual_scroll");
+
+  g_assert (list != NULL);
+  widget = (GtkWidget*) list;
+
+  delta = gtk_list_virtual_offset (list) - list->view_offset;
+
+  if (!GTK_WIDGET_MAPPED (list) || (delta == 0))
+    {
+      gtk_list_virtual_layout (list, FALSE);
+    }
+  else if (!list->windowless_items)
+    {
+      gtk_list_virtual_layout (list, TRUE);
+    }
+  else if (ABS (delta) < widget->allocation.height)
+    {
+      invalid = gdk_region_new ();
+      gdk_window_scroll (widget->window, 0, -delta, invalid);
+      gtk_scroll_queued_exposes (widget->window, 0, -delta, invalid);
+
+      gtk_list_virtual_layout (list, TRUE);
+
+      for (i = 0; i < invalid->nrects; i++)
+	{
+	  area = &invalid->rects[i];
+
+	  if (gtk_double_buffer)
+	    gdk_window_begin_paint (widget->window, area);
+	  gdk_window_clear_area (widget->window, area->x, area->y, area->width, area->height);
+	  gtk_widget_draw (widget, area, TRUE);
+	  if (gtk_double_buffer)
+	    gdk_window_end_paint (widget->window);
+	}
+
+      gdk_region_destroy (invalid);
+    }
+  else
+    {
+      gdk_window_clear (widget->window);
+      gtk_list_virtual_layout (list, FALSE);
+    }
+
+  g_function_leave ("gtk_list_virtual_scroll");
+}
+
+static void
+gtk_list_virtual_select (GtkList *list,
+			 gint     row,
+			 gint     toggle)
+{
+  gint changed;
+
+  g_function_enter ("gtk_list_virtual_select");
+
+  g_assert (list != NULL);
+  g_assert ((row >= 0) && (row < list->nrows));
+
+  /* This follows "gtk_list_select_child" but works on the row
+   *  states instead of on list items.
+   */
+  changed = FALSE;
+  switch (list->mode)
+    {
+    case GTK_SELECTION_SINGLE:
+      changed |= gtk_list_virtual_unselect_all (list, row);
+      if (gtk_list_virtual_get_state (list, row) == GTK_STATE_SELECTED)
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_NORMAL);
+      else
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_SELECTED);
+      break;
+
+    case GTK_SELECTION_BROWSE:
+      changed |= gtk_list_virtual_unselect_all (list, row);
+      changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_SELECTED);
+      break;
+
+    case GTK_SELECTION_MULTIPLE:
+      if (gtk_list_virtual_get_state (list, row) == GTK_STATE_SELECTED)
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_NORMAL);
+      else
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_SELECTED);
+      break;
+
+    case GTK_SELECTION_EXTENDED:
+      if (!toggle)
+	changed |= gtk_list_virtual_unselect_all (list, row);
+
+      if (toggle && (gtk_list_virtual_get_state (list, row) == GTK_STATE_SELECTED))
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_NORMAL);
+      else
+	changed |= gtk_list_virtual_set_state (list, row, GTK_STATE_SELECTED);
+      break;
+    }
+
+  if (changed)
+    {
+      gtk_list_virtual_sync_states (list);
+      gtk_list_selection_notify (list);
+    }
+
+  g_function_leave ("gtk_list_virtual_select");
+}
+
+static void
+gtk_list_virtual_unselect (GtkList *list,
+			   gint     row)
+{
+  gint changed;
+
+  g_function_enter ("gtk_list_virtual_unselect");
+
+  g_assert (list != NULL);
+  g_assert ((row >= 0) && (row < list->nrows));
+
+  changed = FALSE;
+  switch (list->mode)
+    {
+    case GTK_SELECTION_SINGLE:
+    case GTK_SELECTION_MULTIPLE:
+      changed = gtk_list_virtual_set_state (list, row, GTK_STATE_NORMAL);
+      break;
+
+    case GTK_SELECTION_BROWSE:
+      changed = gtk_list_virtual_unselect_all (list, row);
+      break;
+
+    case GTK_SELECTION_EXTENDED:
+      break;
+    }
+
+  if (changed)
+    {
+      gtk_list_virtual_sync_states (list);
+      gtk_list_selection_notify (list);
+    }
+
+  g_function_leave ("gtk_list_virtual_unselect");
+}
+
+static gint
+gtk_list_virtual_set_state (GtkList      *list,
+			    gint          row,
+			    GtkStateType  state)
+{
+  if (gtk_list_virtual_get_state (list, row) == state)
+    return FALSE;
+
+  if (state == GTK_STATE_SELECTED)
+    return gtk_list_virtual_change_range (list, row, row + 1, GTK_LIST_RANGE_SELECT);
+  else
+    return gtk_list_virtual_change_range (list, row, row + 1, GTK_LIST_RANGE_UNSELECT);
+}
+
+static gint
+gtk_list_virtual_get_state (GtkList *list,
+			    gint     row)
+{
+  if (list->selected_bits[row / 32] & ((guint32) 1 << (row % 32)))
+    return GTK_STATE_SELECTED;
+  return GTK_STATE_NORMAL;
+}
+
+static gint
+gtk_list_virtual_unselect_all (GtkList *list,
+			       gint     except_row)
+{
+  gint changed;
+  gint keep;
+
+  g_function_enter ("gtk_list_virtual_unselect_all");
+
+  keep = ((except_row >= 0) &&
+	  (gtk_list_virtual_get_state (list, except_row) == GTK_STATE_SELECTED));
+
+  changed = FALSE;
+  if (list->nselected > (keep ? 1 : 0))
+    {
+      if (keep)
+	{
+	  gtk_list_virtual_change_range (list, 0, except_row, GTK_LIST_RANGE_UNSELECT);
+	  gtk_list_virtual_change_range (list, except_row + 1, list->nrows, GTK_LIST_RANGE_UNSELECT);
+	}
+      else
+	gtk_list_virtual_change_range (list, 0, list->nrows, GTK_LIST_RANGE_UNSELECT);
+
+      changed = TRUE;
+    }
+
+  g_function_leave ("gtk_list_virtual_unselect_all");
+  return changed;
+}
+
+static gint
+gtk_list_virtual_change_range (GtkList        *list,
+			       gint            start,
+			       gint            end,
+			       GtkListRangeOp  op)
+{
+  guint32 mask;
+  guint32 word;
+  guint32 flipped;
+  gint changed;
+  gint bit, run_end;
+  gint i;
+
+  g_function_enter ("gtk_list_virtual_change_range");
+
+  g_assert (list != NULL);
+  g_assert ((start >= 0) && (end <= list->nrows));
+
+  if (start >= end)
+    {
+      g_function_leave ("gtk_list_virtual_change_range");
+      return FALSE;
+    }
+
+  /* Work a word of 32 rows at a time. Only the first and last
+   *  words can be partial. Each run of rows which really changed
+   *  is recorded, and runs running over into the next word are
+   *  joined by gtk_list_selection_changed. The masks are kept to
+   *  32 bits since a guint32 may be wider.
+   */
+  changed = FALSE;
+
+  for (i = start / 32; i <= (end - 1) / 32; i++)
+    {
+      mask = 0xffffffff;
+      if (i == start / 32)
+	mask &= ((guint32) 0xffffffff) << (start % 32);
+      if (i == (end - 1) / 32)
+	mask &= ((guint32) 0xffffffff) >> (31 - ((end - 1) % 32));
+
+      word = list->selected_bits[i];
+      switch (op)
+	{
+	case GTK_LIST_RANGE_SELECT:
+	  word |= mask;
+	  break;
+	case GTK_LIST_RANGE_UNSELECT:
+	  word &= ~mask;
+	  break;
+	case GTK_LIST_RANGE_INVERT:
+	  word ^= mask;
+	  break;
+	}
+
+      flipped = word ^ list->selected_bits[i];
+      if (flipped)
+	{
+	  list->selected_bits[i] = word;
+	  changed = TRUE;
+
+	  if (flipped == ((guint32) 0xffffffff))
+	    gtk_list_selection_changed (list, i * 32, i * 32 + 32);
+	  else
+	    {
+	      bit = 0;
+	      while (bit < 32)
+		{
+		  if (flipped & ((guint32) 1 << bit))
+		    {
+		      for (run_end = bit + 1; run_end < 32; run_end++)
+			if (!(flipped & ((guint32) 1 << run_end)))
+			  break;
+		      gtk_list_selection_changed (list, i * 32 + bit, i * 32 + run_end);
+		      bit = run_end;
+		    }
+		  else
+		    bit += 1;
+		}
+	    }
+
+	  /* count the rows which were selected and unselected */
+	  while (flipped)
+	    {
+	      if (word & flipped & -flipped)
+		list->nselected += 1;
+	      else
+		list->nselected -= 1;
+	      flipped &= flipped - 1;
+	    }
+	}
+    }
+
+  g_function_leave ("gtk_list_virtual_change_range");
+  return changed;
+}
+
+static void
+gtk_list_virtual_sync_states (GtkList *list)
+{
+  GtkListItem *list_item;
+  GList *children;
+
+  g_function_enter ("gtk_list_virtual_sync_states");
+
+  /* Only the list items in view need to show the new
+   *  states. The other rows get theirs when they are
+   *  scrolled into view.
+   */
+  children = list->children;
+  while (children)
+    {
+      list_item = children->data;
+      children = children->next;
+
+      if ((list_item->row >= 0) &&
+	  (list_item->state.value != gtk_list_virtual_get_state (list, list_item->row)))
+	{
+	  list_item->state.value = gtk_list_virtual_get_state (list, list_item->row);
+	  gtk_data_notify ((GtkData*) &list_item->state);
+	}
+    }
+
+  g_function_leave ("gtk_list_virtual_sync_states");
+}
+
+static void
+gtk_list_add_timer (GtkList *list)
+{
+  g_function_enter ("gtk_list_add_timer");
+
+  g_assert (list != NULL);
+
+  if (!list->timer)
+    list->timer = gtk_timeout_add (LIST_TIMER_LENGTH, gtk_list_timer, (gpointer) list);
 
   g_function_leave ("gtk_list_add_timer");
 }
@@ -1789,9 +3587,19 @@ gtk_list_adjustment_update (GtkObserver *observer,
   list = observer->user_data;
   g_assert (list != NULL);
 
-  gdk_window_move (list->container.widget.window,
-		   -list->hadjustment->value,
-		   -list->vadjustment->value);
+  if (list->is_virtual)
+    {
+      if (GTK_WIDGET_REALIZED (list))
+	gdk_window_move (list->container.widget.window,
+			 -list->hadjustment->value, 0);
+
+      if (!list->in_layout)
+	gtk_list_virtual_scroll (list);
+    }
+  else
+    gdk_window_move (list->container.widget.window,
+		     -list->hadjustment->value,
+		     -list->vadjustment->value);
 
   g_function_leave ("gtk_list_adjustment_update");
   return FALSE;
@@ -1823,7 +3631,7 @@ gtk_list_item_destroy (GtkWidget *widget)
   if (list_item->child)
     if (!gtk_widget_destroy (list_item->child))
       list_item->child->parent = NULL;
-  if (list_item->container.widget.window)
+  if (!GTK_WIDGET_NO_WINDOW (widget) && list_item->container.widget.window)
     gdk_window_destroy (list_item->container.widget.window);
   g_free (list_item);
 
@@ -1841,7 +3649,8 @@ gtk_list_item_map (GtkWidget *widget)
   g_assert (list_item != NULL);
 
   GTK_WIDGET_SET_FLAGS (widget, GTK_MAPPED);
-  gdk_window_show (widget->window);
+  if (!GTK_WIDGET_NO_WINDOW (widget))
+    gdk_window_show (widget->window);
 
   if (list_item->child &&
       GTK_WIDGET_VISIBLE (list_item->child) &&
@@ -1859,7 +3668,16 @@ gtk_list_item_unmap (GtkWidget *widget)
   g_assert (widget != NULL);
 
   GTK_WIDGET_UNSET_FLAGS (widget, GTK_MAPPED);
-  gdk_window_hide (widget->window);
+
+  /* A windowless item has to erase itself from the list
+   *  window.
+   */
+  if (!GTK_WIDGET_NO_WINDOW (widget))
+    gdk_window_hide (widget->window);
+  else if (GTK_WIDGET_REALIZED (widget))
+    gdk_window_clear_area (widget->window,
+			   widget->allocation.x, widget->allocation.y,
+			   widget->allocation.width, widget->allocation.height);
 
   g_function_leave ("gtk_list_item_unmap");
 }
@@ -1877,6 +3695,15 @@ gtk_list_item_realize (GtkWidget *widget)
 
   GTK_WIDGET_SET_FLAGS (widget, GTK_REALIZED);
 
+  if (GTK_WIDGET_NO_WINDOW (widget))
+    {
+      widget->window = widget->parent->widget.window;
+      widget->style = gtk_style_attach (widget->style, widget->window);
+
+      g_function_leave ("gtk_list_item_realize");
+      return;
+    }
+
   attributes.window_type = GDK_WINDOW_CHILD;
   attributes.x = widget->allocation.x;
   attributes.y = widget->allocation.y;
@@ -1919,9 +3746,20 @@ gtk_list_item_draw (GtkWidget    *widget,
 
   if (GTK_WIDGET_VISIBLE (widget) && GTK_WIDGET_MAPPED (widget))
     {
-      gdk_window_set_background (widget->window,
-				 &widget->style->background[list_item->state.value]);
-      gdk_window_clear (widget->window);
+      if (GTK_WIDGET_NO_WINDOW (widget))
+	{
+	  gdk_draw_rectangle (widget->window,
+			      widget->style->background_gc[list_item->state.value],
+			      TRUE,
+			      widget->allocation.x, widget->allocation.y,
+			      widget->allocation.width, widget->allocation.height);
+	}
+      else
+	{
+	  gdk_window_set_background (widget->window,
+				     &widget->style->background[list_item->state.value]);
+	  gdk_window_clear (widget->window);
+	}
 
       if (list_item->child)
 	{
@@ -1978,9 +3816,6 @@ gtk_list_item_size_request (GtkWidget      *widget,
 
   if (GTK_WIDGET_VISIBLE (widget) && list_item->child)
     {
-      list_item->child->requisition.width = 0;
-      list_item->child->requisition.height = 0;
-
       gtk_widget_size_request (list_item->child, &list_item->child->requisition);
 
       requisition->width = (list_item->child->requisition.width +
@@ -2014,7 +3849,7 @@ gtk_list_item_size_allocate (GtkWidget     *widget,
   g_assert (allocation != NULL);
 
   widget->allocation = *allocation;
-  if (GTK_WIDGET_REALIZED (widget))
+  if (GTK_WIDGET_REALIZED (widget) && !GTK_WIDGET_NO_WINDOW (widget))
     {
       gdk_window_move (widget->window,
                        allocation->x,
@@ -2032,6 +3867,12 @@ gtk_list_item_size_allocate (GtkWidget     *widget,
       child_allocation.width = allocation->width - child_allocation.x * 2;
       child_allocation.height = allocation->height - child_allocation.y * 2;
 
+      if (GTK_WIDGET_NO_WINDOW (widget))
+	{
+	  child_allocation.x += allocation->x;
+	  child_allocation.y += allocation->y;
+	}
+
       if (child_allocation.width <= 0)
 	child_allocation.width = 1;
       if (child_allocation.height <= 0)
@@ -2097,6 +3938,12 @@ gtk_list_item_locate (GtkWidget  *widget,
 	  child_x = x - list_item->child->allocation.x;
 	  child_y = y - list_item->child->allocation.y;
 
+	  if (GTK_WIDGET_NO_WINDOW (widget))
+	    {
+	      child_x += widget->allocation.x;
+	      child_y += widget->allocation.y;
+	    }
+
 	  gtk_widget_locate (list_item->child, child, child_x, child_y);
 	}
 
@@ -21,6 +21,16 @@ typedef enum
   GTK_SELECTION_EXTENDED
 } GtkSelectionMode;
 
+/* Virtual lists don't have a list item for every row. Instead
+ *  "create_row" is used to create a small number of list items
+ *  and "set_row" is called to make one of those display a given
+ *  row when it scrolls into view.
+ */
+typedef GtkWidget* (*GtkListCreateRowFunc) (gpointer   data);
+typedef void       (*GtkListSetRowFunc)    (GtkWidget *list_item,
+					    gint       row,
+					    gpointer   data);
+
 
 /* Lists
  */
@@ -44,6 +54,15 @@ void  gtk_list_clear_items        (GtkWidget        *list,
 				   gint              end);
 void  gtk_list_set_selection_mode (GtkWidget        *list,
 				   GtkSelectionMode  mode);
+void  gtk_list_set_windowless_items (GtkWidget      *list,
+				     gint            windowless);
+
+/* Batch changes to a list. Between begin and end the list's
+ *  children can be inserted and removed freely, and the list
+ *  is resized and its selection notified only once at the end.
+ */
+void  gtk_list_begin_update       (GtkWidget        *list);
+void  gtk_list_end_update         (GtkWidget        *list);
 void  gtk_list_get_list_size      (GtkWidget        *list,
 				   gint             *width,
 				   gint             *height);
@@ -51,6 +70,19 @@ GtkData* gtk_list_get_hadjustment (GtkWidget        *list);
 GtkData* gtk_list_get_vadjustment (GtkWidget        *list);
 GtkData* gtk_list_item_get_state  (GtkWidget        *item);
 
+void  gtk_list_set_virtual        (GtkWidget            *list,
+				   GtkListCreateRowFunc  create_row,
+				   GtkListSetRowFunc     set_row,
+				   gpointer              data);
+void  gtk_list_set_row_count      (GtkWidget            *list,
+				   gint                  nrows);
+void  gtk_list_set_row_height     (GtkWidget            *list,
+				   gint                  height);
+void  gtk_list_refresh_rows       (GtkWidget            *list,
+				   gint                  start,
+				   gint                  end);
+gint  gtk_list_item_get_row       (GtkWidget            *item);
+
 void   gtk_list_select_item   (GtkWidget   *list,
 			       gint         item);
 void   gtk_list_unselect_item (GtkWidget   *list,
@@ -58,6 +90,29 @@ void   gtk_list_unselect_item (GtkWidget   *list,
 gint*  gtk_list_get_selected  (GtkWidget   *list,
 			       gint        *nitems);
 
+/* Range selection works on rows, the positions of the list items
+ *  or the rows of a virtual list. "end" is exclusive and -1 means
+ *  the last row. A whole range is notified once, and while the
+ *  selection is notified gtk_list_get_selection_changes returns
+ *  the number of ranges of rows which changed and points "ranges"
+ *  at their start and (exclusive) end rows. Changes which aren't
+ *  recorded by row, such as clicks on an ordinary list or adding
+ *  and removing list items, report one range over the whole list.
+ */
+void   gtk_list_select_range          (GtkWidget *list,
+				       gint       start,
+				       gint       end);
+void   gtk_list_unselect_range        (GtkWidget *list,
+				       gint       start,
+				       gint       end);
+void   gtk_list_invert_range          (GtkWidget *list,
+				       gint       start,
+				       gint       end);
+gint   gtk_list_row_is_selected       (GtkWidget *list,
+				       gint       row);
+gint   gtk_list_get_selection_changes (GtkWidget  *list,
+				       gint      **ranges);
+
 guint16 gtk_get_list_type      (void);
 guint16 gtk_get_list_item_type (void);
 
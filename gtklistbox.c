@@ -384,17 +384,11 @@ gtk_listbox_size_request (GtkWidget      *widget,
 
   if (GTK_WIDGET_VISIBLE (widget))
     {
-      listbox->frame->requisition.width = 0;
-      listbox->frame->requisition.height = 0;
-
       gtk_widget_size_request (listbox->frame, &listbox->frame->requisition);
 
       requisition->width = listbox->frame->requisition.width;
       requisition->height = listbox->frame->requisition.height;
 
-      listbox->hscrollbar->requisition.width = 0;
-      listbox->hscrollbar->requisition.height = 0;
-
       if (GTK_WIDGET_VISIBLE (listbox->hscrollbar))
 	{
 	  gtk_widget_size_request (listbox->hscrollbar,
@@ -402,9 +396,11 @@ gtk_listbox_size_request (GtkWidget      *widget,
 
 	  requisition->height += listbox->hscrollbar->requisition.height + 5;
 	}
-
-      listbox->vscrollbar->requisition.width = 0;
-      listbox->vscrollbar->requisition.height = 0;
+      else
+	{
+	  listbox->hscrollbar->requisition.width = 0;
+	  listbox->hscrollbar->requisition.height = 0;
+	}
 
       if (GTK_WIDGET_VISIBLE (listbox->vscrollbar))
 	{
@@ -413,6 +409,11 @@ gtk_listbox_size_request (GtkWidget      *widget,
 
 	  requisition->width += listbox->hscrollbar->requisition.width + 5;
 	}
+      else
+	{
+	  listbox->vscrollbar->requisition.width = 0;
+	  listbox->vscrollbar->requisition.height = 0;
+	}
     }
   else
     {
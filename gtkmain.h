@@ -27,8 +27,11 @@ gint gtk_timeout_add    (guint32     interval,
 			 gpointer    data);
 void gtk_timeout_remove (gint        tag);
 
-void       gtk_get_current_event (GdkEvent *event);
-GtkWidget* gtk_get_event_widget  (GdkEvent *event);
+void       gtk_get_current_event    (GdkEvent *event);
+GtkWidget* gtk_get_event_widget     (GdkEvent *event);
+gulong     gtk_get_coalesced_events (void);
+
+void gtk_set_double_buffer (gint double_buffer);
 
 
 /* Widget creation variables
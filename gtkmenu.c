@@ -1094,9 +1094,6 @@ gtk_menu_size_request (GtkWidget      *widget,
 
 	  if (GTK_WIDGET_VISIBLE (child))
 	    {
-	      child->requisition.width = 0;
-	      child->requisition.height = 0;
-
 	      gtk_widget_size_request (child, &child->requisition);
 
 	      requisition->width = MAX (requisition->width, child->requisition.width);
@@ -1738,9 +1735,6 @@ gtk_menu_bar_size_request (GtkWidget      *widget,
 
           if (GTK_WIDGET_VISIBLE (child))
             {
-              child->requisition.width = 0;
-              child->requisition.height = 0;
-
               gtk_widget_size_request (child, &child->requisition);
 
               requisition->width += child->requisition.width;
@@ -2222,9 +2216,6 @@ gtk_menu_item_size_request (GtkWidget      *widget,
     {
       gtk_menu_item_calc_accelerator_size (menu_item);
 
-      menu_item->child->requisition.width = 0;
-      menu_item->child->requisition.height = 0;
-
       gtk_widget_size_request (menu_item->child, &menu_item->child->requisition);
 
       requisition->width = (menu_item->child->requisition.width +
@@ -462,9 +462,6 @@ gtk_option_menu_size_request (GtkWidget      *widget,
 	}
       else if (option_menu->child)
         {
-          option_menu->child->requisition.width = 0;
-          option_menu->child->requisition.height = 0;
-
           gtk_widget_size_request (option_menu->child, &option_menu->child->requisition);
 
           requisition->width = (option_menu->child->requisition.width +
@@ -815,9 +812,6 @@ gtk_option_menu_calc_size (GtkWidget *widget)
 
       if (GTK_WIDGET_VISIBLE (menu_item))
 	{
-	  menu_item->requisition.width = 0;
-	  menu_item->requisition.height = 0;
-
 	  gtk_widget_size_request (menu_item, &menu_item->requisition);
 
 	  option_menu->width = MAX (option_menu->width, menu_item->requisition.width);
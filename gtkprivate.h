@@ -32,6 +32,12 @@ typedef void (*GtkWindowResizeHook) (GtkWidget *, gint *, gint *, gint *, gint *
 
 void gtk_window_set_resize_hook (GtkWidget           *widget,
 				 GtkWindowResizeHook  resize);
+void gtk_window_process_resizes (void);
+
+void gtk_scroll_queued_exposes (GdkWindow *window,
+				gint       dx,
+				gint       dy,
+				GdkRegion *invalid);
 
 void gtk_accelerator_table_install (GtkAcceleratorTable *table,
 				    GtkWidget           *widget,
@@ -51,6 +57,7 @@ extern GdkColor      gtk_default_selected_foreground;
 extern GdkColor      gtk_default_selected_background;
 extern gint          gtk_default_shadow_thickness;
 extern char         *gtk_default_font_name;
+extern gint          gtk_double_buffer;
 
 
 #ifdef __cplusplus
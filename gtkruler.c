@@ -412,6 +412,8 @@ gtk_ruler_draw_ticks (GtkWidget *widget)
   pixels_per_mark = ruler->metric->pixels_per_unit * ruler->metric->mark_every_nth;
   text_height = widget->style->font->ascent + widget->style->font->descent;
 
+  gdk_draw_batch_begin ();
+
   switch (ruler->orientation)
     {
     case HORIZONTAL:
@@ -462,8 +464,6 @@ gtk_ruler_draw_ticks (GtkWidget *widget)
       cur = start;
       while (cur <= end)
 	{
-	  sprintf (unit_str, "%d", ROUND (cur * ruler->metric->mark_every_nth / subd_incr[0]));
-
 	  switch (ruler->orientation)
 	    {
 	    case HORIZONTAL:
@@ -472,11 +472,6 @@ gtk_ruler_draw_ticks (GtkWidget *widget)
 			     height + shadow_thickness,
 			     ROUND (cur) + shadow_thickness,
 			     height - length + shadow_thickness);
-	      if (!i)
-		gdk_draw_string (widget->window, gc,
-				 ROUND(cur) + shadow_thickness + 1,
-				 shadow_thickness + text_height - 1,
-				 unit_str);
 	      break;
 	    case VERTICAL:
 	      gdk_draw_line (widget->window, gc,
@@ -484,11 +479,6 @@ gtk_ruler_draw_ticks (GtkWidget *widget)
 			     ROUND (cur) + shadow_thickness,
 			     height + shadow_thickness,
 			     ROUND (cur) + shadow_thickness);
-	      if (!i)
-		gdk_draw_string (widget->window, gc,
-				 shadow_thickness + 1,
-				 ROUND(cur) + shadow_thickness + text_height + 1,
-				 unit_str);
 	      break;
 	    default:
 	      g_error ("unknown ruler orientation");
@@ -500,6 +490,41 @@ gtk_ruler_draw_ticks (GtkWidget *widget)
 	}
     }
 
+  /* The labels are drawn after all of the ticks so that the
+   *  ticks go out as a single batch. Both use the same gc, so
+   *  the order doesn't change what ends up on the screen.
+   */
+  j = 0;
+  cur = start;
+  while (cur <= end)
+    {
+      sprintf (unit_str, "%d", ROUND (cur * ruler->metric->mark_every_nth / subd_incr[0]));
+
+      switch (ruler->orientation)
+	{
+	case HORIZONTAL:
+	  gdk_draw_string (widget->window, gc,
+			   ROUND(cur) + shadow_thickness + 1,
+			   shadow_thickness + text_height - 1,
+			   unit_str);
+	  break;
+	case VERTICAL:
+	  gdk_draw_string (widget->window, gc,
+			   shadow_thickness + 1,
+			   ROUND(cur) + shadow_thickness + text_height + 1,
+			   unit_str);
+	  break;
+	default:
+	  g_error ("unknown ruler orientation");
+	  break;
+	}
+
+      j++;
+      cur = start + j * subd_incr[0];
+    }
+
+  gdk_draw_batch_end ();
+
   g_function_leave ("gtk_ruler_draw_ticks");
 }
 
@@ -615,7 +640,7 @@ gtk_ruler_event (GtkWidget *widget,
       break;
 
     case GDK_MOTION_NOTIFY:
-      gdk_window_get_pointer (ruler->widget.window, &x, &y, NULL);
+      gdk_event_get_pointer (event, ruler->widget.window, &x, &y, NULL);
 
       switch (ruler->orientation)
 	{
@@ -60,6 +60,8 @@ struct _GtkScale
   gint16 in_child;
   gint16 click_child;
   gint16 click_point;
+  gint16 slider_origin_x;
+  gint16 slider_origin_y;
   guint32 timer;
 
   guint8 digits;
@@ -187,6 +189,8 @@ gtk_hscale_new (GtkDataAdjustment *adjustment)
   scale->in_child = NONE;
   scale->click_child = NONE;
   scale->click_point = 0;
+  scale->slider_origin_x = 0;
+  scale->slider_origin_y = 0;
   scale->timer = 0;
 
   scale->digits = 1;
@@ -234,6 +238,8 @@ gtk_vscale_new (GtkDataAdjustment *adjustment)
   scale->in_child = NONE;
   scale->click_child = NONE;
   scale->click_point = 0;
+  scale->slider_origin_x = 0;
+  scale->slider_origin_y = 0;
   scale->timer = 0;
 
   scale->digits = 1;
@@ -293,7 +299,8 @@ void gtk_scale_set_draw_value (GtkWidget *scale,
     {
       rscale->draw_value = draw_value;
 
-      if (GTK_WIDGET_VISIBLE (scale) && GTK_WIDGET_MAPPED (scale))
+      gtk_widget_invalidate_requisition (scale);
+      if (GTK_WIDGET_VISIBLE (scale) && scale->parent)
 	gtk_container_need_resize (scale->parent, scale);
     }
 
@@ -314,7 +321,8 @@ void gtk_scale_set_value_pos (GtkWidget *scale,
     {
       rscale->value_pos = value_pos;
 
-      if (GTK_WIDGET_VISIBLE (scale) && GTK_WIDGET_MAPPED (scale))
+      gtk_widget_invalidate_requisition (scale);
+      if (GTK_WIDGET_VISIBLE (scale) && scale->parent)
 	gtk_container_need_resize (scale->parent, scale);
     }
 
@@ -336,7 +344,8 @@ gtk_scale_set_digits (GtkWidget *scale,
     {
       rscale->digits = digits;
 
-      if (GTK_WIDGET_VISIBLE (scale) && GTK_WIDGET_MAPPED (scale))
+      gtk_widget_invalidate_requisition (scale);
+      if (GTK_WIDGET_VISIBLE (scale) && scale->parent)
 	gtk_container_need_resize (scale->parent, scale);
     }
 
@@ -641,7 +650,10 @@ gtk_scale_event (GtkWidget *widget,
     case GDK_MOTION_NOTIFY:
       if (scale->click_child == SLIDER)
 	{
-	  gdk_window_get_pointer (scale->slider, &x, &y, &mods);
+	  gdk_event_get_root_pointer (event, scale->slider,
+				      scale->slider_origin_x,
+				      scale->slider_origin_y,
+				      &x, &y, &mods);
 
 	  if (event->any.send_event || (event->motion.state & GDK_BUTTON1_MASK))
 	    {
@@ -667,6 +679,12 @@ gtk_scale_event (GtkWidget *widget,
 	  if (scale->click_child == SLIDER)
 	    {
 	      gtk_scale_draw_slider (widget);
+
+	      scale->slider_origin_x = (event->button.x_root - event->button.x -
+					scale->slider->x);
+	      scale->slider_origin_y = (event->button.y_root - event->button.y -
+					scale->slider->y);
+
 	      switch (scale->orientation)
 		{
 		case HORIZONTAL:
@@ -601,9 +601,6 @@ gtk_scrolled_area_size_request (GtkWidget      *widget,
     {
       if (scrolled_area->child)
 	{
-	  scrolled_area->child->requisition.width = 0;
-	  scrolled_area->child->requisition.height = 0;
-
 	  gtk_widget_size_request (scrolled_area->child, &scrolled_area->child->requisition);
 	}
 
@@ -1094,20 +1091,11 @@ gtk_scrolled_window_size_request (GtkWidget      *widget,
 
   if (GTK_WIDGET_VISIBLE (widget))
     {
-      scrolled_win->frame->requisition.width = 0;
-      scrolled_win->frame->requisition.height = 0;
-
       gtk_widget_size_request (scrolled_win->frame, &scrolled_win->frame->requisition);
 
       requisition->width = scrolled_win->frame->requisition.width;
       requisition->height = scrolled_win->frame->requisition.height;
 
-      scrolled_win->hscrollbar->requisition.width = 0;
-      scrolled_win->hscrollbar->requisition.height = 0;
-
-      scrolled_win->vscrollbar->requisition.width = 0;
-      scrolled_win->vscrollbar->requisition.height = 0;
-
       extra_width = 0;
       extra_height = 0;
 
@@ -1118,6 +1106,11 @@ gtk_scrolled_window_size_request (GtkWidget      *widget,
 
 	  extra_height = 5;
 	}
+      else
+	{
+	  scrolled_win->hscrollbar->requisition.width = 0;
+	  scrolled_win->hscrollbar->requisition.height = 0;
+	}
 
       if (GTK_WIDGET_VISIBLE (scrolled_win->vscrollbar))
 	{
@@ -1126,6 +1119,11 @@ gtk_scrolled_window_size_request (GtkWidget      *widget,
 
 	  extra_width = 5;
 	}
+      else
+	{
+	  scrolled_win->vscrollbar->requisition.width = 0;
+	  scrolled_win->vscrollbar->requisition.height = 0;
+	}
 
       requisition->width = MAX (requisition->width, scrolled_win->hscrollbar->requisition.width);
       requisition->height = MAX (requisition->height, scrolled_win->vscrollbar->requisition.height);
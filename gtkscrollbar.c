@@ -67,6 +67,8 @@ struct _GtkScrollBar
   gint16 in_child;
   gint16 click_child;
   gint16 click_point;
+  gint16 slider_origin_x;
+  gint16 slider_origin_y;
   gint16 scroll_type;
   guint32 timer;
 
@@ -196,6 +198,8 @@ gtk_hscrollbar_new (GtkDataAdjustment *adjustment)
   scrollbar->in_child = NONE;
   scrollbar->click_child = NONE;
   scrollbar->click_point = 0;
+  scrollbar->slider_origin_x = 0;
+  scrollbar->slider_origin_y = 0;
   scrollbar->scroll_type = SCROLL_NONE;
   scrollbar->timer = 0;
 
@@ -243,6 +247,8 @@ gtk_vscrollbar_new (GtkDataAdjustment *adjustment)
   scrollbar->in_child = NONE;
   scrollbar->click_child = NONE;
   scrollbar->click_point = 0;
+  scrollbar->slider_origin_x = 0;
+  scrollbar->slider_origin_y = 0;
   scrollbar->scroll_type = SCROLL_NONE;
   scrollbar->timer = 0;
 
@@ -651,7 +657,10 @@ gtk_scrollbar_event (GtkWidget *widget,
     case GDK_MOTION_NOTIFY:
       if (scrollbar->click_child == SLIDER)
 	{
-	  gdk_window_get_pointer (scrollbar->slider, &x, &y, &mods);
+	  gdk_event_get_root_pointer (event, scrollbar->slider,
+				      scrollbar->slider_origin_x,
+				      scrollbar->slider_origin_y,
+				      &x, &y, &mods);
 	  if (mods & GDK_BUTTON1_MASK)
 	    {
 	      switch (scrollbar->orientation)
@@ -699,6 +708,12 @@ gtk_scrollbar_event (GtkWidget *widget,
 	  else if (scrollbar->click_child == SLIDER)
 	    {
 	      gtk_scrollbar_draw_slider (widget);
+
+	      scrollbar->slider_origin_x = (event->button.x_root - event->button.x -
+					    scrollbar->slider->x);
+	      scrollbar->slider_origin_y = (event->button.y_root - event->button.y -
+					    scrollbar->slider->y);
+
 	      switch (scrollbar->orientation)
 		{
 		case HORIZONTAL:
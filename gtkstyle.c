@@ -21,7 +21,16 @@
 
 
 #define DEFAULT_FONT     "-Adobe-Helvetica-Medium-R-Normal--*-120-*-*-*-*-*-*"
-#define HASH_TABLE_SIZE  127
+
+
+typedef struct _GtkStyleEntry  GtkStyleEntry;
+
+struct _GtkStyleEntry
+{
+  GtkStyle *style;
+  guint hash;
+  guint val_hash;
+};
 
 
 static void      gtk_styles_init         (void);
@@ -35,10 +44,22 @@ static GtkStyle* gtk_style_new_with_vals (GdkColor    *foreground,
 					  GdkColormap *colormap);
 static void      gtk_style_add           (GtkStyle    *style);
 static void      gtk_style_remove        (GtkStyle    *style);
-static gint      gtk_style_hash          (GdkColor    *foreground,
+static guint     gtk_style_hash          (GdkColor    *foreground,
 					  GdkColor    *background,
 					  GdkFont     *font,
 					  gint         shadow_thickness);
+static guint     gtk_style_hash_pointer  (GtkStyle    *style);
+static void      gtk_style_table_insert  (GtkStyleEntry **table,
+					  guint        *size,
+					  guint        *count,
+					  GtkStyle     *style,
+					  guint         hash,
+					  guint         val_hash);
+static gint      gtk_style_table_remove  (GtkStyleEntry  *table,
+					  guint         size,
+					  guint        *count,
+					  GtkStyle     *style,
+					  guint         hash);
 static GtkStyle* gtk_style_find_by_value (GdkColor    *foreground,
 					  GdkColor    *background,
 					  GdkColor    *highlight,
@@ -67,8 +88,25 @@ static const gdouble prelight_mult    = 1.1;
 static const gdouble highlight_mult   = 1.3;
 static const gdouble shadow_mult      = 0.7;
 
-static GList *val_hash_table[HASH_TABLE_SIZE];
-static GList *style_hash_table[HASH_TABLE_SIZE];
+/* Styles are found by their values in "val_table". Several
+ *  styles can have the same values if they are attached to
+ *  different colormaps, and the colors of a style change when
+ *  they are allocated, so each style's value hash is kept in
+ *  the entries and in the reverse index "style_table" which is
+ *  keyed by the style pointer. Both are open addressing hash
+ *  tables with linear probing whose size is a power of 2.
+ */
+static GtkStyleEntry *val_table = NULL;
+static guint val_table_size = 0;
+static guint val_table_count = 0;
+static GtkStyleEntry *style_table = NULL;
+static guint style_table_size = 0;
+static guint style_table_count = 0;
+
+static gulong style_cache_hits = 0;
+static gulong style_cache_misses = 0;
+static gulong style_cache_collisions = 0;
+
 static int initialized = 0;
 
 
@@ -210,6 +248,7 @@ GtkStyle*
 gtk_style_attach (GtkStyle  *style,
 		  GdkWindow *window)
 {
+  gint nallocated;
   gint i;
 
   g_function_enter ("gtk_style_attach");
@@ -246,17 +285,15 @@ gtk_style_attach (GtkStyle  *style,
 
   if (style->attach_count == 1)
     {
+      nallocated = gdk_color_alloc_many (window->colormap, style->foreground, 5);
+      nallocated += gdk_color_alloc_many (window->colormap, style->background, 5);
+      nallocated += gdk_color_alloc_many (window->colormap, style->highlight, 5);
+      nallocated += gdk_color_alloc_many (window->colormap, style->shadow, 5);
+      if (nallocated != 20)
+	g_message ("color allocation failed");
+
       for (i = 0; i < 5; i++)
 	{
-	  if (!gdk_color_alloc (window->colormap, &style->foreground[i]))
-	    g_message ("color allocation failed");
-	  if (!gdk_color_alloc (window->colormap, &style->background[i]))
-	    g_message ("color allocation failed");
-	  if (!gdk_color_alloc (window->colormap, &style->highlight[i]))
-	    g_message ("color allocation failed");
-	  if (!gdk_color_alloc (window->colormap, &style->shadow[i]))
-	    g_message ("color allocation failed");
-
 	  style->foreground_gc[i] = gtk_gc_get (window, &style->foreground[i], NULL, style->font,
 						GDK_COPY, GDK_SOLID, NULL, NULL,
 						GDK_CLIP_BY_CHILDREN, TRUE);
@@ -330,19 +367,48 @@ gtk_style_unref (GtkStyle *style)
   g_function_leave ("gtk_style_unref");
 }
 
+/*
+ * Print the number of styles, the load factor of the value
+ *  table and how often lookups hit, missed and had to step
+ *  over other styles.
+ */
+void
+gtk_style_info ()
+{
+  g_function_enter ("gtk_style_info");
+
+  g_message ("style cache: %d styles in %d slots (load factor %.2f)",
+	     val_table_count, val_table_size,
+	     (val_table_size) ? ((gdouble) val_table_count / val_table_size) : 0.0);
+  g_message ("style cache: %ld hits, %ld misses, %ld collisions",
+	     style_cache_hits, style_cache_misses, style_cache_collisions);
+
+  g_function_leave ("gtk_style_info");
+}
+
+void
+gtk_style_get_stats (gulong *hits,
+		     gulong *misses,
+		     gulong *collisions)
+{
+  g_function_enter ("gtk_style_get_stats");
+
+  if (hits)
+    *hits = style_cache_hits;
+  if (misses)
+    *misses = style_cache_misses;
+  if (collisions)
+    *collisions = style_cache_collisions;
+
+  g_function_leave ("gtk_style_get_stats");
+}
+
 
 static void
 gtk_styles_init ()
 {
-  gint i;
-
   g_function_enter ("gtk_styles_init");
 
-  for (i = 0; i < HASH_TABLE_SIZE; i++)
-    {
-      val_hash_table[i] = NULL;
-      style_hash_table[i] = NULL;
-    }
   initialized = 1;
 
   g_function_leave ("gtk_styles_init");
@@ -367,8 +433,12 @@ gtk_style_new_with_vals (GdkColor    *foreground,
 				   shadow, font, shadow_thickness,
 				   depth, colormap);
 
-  if (!style)
+  if (style)
+    style_cache_hits += 1;
+  else
     {
+      style_cache_misses += 1;
+
       style = g_new (GtkStyle, 1);
       /*      g_message ("allocating a new style"); */
 
@@ -414,18 +484,19 @@ gtk_style_new_with_vals (GdkColor    *foreground,
 static void
 gtk_style_add (GtkStyle *style)
 {
-  gint hash_val;
+  guint val_hash;
 
   g_function_enter ("gtk_style_add");
 
   g_assert (style != NULL);
 
-  hash_val = gtk_style_hash (style->foreground, style->background,
-			     style->font, style->shadow_thickness) % HASH_TABLE_SIZE;
-  val_hash_table[hash_val] = g_list_prepend (val_hash_table[hash_val], style);
+  val_hash = gtk_style_hash (style->foreground, style->background,
+			     style->font, style->shadow_thickness);
 
-  hash_val = ((gint) style) % HASH_TABLE_SIZE;
-  style_hash_table[hash_val] = g_list_prepend (style_hash_table[hash_val], style);
+  gtk_style_table_insert (&val_table, &val_table_size, &val_table_count,
+			  style, val_hash, val_hash);
+  gtk_style_table_insert (&style_table, &style_table_size, &style_table_count,
+			  style, gtk_style_hash_pointer (style), val_hash);
 
   g_function_leave ("gtk_style_add");
 }
@@ -433,48 +504,178 @@ gtk_style_add (GtkStyle *style)
 static void
 gtk_style_remove (GtkStyle *style)
 {
-  gint hash_val;
+  GtkStyleEntry *entry;
+  guint index;
 
-  g_function_enter ("gtk_style_add");
+  g_function_enter ("gtk_style_remove");
 
   g_assert (style != NULL);
 
-  hash_val = gtk_style_hash (style->foreground, style->background,
-			     style->font, style->shadow_thickness) % HASH_TABLE_SIZE;
-  val_hash_table[hash_val] = g_list_remove (val_hash_table[hash_val], style);
+  /* The style's colors may have changed since it was added,
+   *  so its value hash is taken from the reverse index.
+   */
+  entry = NULL;
+  if (style_table_count)
+    {
+      index = gtk_style_hash_pointer (style) & (style_table_size - 1);
+      while (style_table[index].style && (style_table[index].style != style))
+	index = (index + 1) & (style_table_size - 1);
 
-  hash_val = ((gint) style) % HASH_TABLE_SIZE;
-  style_hash_table[hash_val] = g_list_remove (style_hash_table[hash_val], style);
+      if (style_table[index].style)
+	entry = &style_table[index];
+    }
 
-  g_function_leave ("gtk_style_add");
+  if (entry)
+    {
+      gtk_style_table_remove (val_table, val_table_size, &val_table_count,
+			      style, entry->val_hash);
+      gtk_style_table_remove (style_table, style_table_size, &style_table_count,
+			      style, entry->hash);
+    }
+
+  g_function_leave ("gtk_style_remove");
 }
 
-static gint
+static guint
 gtk_style_hash (GdkColor    *foreground,
 		GdkColor    *background,
 		GdkFont     *font,
 		gint         shadow_thickness)
 {
-  gint hash_value;
+  guint64 key;
   gint i;
 
   g_function_enter ("gtk_style_hash");
 
-  hash_value = 0;
+  /* Fold in the values one at a time, multiplying in between
+   *  so that the order matters, then mix the result.
+   */
+  key = shadow_thickness;
+  key = key * 0x9e3779b97f4a7c15ULL + (gulong) font;
 
   if (foreground)
     for (i = 0; i < 5; i++)
-      hash_value += foreground[i].red + foreground[i].green + foreground[i].blue;
+      key = (key * 0x9e3779b97f4a7c15ULL +
+	     (((guint64) foreground[i].red << 32) |
+	      ((guint64) foreground[i].green << 16) |
+	      ((guint64) foreground[i].blue)));
 
   if (background)
     for (i = 0; i < 5; i++)
-      hash_value += background[i].red + background[i].green + background[i].blue;
+      key = (key * 0x9e3779b97f4a7c15ULL +
+	     (((guint64) background[i].red << 32) |
+	      ((guint64) background[i].green << 16) |
+	      ((guint64) background[i].blue)));
 
-  hash_value += (gint) font;
-  hash_value += shadow_thickness;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
 
   g_function_leave ("gtk_style_hash");
-  return hash_value;
+  return (guint) key;
+}
+
+static guint
+gtk_style_hash_pointer (GtkStyle *style)
+{
+  guint64 key;
+
+  key = (gulong) style;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+
+  return (guint) key;
+}
+
+static void
+gtk_style_table_insert (GtkStyleEntry **table,
+			guint          *size,
+			guint          *count,
+			GtkStyle       *style,
+			guint           hash,
+			guint           val_hash)
+{
+  GtkStyleEntry *old_table;
+  guint old_size;
+  guint index;
+  guint i;
+
+  if ((*count + 1) * 2 > *size)
+    {
+      old_table = *table;
+      old_size = *size;
+
+      *size = (old_size) ? (old_size * 2) : 64;
+      *table = g_new (GtkStyleEntry, *size);
+      for (i = 0; i < *size; i++)
+	(*table)[i].style = NULL;
+
+      for (i = 0; i < old_size; i++)
+	if (old_table[i].style)
+	  {
+	    index = old_table[i].hash & (*size - 1);
+	    while ((*table)[index].style)
+	      index = (index + 1) & (*size - 1);
+	    (*table)[index] = old_table[i];
+	  }
+
+      if (old_table)
+	g_free (old_table);
+    }
+
+  index = hash & (*size - 1);
+  while ((*table)[index].style)
+    index = (index + 1) & (*size - 1);
+
+  (*table)[index].style = style;
+  (*table)[index].hash = hash;
+  (*table)[index].val_hash = val_hash;
+  *count += 1;
+}
+
+static gint
+gtk_style_table_remove (GtkStyleEntry *table,
+			guint          size,
+			guint         *count,
+			GtkStyle      *style,
+			guint          hash)
+{
+  guint index;
+  guint next;
+  guint home;
+
+  if (!*count)
+    return FALSE;
+
+  index = hash & (size - 1);
+  while (table[index].style && (table[index].style != style))
+    index = (index + 1) & (size - 1);
+
+  if (!table[index].style)
+    return FALSE;
+
+  next = index;
+  while (1)
+    {
+      next = (next + 1) & (size - 1);
+      if (!table[next].style)
+	break;
+
+      home = table[next].hash & (size - 1);
+      if (((next - home) & (size - 1)) >= ((next - index) & (size - 1)))
+	{
+	  table[index] = table[next];
+	  index = next;
+	}
+    }
+
+  table[index].style = NULL;
+  *count -= 1;
+
+  return TRUE;
 }
 
 static GtkStyle*
@@ -487,26 +688,32 @@ gtk_style_find_by_value (GdkColor    *foreground,
 			 gint         depth,
 			 GdkColormap *colormap)
 {
-  GList *temp_list;
   GtkStyle *style;
-  gint hash_val;
+  guint hash;
+  guint index;
 
   g_function_enter ("gtk_style_find_by_value");
 
-  hash_val = gtk_style_hash (foreground, background, font, shadow_thickness) % HASH_TABLE_SIZE;
-  temp_list = val_hash_table[hash_val];
   style = NULL;
 
-  while (temp_list)
+  if (val_table_count)
     {
-      style = temp_list->data;
-      temp_list = temp_list->next;
+      hash = gtk_style_hash (foreground, background, font, shadow_thickness);
 
-      if (gtk_style_compare (style, foreground, background, highlight,
-			     shadow, font, shadow_thickness, depth, colormap))
-	break;
-
-      style = NULL;
+      index = hash & (val_table_size - 1);
+      while (val_table[index].style)
+	{
+	  if ((val_table[index].hash == hash) &&
+	      gtk_style_compare (val_table[index].style, foreground, background, highlight,
+				 shadow, font, shadow_thickness, depth, colormap))
+	    {
+	      style = val_table[index].style;
+	      break;
+	    }
+
+	  style_cache_collisions += 1;
+	  index = (index + 1) & (val_table_size - 1);
+	}
     }
 
   g_function_leave ("gtk_style_find_by_value");
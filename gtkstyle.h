@@ -22,6 +22,11 @@ void      gtk_style_detach  (GtkStyle   *style);
 void      gtk_style_ref     (GtkStyle   *style);
 void      gtk_style_unref   (GtkStyle   *style);
 
+void      gtk_style_info      (void);
+void      gtk_style_get_stats (gulong     *hits,
+			       gulong     *misses,
+			       gulong     *collisions);
+
 
 #ifdef __cplusplus
 }
@@ -252,7 +252,7 @@ gtk_table_set_row_spacing (GtkWidget *table,
 {
   GtkTable *rtable;
 
-  g_function_leave ("gtk_table_set_row_spacing");
+  g_function_enter ("gtk_table_set_row_spacing");
 
   g_assert (table != NULL);
   rtable = (GtkTable*) table;
@@ -263,7 +263,8 @@ gtk_table_set_row_spacing (GtkWidget *table,
     {
       rtable->rows[row].spacing = spacing;
 
-      if (GTK_WIDGET_VISIBLE (table) && GTK_WIDGET_MAPPED (table))
+      gtk_widget_invalidate_requisition (table);
+      if (GTK_WIDGET_VISIBLE (table) && table->parent)
         gtk_container_need_resize (table->parent, table);
     }
 
@@ -277,7 +278,7 @@ gtk_table_set_col_spacing (GtkWidget *table,
 {
   GtkTable *rtable;
 
-  g_function_leave ("gtk_table_set_col_spacing");
+  g_function_enter ("gtk_table_set_col_spacing");
 
   g_assert (table != NULL);
   rtable = (GtkTable*) table;
@@ -288,7 +289,8 @@ gtk_table_set_col_spacing (GtkWidget *table,
     {
       rtable->cols[col].spacing = spacing;
 
-      if (GTK_WIDGET_VISIBLE (table) && GTK_WIDGET_MAPPED (table))
+      gtk_widget_invalidate_requisition (table);
+      if (GTK_WIDGET_VISIBLE (table) && table->parent)
         gtk_container_need_resize (table->parent, table);
     }
 
@@ -720,9 +722,6 @@ gtk_table_size_request_init (GtkTable *table)
 
       if (GTK_WIDGET_VISIBLE (child->widget))
 	{
-	  child->widget->requisition.width = 0;
-	  child->widget->requisition.height = 0;
-
 	  gtk_widget_size_request (child->widget, &child->widget->requisition);
 	}
     }
@@ -53,6 +53,7 @@
 #define GTK_CAN_DEFAULT       0x0800
 #define GTK_IN_CALL           0x1000
 #define GTK_NEED_DESTROY      0x2000
+#define GTK_REQUISITION_VALID 0x4000
 
 /* A few macros for accessing the type and flags members of
  *  the widget structure.
@@ -76,6 +77,7 @@
 #define GTK_WIDGET_CAN_DEFAULT(obj)       (GTK_WIDGET_FLAGS (obj) & GTK_CAN_DEFAULT)
 #define GTK_WIDGET_IN_CALL(obj)           (GTK_WIDGET_FLAGS (obj) & GTK_IN_CALL)
 #define GTK_WIDGET_NEED_DESTROY(obj)      (GTK_WIDGET_FLAGS (obj) & GTK_NEED_DESTROY)
+#define GTK_WIDGET_REQUISITION_VALID(obj) (GTK_WIDGET_FLAGS (obj) & GTK_REQUISITION_VALID)
 
 /* Two macros for setting and unsetting flags.
  */
@@ -309,7 +311,9 @@ struct _GtkWidget
    */
   GtkContainer *parent;
 
-  /* The widgets requested size.
+  /* The widgets requested size. This is only recomputed
+   *  when the GTK_REQUISITION_VALID flag has been cleared
+   *  (see "gtk_widget_invalidate_requisition").
    */
   GtkRequisition requisition;
 
@@ -94,6 +94,7 @@ gtk_widget_show (GtkWidget *widget)
       old_value = GTK_WIDGET_IN_CALL (widget);
       GTK_WIDGET_SET_FLAGS (widget, GTK_IN_CALL);
 
+      gtk_widget_invalidate_requisition (widget);
       (* widget->function_table->show) (widget);
 
       if (!old_value)
@@ -122,6 +123,7 @@ gtk_widget_hide (GtkWidget *widget)
       old_value = GTK_WIDGET_IN_CALL (widget);
       GTK_WIDGET_SET_FLAGS (widget, GTK_IN_CALL);
 
+      gtk_widget_invalidate_requisition (widget);
       (* widget->function_table->hide) (widget);
 
       if (!old_value)
@@ -237,6 +239,7 @@ gtk_widget_draw (GtkWidget    *widget,
 {
   GdkRectangle temp_area;
   gint old_value;
+  gint double_buffer;
 
   g_function_enter ("gtk_widget_draw");
 
@@ -258,10 +261,27 @@ gtk_widget_draw (GtkWidget    *widget,
 	  area = &temp_area;
 	}
 
+      /* Widgets without a window draw into their parent's
+       *  window, which is painted by the parent if it is
+       *  being drawn.
+       */
+      double_buffer = (gtk_double_buffer &&
+		       !GTK_WIDGET_NO_WINDOW (widget) &&
+		       GTK_WIDGET_REALIZED (widget) &&
+		       widget->window);
+
+      if (double_buffer)
+	gdk_window_begin_paint (widget->window, area);
+      gdk_draw_batch_begin ();
+
       (* widget->function_table->draw) (widget, area, is_expose);
 
       gtk_widget_draw_focus (widget);
 
+      gdk_draw_batch_end ();
+      if (double_buffer)
+	gdk_window_end_paint (widget->window);
+
       if (!old_value)
 	GTK_WIDGET_UNSET_FLAGS (widget, GTK_IN_CALL);
     }
@@ -343,11 +363,22 @@ gtk_widget_size_request (GtkWidget      *widget,
   g_assert (widget->function_table);
   g_assert (widget->function_table->size_request);
 
-  if (!GTK_WIDGET_NEED_DESTROY (widget))
+  /* The requisition of a widget is cached in "widget->requisition"
+   *  and only recomputed when something has invalidated it.
+   */
+  if (GTK_WIDGET_REQUISITION_VALID (widget))
+    {
+      if (requisition != &widget->requisition)
+	*requisition = widget->requisition;
+    }
+  else if (!GTK_WIDGET_NEED_DESTROY (widget))
     {
       old_value = GTK_WIDGET_IN_CALL (widget);
       GTK_WIDGET_SET_FLAGS (widget, GTK_IN_CALL);
 
+      requisition->width = 0;
+      requisition->height = 0;
+
       (* widget->function_table->size_request) (widget, requisition);
 
       if (widget->user_allocation.width > 0)
@@ -355,6 +386,10 @@ gtk_widget_size_request (GtkWidget      *widget,
       if (widget->user_allocation.height > 0)
 	requisition->height = widget->user_allocation.height;
 
+      if (requisition != &widget->requisition)
+	widget->requisition = *requisition;
+      GTK_WIDGET_SET_FLAGS (widget, GTK_REQUISITION_VALID);
+
       if (!old_value)
 	GTK_WIDGET_UNSET_FLAGS (widget, GTK_IN_CALL);
     }
@@ -808,12 +843,33 @@ gtk_widget_set_usize (GtkWidget *widget,
   widget->user_allocation.width = width;
   widget->user_allocation.height = height;
 
+  gtk_widget_invalidate_requisition (widget);
   if (GTK_WIDGET_VISIBLE (widget) && widget->parent)
     gtk_container_need_resize (widget->parent, widget);
 
   g_function_leave ("gtk_widget_set_usize");
 }
 
+void
+gtk_widget_invalidate_requisition (GtkWidget *widget)
+{
+  g_function_enter ("gtk_widget_invalidate_requisition");
+
+  g_assert (widget != NULL);
+
+  /* A containers requisition depends on the requisitions of
+   *  its children. So the requisitions of all of the ancestors
+   *  are invalidated as well.
+   */
+  while (widget)
+    {
+      GTK_WIDGET_UNSET_FLAGS (widget, GTK_REQUISITION_VALID);
+      widget = (GtkWidget*) widget->parent;
+    }
+
+  g_function_leave ("gtk_widget_invalidate_requisition");
+}
+
 void
 gtk_widget_set_defaults (GtkWidget *widget)
 {
@@ -861,6 +917,7 @@ gtk_widget_set_style (GtkWidget *widget,
       if (GTK_WIDGET_REALIZED (widget))
 	widget->style = gtk_style_attach (widget->style, widget->window);
 
+      gtk_widget_invalidate_requisition (widget);
       gtk_widget_draw (widget, NULL, FALSE);
     }
 
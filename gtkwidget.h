@@ -70,6 +70,7 @@ void  gtk_widget_set_uposition         (GtkWidget           *widget,
 void  gtk_widget_set_usize             (GtkWidget           *widget,
 					gint                 width,
 					gint                 height);
+void  gtk_widget_invalidate_requisition (GtkWidget          *widget);
 
 void       gtk_widget_set_defaults   (GtkWidget  *widget);
 void       gtk_widget_set_style      (GtkWidget  *widget,
@@ -37,6 +37,7 @@ struct _GtkWindow
   GtkWidget *focus_widget;
   GtkWidget *default_widget;
   gint need_resize;
+  gint resize_queued;
 
   GList *accelerator_tables;
 
@@ -75,12 +76,15 @@ static void  gtk_window_foreach       (GtkContainer    *container,
 				       GtkCallback      callback,
 				       gpointer         callback_data);
 static void  gtk_window_resize        (GtkWindow       *window);
+static void  gtk_window_queue_resize  (GtkWindow       *window);
 
 static gint  gtk_window_check_accelerator (GtkWindow  *window,
 					   gchar       accelerator_key,
 					   guint8      accelerator_mods);
 
 
+static GList *resize_queue = NULL;
+
 static GtkWidgetFunctions window_widget_functions =
 {
   gtk_window_destroy,
@@ -137,6 +141,7 @@ gtk_window_new (gchar         *title,
   window->focus_widget = NULL;
   window->default_widget = NULL;
   window->need_resize = FALSE;
+  window->resize_queued = FALSE;
   window->accelerator_tables = NULL;
   window->resize = NULL;
 
@@ -271,6 +276,9 @@ gtk_window_destroy (GtkWidget *widget)
     }
   g_list_free (window->accelerator_tables);
 
+  if (window->resize_queued)
+    resize_queue = g_list_remove (resize_queue, window);
+
   if (window->child)
     if (!gtk_widget_destroy (window->child))
       window->child->parent = NULL;
@@ -658,9 +666,6 @@ gtk_window_size_request (GtkWidget      *widget,
 
       if (window->child)
 	{
-	  window->child->requisition.width = 0;
-	  window->child->requisition.height = 0;
-
 	  gtk_widget_size_request (window->child, &window->child->requisition);
 
 	  requisition->width = MAX (requisition->width,
@@ -791,7 +796,7 @@ gtk_window_add (GtkContainer *container,
       if (GTK_WIDGET_VISIBLE (window->child))
 	{
 	  window->need_resize = TRUE;
-	  gtk_window_resize (window);
+	  gtk_window_queue_resize (window);
 	}
     }
 
@@ -824,7 +829,7 @@ gtk_window_remove (GtkContainer *container,
       gtk_widget_hide (widget);
 
       window->need_resize = TRUE;
-      gtk_window_resize (window);
+      gtk_window_queue_resize (window);
     }
 
   g_function_leave ("gtk_window_remove");
@@ -849,7 +854,7 @@ gtk_window_need_resize (GtkContainer *container,
   window->need_resize = TRUE;
   if (GTK_WIDGET_VISIBLE (container))
     {
-      gtk_window_resize (window);
+      gtk_window_queue_resize (window);
 
       if (GTK_WIDGET_VISIBLE (widget))
 	{
@@ -905,9 +910,6 @@ gtk_window_resize (GtkWindow *window)
 
       window_widget = (GtkWidget*) window;
 
-      window_widget->requisition.width = 0;
-      window_widget->requisition.height = 0;
-
       gtk_widget_size_request (window_widget, &window_widget->requisition);
 
       x = -1;
@@ -944,6 +946,53 @@ gtk_window_resize (GtkWindow *window)
   g_function_leave ("gtk_window_resize");
 }
 
+/* Resizes are not performed when they are asked for. Instead
+ *  the window is placed on a queue and a single resize is done
+ *  for each window on the queue before "gtk_main_iteration"
+ *  waits for the next event. Adding a large number of children
+ *  to a container therefore only causes one layout of the
+ *  window.
+ */
+static void
+gtk_window_queue_resize (GtkWindow *window)
+{
+  g_function_enter ("gtk_window_queue_resize");
+
+  g_assert (window != NULL);
+
+  if (!window->resize_queued)
+    {
+      window->resize_queued = TRUE;
+      resize_queue = g_list_prepend (resize_queue, window);
+    }
+
+  g_function_leave ("gtk_window_queue_resize");
+}
+
+void
+gtk_window_process_resizes ()
+{
+  GtkWindow *window;
+  GList *temp;
+
+  g_function_enter ("gtk_window_process_resizes");
+
+  while (resize_queue)
+    {
+      temp = resize_queue;
+      resize_queue = g_list_remove_link (resize_queue, temp);
+
+      window = temp->data;
+      g_list_free (temp);
+
+      window->resize_queued = FALSE;
+      if (GTK_WIDGET_VISIBLE (window))
+	gtk_window_resize (window);
+    }
+
+  g_function_leave ("gtk_window_process_resizes");
+}
+
 static gint
 gtk_window_check_accelerator (GtkWindow  *window,
 			      gchar       accelerator_key,
@@ -2,14 +2,45 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "glib.h"
 
 /* #define PRINT_TRACE */
 #define CALL_STACK_SIZE 1024
+#define PROFILE_RING_SIZE 65536
+
+typedef struct _GProfileRecord GProfileRecord;
+typedef struct _GProfileRing   GProfileRing;
+
+struct _GProfileRecord {
+  char *fname;
+  guint64 time;
+  gint enter;
+};
+
+/* One of these exists for each thread that enters a profiled
+ *  function. Once the ring is full the oldest records are
+ *  overwritten.
+ */
+struct _GProfileRing {
+  GProfileRecord records[PROFILE_RING_SIZE];
+  gulong index;
+  gint tid;
+  GProfileRing *next;
+};
 
 static char *call_stack[CALL_STACK_SIZE];
 static int call_stack_index = 0;
 
+static __thread GProfileRing *profile_ring = NULL;
+static GProfileRing *profile_rings = NULL;
+static volatile int profile_rings_lock = 0;
+static int profile_next_tid = 1;
+
+static GProfileRing* g_profile_ring_new (void);
+static void g_profile_record (char *fname, gint enter);
+static void g_profile_exit_func (void);
+
 gchar* g_strdup (gchar *str) {
   gchar *new_str;
 
@@ -125,3 +156,109 @@ void g_real_function_trace() {
     printf ("#%d: %s\n", i, call_stack[call_stack_index - i - 1]);
   }
 }
+
+void g_real_profile_enter(char *fname) {
+  g_profile_record(fname, TRUE);
+}
+
+void g_real_profile_leave(char *fname) {
+  g_profile_record(fname, FALSE);
+}
+
+gint g_profile_dump(char *filename) {
+  GProfileRing *ring;
+  GProfileRecord *record;
+  FILE *fp;
+  gulong first;
+  gulong i;
+  gint need_comma;
+  int pid;
+
+  fp = fopen(filename, "w");
+  if (!fp) {
+    g_warning("unable to open file \"%s\" for writing", filename);
+    return FALSE;
+  }
+
+  pid = getpid();
+  need_comma = FALSE;
+  fputs("{\"traceEvents\":[\n", fp);
+
+  while (__sync_lock_test_and_set(&profile_rings_lock, 1));
+  for (ring = profile_rings; ring; ring = ring->next) {
+    /* Write the records from oldest to newest. The index keeps
+     *  counting past the size of the ring so that we can tell
+     *  whether it has wrapped.
+     */
+    first = (ring->index > PROFILE_RING_SIZE) ? (ring->index - PROFILE_RING_SIZE) : 0;
+
+    for (i = first; i < ring->index; i++) {
+      record = &ring->records[i % PROFILE_RING_SIZE];
+
+      fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+              need_comma ? ",\n" : "", record->fname, record->enter ? 'B' : 'E',
+              record->time / 1000.0, pid, ring->tid);
+      need_comma = TRUE;
+    }
+  }
+  __sync_lock_release(&profile_rings_lock);
+
+  fputs("\n]}\n", fp);
+  fclose(fp);
+
+  return TRUE;
+}
+
+static GProfileRing* g_profile_ring_new() {
+  GProfileRing *ring;
+  gint first;
+
+  /* This can't use "g_malloc" since "g_malloc" is itself
+   *  profiled.
+   */
+  ring = calloc(1, sizeof (GProfileRing));
+  if (!ring) {
+    fputs("\n** ERROR **: could not allocate profile ring\n", stderr);
+    exit(1);
+  }
+
+  while (__sync_lock_test_and_set(&profile_rings_lock, 1));
+  ring->tid = profile_next_tid++;
+  first = (profile_rings == NULL);
+  ring->next = profile_rings;
+  profile_rings = ring;
+  __sync_lock_release(&profile_rings_lock);
+
+  if (first) {
+    atexit(g_profile_exit_func);
+  }
+
+  return ring;
+}
+
+/* Writes the profile out when the program exits if the
+ *  environment variable "G_PROFILE_FILE" names a file.
+ */
+static void g_profile_exit_func() {
+  char *filename;
+
+  filename = getenv("G_PROFILE_FILE");
+  if (filename && *filename) {
+    g_profile_dump(filename);
+  }
+}
+
+static void g_profile_record(char *fname, gint enter) {
+  GProfileRecord *record;
+
+  if (!profile_ring) {
+    profile_ring = g_profile_ring_new();
+  }
+
+  record = &profile_ring->records[profile_ring->index % PROFILE_RING_SIZE];
+  record->fname = fname;
+  record->time = g_time_monotonic_ns();
+  record->enter = enter;
+
+  profile_ring->index++;
+}